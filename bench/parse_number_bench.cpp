@@ -0,0 +1,91 @@
+// Time crab::parse_double() against std::stod(), which parsed every feed
+// price before it, over a corpus shaped like the prices the feeds send.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "parse_number.hpp"
+
+namespace {
+
+using Clock_t = std::chrono::steady_clock;
+
+/// Return \p count price strings, as Coinbase and Finnhub format them.
+[[nodiscard]] auto make_corpus(std::size_t count) -> std::vector<std::string>
+{
+    auto rng    = std::mt19937{42};
+    auto digits = std::uniform_int_distribution<int>{0, 8};
+    auto scale  = std::uniform_real_distribution<double>{-6., 5.};
+    auto result = std::vector<std::string>{};
+    result.reserve(count);
+    char buffer[64];
+    for (auto i = std::size_t{0}; i < count; ++i) {
+        auto const price = std::pow(10., scale(rng));
+        switch (i % 4) {
+            case 0:  // Coinbase, fixed decimals.
+            case 1:
+                std::snprintf(buffer, sizeof(buffer), "%.*f", digits(rng),
+                              price);
+                break;
+            case 2:  // Finnhub JSON number, shortest form.
+                std::snprintf(buffer, sizeof(buffer), "%.10g", price);
+                break;
+            default:  // Stock prices in cents.
+                std::snprintf(buffer, sizeof(buffer), "%.2f", price * 100.);
+        }
+        result.emplace_back(buffer);
+    }
+    return result;
+}
+
+/// Return the fastest of \p runs passes of \p parse over \p corpus, in ns.
+template <typename F>
+auto fastest_ns(int runs, std::vector<std::string> const& corpus, F&& parse)
+    -> double
+{
+    auto best = std::chrono::nanoseconds::max();
+    auto sum  = 0.;
+    for (auto i = 0; i < runs; ++i) {
+        auto const start = Clock_t::now();
+        for (auto const& x : corpus)
+            sum += parse(x);
+        auto const took = Clock_t::now() - start;
+        best            = std::min(
+            best, std::chrono::duration_cast<std::chrono::nanoseconds>(took));
+    }
+    if (sum == 0.)
+        std::printf("unexpected zero sum\n");  // Keeps the loop alive.
+    return static_cast<double>(best.count());
+}
+
+}  // namespace
+
+int main()
+{
+    auto const corpus = make_corpus(1'000'000);
+    auto const parse  = fastest_ns(10, corpus, [](std::string const& x) {
+        return crab::parse_double(x).value_or(0.);
+    });
+    auto const stod = fastest_ns(10, corpus, [](std::string const& x) {
+        try {
+            return std::stod(x);
+        }
+        catch (std::logic_error const&) {
+            return 0.;
+        }
+    });
+    auto const n     = static_cast<double>(corpus.size());
+    auto const print = [n](char const* name, double ns) {
+        std::printf("%-13s %6.1f ns/price %7.1f M prices/s\n", name, ns / n,
+                    n / ns * 1'000.);
+    };
+    print("parse_double", parse);
+    print("std::stod", stod);
+    std::printf("speed-up      %6.2fx\n", stod / parse);
+}
@@ -0,0 +1,111 @@
+// Time a drained batch of prices applied to the book at once, as
+// Ticker_list::update_tickers() does, against applying them one price at a
+// time with a rescan of the quote's totals after each.
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "position_book.hpp"
+
+namespace {
+
+using Clock_t = std::chrono::steady_clock;
+
+auto constexpr quote_count = std::size_t{4};
+
+/// Return the fastest of \p runs timings of \p f, in nanoseconds.
+template <typename F>
+auto fastest_ns(int runs, F&& f) -> double
+{
+    auto best = std::chrono::nanoseconds::max();
+    for (auto i = 0; i < runs; ++i) {
+        auto const start = Clock_t::now();
+        f();
+        auto const took = Clock_t::now() - start;
+        best            = std::min(
+            best, std::chrono::duration_cast<std::chrono::nanoseconds>(took));
+    }
+    return static_cast<double>(best.count());
+}
+
+/// Sum the rows of a single quote, as the totals were before they were kept.
+auto scan(crab::Position_book const& book,
+          std::vector<crab::Position_id> const& quote_ids)
+    -> crab::Position_totals
+{
+    auto totals = crab::Position_totals{};
+    for (auto const id : quote_ids)
+        book.add_to(totals, id);
+    return totals;
+}
+
+}  // namespace
+
+int main()
+{
+    auto rng   = std::mt19937{42};
+    auto price = std::uniform_real_distribution<double>{0.01, 50'000.};
+
+    auto const rows = std::size_t{50'000};
+    auto book       = crab::Position_book{};
+    auto ids        = std::vector<crab::Position_id>{};
+    auto by_quote   = std::vector<std::vector<crab::Position_id>>(quote_count);
+    for (auto i = std::size_t{0}; i < rows; ++i) {
+        auto const close = i % 16 == 0 ? 0. : price(rng);
+        ids.push_back(
+            book.add({price(rng) / 1'000., price(rng), price(rng), close}));
+        by_quote[i % quote_count].push_back(ids.back());
+    }
+    auto totals = std::vector<crab::Position_totals>(quote_count);
+    book.recompute();
+    for (auto q = std::size_t{0}; q < quote_count; ++q)
+        totals[q] = scan(book, by_quote[q]);
+
+    auto sink = 0.;  // Keeps the totals from being optimized away.
+    for (auto const batch : {std::size_t{10}, std::size_t{100},
+                             std::size_t{1'000}, std::size_t{10'000}}) {
+        auto rows_in_batch = std::vector<std::size_t>{};
+        auto pick = std::uniform_int_distribution<std::size_t>{0, rows - 1};
+        for (auto i = std::size_t{0}; i < batch; ++i)
+            rows_in_batch.push_back(pick(rng));
+        std::sort(rows_in_batch.begin(), rows_in_batch.end());
+        rows_in_batch.erase(
+            std::unique(rows_in_batch.begin(), rows_in_batch.end()),
+            rows_in_batch.end());
+        auto batch_ids = std::vector<crab::Position_id>{};
+        for (auto const r : rows_in_batch)
+            batch_ids.push_back(ids[r]);
+
+        auto const runs = std::max(3, static_cast<int>(20'000 / batch));
+        auto const each = fastest_ns(runs, [&] {
+            for (auto const r : rows_in_batch) {
+                book.set_last_price(ids[r], price(rng));
+                book.recompute(ids[r]);
+                sink += scan(book, by_quote[r % quote_count]).value;
+            }
+        });
+        auto const batched = fastest_ns(runs, [&] {
+            auto touched = std::vector<bool>(quote_count, false);
+            for (auto const r : rows_in_batch) {
+                book.set_last_price(ids[r], price(rng));
+                book.subtract_from(totals[r % quote_count], ids[r]);
+                touched[r % quote_count] = true;
+            }
+            book.recompute(batch_ids);
+            for (auto const r : rows_in_batch)
+                book.add_to(totals[r % quote_count], ids[r]);
+            for (auto q = std::size_t{0}; q < quote_count; ++q) {
+                if (touched[q])
+                    sink += totals[q].value;
+            }
+        });
+        std::printf("%5zu prices: batched %9.1f us, per price %10.1f us, "
+                    "%.1fx\n",
+                    rows_in_batch.size(), batched / 1'000., each / 1'000.,
+                    each / batched);
+    }
+    std::printf("(%g)\n", sink);
+}
@@ -0,0 +1,306 @@
+#include "alerts.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <signal.h>
+#include <unistd.h>
+
+#include "asset.hpp"
+#include "filesystem.hpp"
+#include "log.hpp"
+#include "parse_number.hpp"
+
+namespace {
+
+// alerts.txt Format, grouped under exchange headers like assets.txt:
+// Command: notify-send CrabWise
+// Coinbase:
+//     Base Quote Kind Threshold
+// Stock:
+//     Symbol Kind Threshold
+auto constexpr header = "# ~ CrabWise Alerts ~\n";
+
+auto constexpr kind_names = std::array{
+    std::pair{crab::Alert_kind::Above, "above"},
+    std::pair{crab::Alert_kind::Below, "below"},
+    std::pair{crab::Alert_kind::Change_above, "change_above"},
+    std::pair{crab::Alert_kind::Change_below, "change_below"},
+    std::pair{crab::Alert_kind::Pl_above, "pl_above"},
+    std::pair{crab::Alert_kind::Pl_below, "pl_below"},
+};
+
+[[nodiscard]] auto to_string(crab::Alert_kind kind) -> std::string
+{
+    for (auto const& [k, name] : kind_names) {
+        if (k == kind)
+            return name;
+    }
+    return "";
+}
+
+[[nodiscard]] auto parse_kind(std::string const& x)
+    -> std::optional<crab::Alert_kind>
+{
+    for (auto const& [k, name] : kind_names) {
+        if (x == name)
+            return k;
+    }
+    return std::nullopt;
+}
+
+[[nodiscard]] auto upper(std::string x) -> std::string
+{
+    for (char& c : x)
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    return x;
+}
+
+[[nodiscard]] auto number_to_string(double x) -> std::string
+{
+    auto ss = std::ostringstream{};
+    ss << std::setprecision(12) << x;
+    return ss.str();
+}
+
+/// Return true if \p kind fires as the price rises, given the holdings.
+[[nodiscard]] auto is_rising(crab::Alert_kind kind, double quantity) -> bool
+{
+    switch (kind) {
+        case crab::Alert_kind::Above:
+        case crab::Alert_kind::Change_above: return true;
+        case crab::Alert_kind::Below:
+        case crab::Alert_kind::Change_below: return false;
+        case crab::Alert_kind::Pl_above: return quantity > 0.;
+        case crab::Alert_kind::Pl_below: return quantity < 0.;
+    }
+    return true;
+}
+
+}  // namespace
+
+namespace crab {
+
+auto describe(Alert const& alert) -> std::string
+{
+    auto const& [asset, kind, threshold] = alert;
+    auto result = asset.exchange.empty()
+                      ? asset.currency.base
+                      : asset.exchange + ' ' + asset.currency.base + '/' +
+                            asset.currency.quote;
+    result.append(1, ' ').append(to_string(kind)).append(1, ' ');
+    result.append(number_to_string(threshold));
+    if (kind == Alert_kind::Change_above || kind == Alert_kind::Change_below)
+        result.append(1, '%');
+    return result;
+}
+
+auto render_alerts(Alerts_file const& file) -> std::string
+{
+    auto alerts = file.alerts;
+    std::stable_sort(std::begin(alerts), std::end(alerts),
+                     [](Alert const& a, Alert const& b) {
+                         return a.asset.exchange < b.asset.exchange;
+                     });
+    auto out = std::string{header};
+    if (!file.command.empty())
+        out.append("Command: ").append(file.command).append(1, '\n');
+    auto current = std::optional<std::string>{};
+    for (auto const& [asset, kind, threshold] : alerts) {
+        if (current != asset.exchange) {
+            current = asset.exchange;
+            out.append(asset.exchange.empty() ? "Stock" : asset.exchange);
+            out.append(":\n");
+        }
+        out.append("    ").append(asset.currency.base).append(1, ' ');
+        if (!asset.exchange.empty())
+            out.append(asset.currency.quote).append(1, ' ');
+        out.append(to_string(kind))
+            .append(1, ' ')
+            .append(number_to_string(threshold))
+            .append(1, '\n');
+    }
+    return out;
+}
+
+auto read_alerts(fs::path const& filepath) -> Alerts_file
+{
+    if (!fs::exists(filepath))
+        return {};
+    auto result   = Alerts_file{};
+    auto file     = std::ifstream{filepath.string()};
+    auto line     = std::string{};
+    auto exchange = std::string{};
+    while (std::getline(file, line, '\n')) {
+        auto ss    = std::istringstream{line};
+        auto first = std::string{};
+        if (!(ss >> first) || first.front() == '#')
+            continue;
+        if (first == "Command:") {
+            std::getline(ss >> std::ws, result.command);
+            continue;
+        }
+        if (first.back() == ':') {
+            first.pop_back();
+            exchange = upper(first) == "STOCK" ? "" : upper(first);
+            continue;
+        }
+        auto quote = std::string{"USD"};
+        if (!exchange.empty())
+            ss >> quote;
+        auto kind_name = std::string{};
+        auto threshold = std::string{};
+        ss >> kind_name >> threshold;
+        auto const kind  = parse_kind(kind_name);
+        auto const value = parse_double(threshold);
+        if (!kind.has_value() || !value.has_value()) {
+            log_error("Alerts skipped malformed line: " + line);
+            continue;
+        }
+        result.alerts.push_back(
+            {{exchange, {upper(first), upper(quote)}}, *kind, *value});
+    }
+    return result;
+}
+
+void run_alert_command(std::string const& command, std::string const& text)
+{
+    // Exited children are reaped by the kernel, so nothing waits on them.
+    // Crabwise starts no other child processes that it would wait on.
+    static auto const reaped = [] {
+        struct ::sigaction action = {};
+        action.sa_handler         = SIG_DFL;
+        action.sa_flags           = SA_NOCLDWAIT;
+        ::sigemptyset(&action.sa_mask);
+        return ::sigaction(SIGCHLD, &action, nullptr) == 0;
+    }();
+    if (!reaped) {
+        log_error("Alert command: Can't set SIGCHLD to reap commands.");
+        return;
+    }
+    auto const child = ::fork();
+    if (child == -1) {
+        log_error("Alert command: Can't fork.");
+        return;
+    }
+    if (child == 0) {
+        ::execl("/bin/sh", "sh", "-c", command.c_str(), "crabwise",
+                text.c_str(), static_cast<char*>(nullptr));
+        ::_exit(127);
+    }
+}
+
+void Alert_engine::add(Alert const& alert)
+{
+    auto& a       = assets_[alert.asset];
+    auto const id = next_id_++;
+    a.alerts.emplace(id, alert);
+    index(a, id);
+}
+
+void Alert_engine::set_last_close(Asset const& asset, double last_close)
+{
+    auto& a = assets_[asset];
+    if (a.last_close == last_close)
+        return;
+    a.last_close = last_close;
+    reindex(a);
+}
+
+void Alert_engine::set_position(Asset const& asset,
+                                double quantity,
+                                double cost)
+{
+    auto& a = assets_[asset];
+    if (a.quantity == quantity && a.cost == cost)
+        return;
+    a.quantity = quantity;
+    a.cost     = cost;
+    reindex(a);
+}
+
+auto Alert_engine::check(Asset const& asset, double price)
+    -> std::vector<Alert>
+{
+    return this->check(asset, price, price);
+}
+
+auto Alert_engine::check(Asset const& asset, double low, double high)
+    -> std::vector<Alert>
+{
+    auto fired = std::vector<Alert>{};
+    auto at    = assets_.find(asset);
+    if (at == std::end(assets_))
+        return fired;
+    auto& a         = at->second;
+    auto const fire = [&](Id_t id) {
+        auto const alert = a.alerts.find(id);
+        fired.push_back(alert->second);
+        a.alerts.erase(alert);
+    };
+    while (!a.rising.empty() && a.rising.begin()->first <= high) {
+        fire(a.rising.begin()->second);
+        a.rising.erase(a.rising.begin());
+    }
+    while (!a.falling.empty() && std::prev(a.falling.end())->first >= low) {
+        fire(std::prev(a.falling.end())->second);
+        a.falling.erase(std::prev(a.falling.end()));
+    }
+    return fired;
+}
+
+auto Alert_engine::alerts() const -> std::vector<Alert>
+{
+    auto result = std::vector<Alert>{};
+    for (auto const& [asset, a] : assets_) {
+        for (auto const& [id, alert] : a.alerts)
+            result.push_back(alert);
+    }
+    return result;
+}
+
+void Alert_engine::index(Asset_alerts& a, Id_t id)
+{
+    auto const& [asset, kind, threshold] = a.alerts.at(id);
+    auto level                           = threshold;
+    switch (kind) {
+        case Alert_kind::Above:
+        case Alert_kind::Below: break;
+        case Alert_kind::Change_above:
+        case Alert_kind::Change_below:
+            if (a.last_close <= 0.)
+                return;
+            level = a.last_close * (1. + threshold / 100.);
+            break;
+        case Alert_kind::Pl_above:
+        case Alert_kind::Pl_below:
+            if (a.quantity == 0.)
+                return;
+            // quantity * price - cost crosses threshold at this price.
+            level = (threshold + a.cost) / a.quantity;
+            break;
+    }
+    if (is_rising(kind, a.quantity))
+        a.rising.emplace(level, id);
+    else
+        a.falling.emplace(level, id);
+}
+
+void Alert_engine::reindex(Asset_alerts& a)
+{
+    a.rising.clear();
+    a.falling.clear();
+    for (auto const& [id, alert] : a.alerts)
+        index(a, id);
+}
+
+}  // namespace crab
@@ -0,0 +1,106 @@
+#ifndef CRAB_ALERTS_HPP
+#define CRAB_ALERTS_HPP
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "asset.hpp"
+#include "filesystem.hpp"
+
+namespace crab {
+
+enum class Alert_kind {
+    Above,         // Last price at or above threshold.
+    Below,         // Last price at or below threshold.
+    Change_above,  // Percent change since last close at or above threshold.
+    Change_below,  // Percent change since last close at or below threshold.
+    Pl_above,      // Open P&L of all holdings of the asset at or above.
+    Pl_below       // Open P&L of all holdings of the asset at or below.
+};
+
+/// One shot alert, removed once it fires.
+struct Alert {
+    Asset asset;
+    Alert_kind kind;
+    double threshold;
+};
+
+/// Contents of the alerts.txt file.
+struct Alerts_file {
+    std::string command;  // Run with the alert text as $1, may be empty.
+    std::vector<Alert> alerts;
+};
+
+/// Return a one line description of \p alert, for the status bar.
+[[nodiscard]] auto describe(Alert const& alert) -> std::string;
+
+/// Format \p file as the contents of an alerts.txt file.
+[[nodiscard]] auto render_alerts(Alerts_file const& file) -> std::string;
+
+/// Read the alerts.txt file at \p filepath.
+/** Returns an empty Alerts_file if the file does not exist, malformed lines
+ *  are logged and skipped. */
+[[nodiscard]] auto read_alerts(fs::path const& filepath) -> Alerts_file;
+
+/// Run \p command through /bin/sh with \p text as $1, without waiting on it.
+/** The first call sets SA_NOCLDWAIT on SIGCHLD, so the process never waits
+ *  on any of its children from then on. */
+void run_alert_command(std::string const& command, std::string const& text);
+
+/// Checks each price against every Alert on its Asset.
+/** Every alert is reduced to a price level: percent change alerts through the
+ *  last close and P&L alerts through the summed quantity and cost of the
+ *  asset's holdings. Levels are kept in per asset sorted maps, rising and
+ *  falling, so a price only looks at the nearest level on each side and the
+ *  alerts that fire. Alerts that can't yet be reduced to a level, for lack of
+ *  a close or holdings, wait until they can. */
+class Alert_engine {
+   public:
+    /// Start watching \p alert.
+    void add(Alert const& alert);
+
+    /// Set the last close of \p asset, used by percent change alerts.
+    void set_last_close(Asset const& asset, double last_close);
+
+    /// Set the total \p quantity and \p cost of all holdings of \p asset.
+    /** Used by P&L alerts. \p cost is the sum of quantity * cost basis. */
+    void set_position(Asset const& asset, double quantity, double cost);
+
+    /// Check \p price, returning the alerts that fired and are now removed.
+    [[nodiscard]] auto check(Asset const& asset, double price)
+        -> std::vector<Alert>;
+
+    /// Check every price from \p low to \p high, as traded between updates.
+    /** Rising alerts fire up to \p high and falling ones down to \p low. */
+    [[nodiscard]] auto check(Asset const& asset, double low, double high)
+        -> std::vector<Alert>;
+
+    /// Return every alert not yet fired, grouped by Asset.
+    [[nodiscard]] auto alerts() const -> std::vector<Alert>;
+
+   private:
+    using Id_t = std::size_t;
+
+    struct Asset_alerts {
+        std::map<Id_t, Alert> alerts;
+        std::multimap<double, Id_t> rising;   // Fire when price >= level.
+        std::multimap<double, Id_t> falling;  // Fire when price <= level.
+        double last_close = 0.;
+        double quantity   = 0.;
+        double cost       = 0.;
+    };
+
+    std::map<Asset, Asset_alerts> assets_;
+    Id_t next_id_ = 0;
+
+   private:
+    /// Put alert \p id of \p a into the rising or falling map, if it can be.
+    static void index(Asset_alerts& a, Id_t id);
+
+    /// Rebuild the rising and falling maps of \p a from its alerts.
+    static void reindex(Asset_alerts& a);
+};
+
+}  // namespace crab
+#endif  // CRAB_ALERTS_HPP
@@ -7,6 +7,7 @@
 #include <termox/termox.hpp>
 
 #include "format_money.hpp"
+#include "parse_number.hpp"
 
 namespace crab {
 
@@ -27,10 +28,19 @@ class Amount_display : public ox::HLabel {
         amount_updated.emit(double_);
     }
 
+    /// Ignored if \p amount is not a number.
     void set(std::string amount)
+    {
+        auto const value = parse_double(amount);
+        if (value.has_value())
+            this->set(std::move(amount), *value);
+    }
+
+    /// Display \p amount, which has already been parsed into \p value.
+    void set(std::string amount, double value)
     {
         string_ = std::move(amount);
-        double_ = std::stod(string_);
+        double_ = value;
         format_decimal_zeros(string_);
         insert_thousands_separators(string_);
         this->ox::HLabel::set_text(string_);
@@ -53,7 +63,7 @@ class Amount_display : public ox::HLabel {
 
 /// Displays an amount passed in as a string or double, aligns on decimal place.
 /** Inserts thousands separators and formats decimal zeros if needed, \p offset
- *  is used for decimal alignment, if \p hundredths_round is true, rounds. */
+ *  is used for decimal alignment, rounds if decimals are set. */
 class Aligned_amount_display : public ox::HLabel {
    public:
     sl::Signal<void(double)> amount_updated;
@@ -62,8 +72,8 @@ class Aligned_amount_display : public ox::HLabel {
     void set(double amount)
     {
         double_ = amount;
-        if (round_hundredths_)
-            string_ = round_and_to_string(amount, 2);
+        if (decimals_ >= 0)
+            string_ = round_and_to_string(amount, decimals_);
         else
             string_ = std::to_string(amount);
         format_decimal_zeros(string_);
@@ -73,20 +83,27 @@ class Aligned_amount_display : public ox::HLabel {
         amount_updated.emit(double_);
     }
 
-    void set(std::string amount) { this->set(std::stod(amount)); }
+    /// Ignored if \p amount is not a number.
+    void set(std::string const& amount)
+    {
+        auto const value = parse_double(amount);
+        if (value.has_value())
+            this->set(*value);
+    }
 
     void set_offset(std::size_t x)
     {
         offset_ = x;
         if (!string_.empty())
-            this->set(string_);
+            this->set(double_);
     }
 
-    void round_to_hundredths(bool x)
+    /// Round to \p x decimal places, or not at all if negative.
+    void set_decimals(int x)
     {
-        round_hundredths_ = x;
+        decimals_ = x;
         if (!string_.empty())
-            this->set(string_);
+            this->set(double_);
     }
 
     /// Return set value as a double.
@@ -101,8 +118,8 @@ class Aligned_amount_display : public ox::HLabel {
    private:
     double double_;
     std::string string_;
-    std::size_t offset_    = 0;
-    bool round_hundredths_ = false;
+    std::size_t offset_ = 0;
+    int decimals_       = -1;
 };
 }  // namespace crab
 #endif  // CRAB_AMOUNT_DISPLAY_HPP
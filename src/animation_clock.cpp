@@ -0,0 +1,81 @@
+#include "animation_clock.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+namespace crab {
+
+Animated::~Animated()
+{
+    if (clock_ != nullptr)
+        clock_->stop(*this);
+}
+
+Animation_clock::Animation_clock(std::function<void()> on_start)
+    : on_start_{std::move(on_start)}
+{}
+
+Animation_clock::~Animation_clock()
+{
+    for (auto const& r : running_)
+        r.target->clock_ = nullptr;
+}
+
+void Animation_clock::start(Animated& a,
+                            Duration_t length,
+                            Clock_t::time_point now)
+{
+    if (a.clock_ == this) {
+        running_[a.slot_].start  = now;
+        running_[a.slot_].length = length;
+        return;
+    }
+    if (a.clock_ != nullptr)
+        a.clock_->stop(a);
+    a.clock_ = this;
+    a.slot_  = running_.size();
+    running_.push_back({&a, now, length});
+    if (running_.size() == 1 && on_start_)
+        on_start_();
+}
+
+void Animation_clock::stop(Animated& a)
+{
+    if (a.clock_ != this)
+        return;
+    this->erase(a.slot_);
+    a.clock_ = nullptr;
+}
+
+auto Animation_clock::step(Clock_t::time_point now) -> bool
+{
+    auto i = std::size_t{0};
+    while (i < running_.size()) {
+        auto const r       = running_[i];
+        auto const elapsed = std::chrono::duration<double>(now - r.start);
+        auto const length  = std::chrono::duration<double>(r.length);
+        if (elapsed < length) {
+            r.target->animate(length.count() > 0. ? elapsed / length : 1.);
+            ++i;
+            continue;
+        }
+        // Ended first, so the last frame may start it again.
+        this->erase(i);
+        r.target->clock_ = nullptr;
+        r.target->animate(1.);
+    }
+    return !running_.empty();
+}
+
+void Animation_clock::erase(std::size_t slot)
+{
+    if (slot != running_.size() - 1) {
+        running_[slot]               = running_.back();
+        running_[slot].target->slot_ = slot;
+    }
+    running_.pop_back();
+}
+
+}  // namespace crab
@@ -0,0 +1,94 @@
+#ifndef CRAB_ANIMATION_CLOCK_HPP
+#define CRAB_ANIMATION_CLOCK_HPP
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace crab {
+
+class Animation_clock;
+
+/// Something drawn over a fixed length of time by an Animation_clock.
+/** Stops its animation when destroyed, so it may go away at any time. */
+class Animated {
+   public:
+    Animated() = default;
+
+    Animated(Animated const&) = delete;
+    Animated& operator=(Animated const&) = delete;
+
+    virtual ~Animated();
+
+   public:
+    /// Draw the frame at \p progress, from 0 at the start to 1 at the end.
+    /** Called exactly once with 1, as the animation ends. */
+    virtual void animate(double progress) = 0;
+
+    [[nodiscard]] auto is_animating() const -> bool
+    {
+        return clock_ != nullptr;
+    }
+
+   private:
+    friend class Animation_clock;
+    Animation_clock* clock_ = nullptr;  // While animating.
+    std::size_t slot_       = 0;        // Index into the clock's running_.
+};
+
+/// Drives every running animation from a single timer.
+/** Running animations are kept in a compact vector, each frame steps only
+ *  those and restarting one that is running doesn't add another. So the cost
+ *  of a frame is the number of animations on screen, however often they are
+ *  started. The timer is only needed while something is running. Not thread
+ *  safe. */
+class Animation_clock {
+   public:
+    using Clock_t    = std::chrono::steady_clock;
+    using Duration_t = std::chrono::milliseconds;
+
+   public:
+    /// \p on_start is called when an animation starts while none are running.
+    /** It should start the timer that calls step(). */
+    explicit Animation_clock(std::function<void()> on_start);
+
+    Animation_clock(Animation_clock const&) = delete;
+    Animation_clock& operator=(Animation_clock const&) = delete;
+
+    /// Running animations are left as they are, without their last frame.
+    ~Animation_clock();
+
+   public:
+    /// Run \p a for \p length from \p now, from the start if already running.
+    void start(Animated& a,
+               Duration_t length,
+               Clock_t::time_point now = Clock_t::now());
+
+    /// End \p a without drawing its last frame, no-op if not running.
+    void stop(Animated& a);
+
+    /// Draw the frame at \p now of every running animation.
+    /** Animations that have run their length are ended. Returns false once
+     *  none are left running, the timer can then be stopped. */
+    auto step(Clock_t::time_point now = Clock_t::now()) -> bool;
+
+    /// Return the number of running animations.
+    [[nodiscard]] auto size() const -> std::size_t { return running_.size(); }
+
+   private:
+    struct Running {
+        Animated* target;
+        Clock_t::time_point start;
+        Duration_t length;
+    };
+
+    std::vector<Running> running_;
+    std::function<void()> on_start_;
+
+   private:
+    /// Remove the Running at \p slot, the last one is moved into its place.
+    void erase(std::size_t slot);
+};
+
+}  // namespace crab
+#endif  // CRAB_ANIMATION_CLOCK_HPP
@@ -1,6 +1,8 @@
 #ifndef CRAB_ASSET_PICKER_HPP
 #define CRAB_ASSET_PICKER_HPP
+#include <cstddef>
 #include <string>
+#include <vector>
 
 #include <termox/termox.hpp>
 
@@ -51,9 +53,23 @@ class Search_input
 class Asset_btn : public ox::HThin_button {
    public:
     Asset_btn(Search_result const& search_result)
-        : ox::HThin_button{to_display(search_result)}
+        : ox::HThin_button{to_display(search_result)},
+          asset_{search_result.asset}
     {}
 
+   public:
+    /// Reuse this button to display \p search_result.
+    void set(Search_result const& search_result)
+    {
+        this->set_label(to_display(search_result));
+        asset_ = search_result.asset;
+    }
+
+    [[nodiscard]] auto asset() const -> Asset const& { return asset_; }
+
+   private:
+    Asset asset_;
+
    private:
     [[nodiscard]] static auto to_display(Search_result const& sr)
         -> ox::Glyph_string
@@ -75,14 +91,34 @@ class Result_subgroup_btns
     sl::Signal<void(Asset const&)> selected;
 
    public:
+    /// Start a new set of results, old results are shown until overwritten.
+    void begin_results() { used_ = 0; }
+
+    /// Display \p search_result on the next button, reusing one if possible.
     void add_result(Search_result const& search_result)
     {
-        this->make_child(search_result)
-            .pressed.connect(
-                [this, asset = search_result.asset] { this->selected(asset); });
+        if (used_ == pool_.size()) {
+            auto& btn = this->make_child(search_result);
+            btn.pressed.connect([this, &btn] { this->selected(btn.asset()); });
+            pool_.push_back(&btn);
+        }
+        else {
+            pool_[used_]->set(search_result);
+            pool_[used_]->enable();
+        }
+        ++used_;
     }
 
-    void clear_results() { this->delete_all_children(); }
+    /// Hide the buttons not reused since begin_results.
+    void end_results()
+    {
+        for (auto i = used_; i < pool_.size(); ++i)
+            pool_[i]->disable();
+    }
+
+   private:
+    std::vector<Asset_btn*> pool_;  // Every child, in display order.
+    std::size_t used_ = 0;
 };
 
 class Results_subgroup
@@ -110,12 +146,14 @@ class Results_subgroup
     }
 
    public:
+    void begin_results() { btns.begin_results(); }
+
     void add_result(Search_result const& search_result)
     {
         btns.add_result(search_result);
     }
 
-    void clear_results() { btns.clear_results(); }
+    void end_results() { btns.end_results(); }
 };
 
 class Search_results : public ox::VArray<Results_subgroup, 2> {
@@ -138,6 +176,13 @@ class Search_results : public ox::VArray<Results_subgroup, 2> {
     }
 
    public:
+    /// Start a new set of results, see Result_subgroup_btns::begin_results.
+    void begin_results()
+    {
+        crypto.begin_results();
+        stocks.begin_results();
+    }
+
     void add_result(Search_result const& search_result)
     {
         if (search_result.type == "Crypto")
@@ -146,10 +191,11 @@ class Search_results : public ox::VArray<Results_subgroup, 2> {
             stocks.add_result(search_result);
     }
 
-    void clear_results()
+    /// Hide results left over from the previous set.
+    void end_results()
     {
-        crypto.clear_results();
-        stocks.clear_results();
+        crypto.end_results();
+        stocks.end_results();
     }
 };
 
@@ -0,0 +1,172 @@
+#include "autosaver.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "filesystem.hpp"
+#include "log.hpp"
+#include "markets/error.hpp"
+#include "thread_config.hpp"
+
+namespace {
+
+[[nodiscard]] auto errno_message(std::string const& what,
+                                 crab::fs::path const& filepath) -> std::string
+{
+    return "Autosave: " + what + ' ' + filepath.string() + ": " +
+           std::strerror(errno);
+}
+
+/// fsync the directory holding \p filepath so a rename in it is durable.
+void sync_parent_directory(crab::fs::path const& filepath)
+{
+    auto const directory = filepath.parent_path().empty()
+                               ? crab::fs::path{"."}
+                               : filepath.parent_path();
+    auto const fd = ::open(directory.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return;  // Best effort, the rename itself has happened.
+    ::fsync(fd);
+    ::close(fd);
+}
+
+}  // namespace
+
+namespace crab {
+
+void write_file_atomically(fs::path const& filepath,
+                           std::string const& contents)
+{
+    // A unique name, so concurrent writers of one file never share it.
+    auto name     = filepath.string() + ".XXXXXX";
+    auto const fd = ::mkstemp(name.data());
+    if (fd == -1)
+        throw Crab_error{errno_message("Can't create", name)};
+    auto const temp = fs::path{name};
+    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    ::fchmod(fd, 0644);  // mkstemp() creates the file 0600.
+    auto const* data = contents.data();
+    auto remaining   = contents.size();
+    while (remaining != 0) {
+        auto const n = ::write(fd, data, remaining);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            auto const error = errno_message("Can't write", temp);
+            ::close(fd);
+            ::unlink(temp.c_str());
+            throw Crab_error{error};
+        }
+        data += n;
+        remaining -= static_cast<std::size_t>(n);
+    }
+    if (::fsync(fd) == -1 || ::close(fd) == -1) {
+        auto const error = errno_message("Can't sync", temp);
+        ::unlink(temp.c_str());
+        throw Crab_error{error};
+    }
+    if (::rename(temp.c_str(), filepath.c_str()) == -1) {
+        auto const error = errno_message("Can't replace", filepath);
+        ::unlink(temp.c_str());
+        throw Crab_error{error};
+    }
+    sync_parent_directory(filepath);
+}
+
+Autosaver::Autosaver(Duration_t delay, Duration_t max_delay)
+    : delay_{delay}, max_delay_{max_delay}, worker_{[this] { this->run(); }}
+{}
+
+Autosaver::~Autosaver()
+{
+    {
+        auto const lock = std::lock_guard{mtx_};
+        exit_           = true;
+    }
+    cv_.notify_one();
+    worker_.join();
+}
+
+void Autosaver::schedule(fs::path const& filepath, Render_t render)
+{
+    this->add(filepath, std::move(render), delay_);
+}
+
+void Autosaver::save_now(fs::path const& filepath, Render_t render)
+{
+    this->add(filepath, std::move(render), Duration_t::zero());
+}
+
+void Autosaver::add(fs::path const& filepath,
+                    Render_t render,
+                    Duration_t delay)
+{
+    auto const now = Clock_t::now();
+    {
+        auto const lock = std::lock_guard{mtx_};
+        auto& pending =
+            pending_.try_emplace(filepath.string(), Pending{{}, now, now, 0})
+                .first->second;
+        pending.render = std::move(render);
+        pending.order  = next_order_++;
+        pending.due    = std::min(now + delay, pending.first + max_delay_);
+    }
+    cv_.notify_one();
+}
+
+void Autosaver::run()
+{
+    enter_thread_role(Thread_role::Persistence, "crab-save");
+    auto lock = std::unique_lock{mtx_};
+    while (true) {
+        // Collect every file that is due, or everything when exiting.
+        auto const now = Clock_t::now();
+        auto ready     = std::vector<std::pair<std::string, Pending>>{};
+        auto next_due  = Clock_t::time_point::max();
+        for (auto at = std::begin(pending_); at != std::end(pending_);) {
+            if (exit_ || at->second.due <= now) {
+                ready.emplace_back(at->first, std::move(at->second));
+                at = pending_.erase(at);
+            }
+            else {
+                next_due = std::min(next_due, at->second.due);
+                ++at;
+            }
+        }
+        if (ready.empty()) {
+            if (exit_)
+                return;
+            if (next_due == Clock_t::time_point::max())
+                cv_.wait(lock);
+            else
+                cv_.wait_until(lock, next_due);
+            continue;
+        }
+        std::sort(std::begin(ready), std::end(ready),
+                  [](auto const& a, auto const& b) {
+                      return a.second.order < b.second.order;
+                  });
+        // Render and write without the lock so the UI thread never waits.
+        lock.unlock();
+        for (auto const& [filepath, pending] : ready) {
+            try {
+                write_file_atomically(filepath, pending.render());
+            }
+            catch (std::exception const& e) {
+                log_error(e.what());
+            }
+        }
+        lock.lock();
+    }
+}
+
+}  // namespace crab
@@ -0,0 +1,78 @@
+#ifndef CRAB_AUTOSAVER_HPP
+#define CRAB_AUTOSAVER_HPP
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "filesystem.hpp"
+
+namespace crab {
+
+/// Replace \p filepath with \p contents so a crash leaves the old or new file.
+/** Writes to a uniquely named temporary file in the same directory, fsyncs
+ *  it, then renames it over \p filepath and fsyncs the directory. The
+ *  temporary file is removed on failure. Throws Crab_error. */
+void write_file_atomically(fs::path const& filepath,
+                           std::string const& contents);
+
+/// Writes files on a background thread, coalescing bursts of saves.
+/** Callers snapshot their data on their own thread and pass a render function
+ *  that turns the snapshot into file contents. Only the newest render function
+ *  for each file is run, once edits to that file have been quiet for the
+ *  delay, or at most max_delay after the first unsaved edit. */
+class Autosaver {
+   public:
+    using Clock_t    = std::chrono::steady_clock;
+    using Duration_t = std::chrono::milliseconds;
+    using Render_t   = std::function<std::string()>;
+
+   public:
+    explicit Autosaver(Duration_t delay     = Duration_t{1'000},
+                       Duration_t max_delay = Duration_t{5'000});
+
+    Autosaver(Autosaver const&) = delete;
+    Autosaver& operator=(Autosaver const&) = delete;
+
+    /// Writes everything still pending before returning.
+    ~Autosaver();
+
+   public:
+    /// Write the result of \p render to \p filepath after the delay.
+    void schedule(fs::path const& filepath, Render_t render);
+
+    /// Write the result of \p render to \p filepath as soon as possible.
+    /** Files that are due together are written in the order of their latest
+     *  schedule() or save_now() call. */
+    void save_now(fs::path const& filepath, Render_t render);
+
+   private:
+    struct Pending {
+        Render_t render;
+        Clock_t::time_point first;  // First unsaved edit.
+        Clock_t::time_point due;
+        std::uint64_t order;  // Of the latest request, writes are in order.
+    };
+
+    Duration_t const delay_;
+    Duration_t const max_delay_;
+
+    std::map<std::string, Pending> pending_;  // By file path.
+    std::uint64_t next_order_ = 0;
+    bool exit_ = false;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::thread worker_;
+
+   private:
+    void add(fs::path const& filepath, Render_t render, Duration_t delay);
+
+    void run();
+};
+
+}  // namespace crab
+#endif  // CRAB_AUTOSAVER_HPP
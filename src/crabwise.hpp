@@ -2,23 +2,46 @@
 #define CRAB_CRABWISE_HPP
 #include <cctype>
 #include <chrono>
+#include <cmath>
 #include <ctime>
+#include <exception>
 #include <fstream>
 #include <iomanip>
+#include <optional>
+#include <set>
 #include <sstream>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
 #include <termox/termox.hpp>
 
+#include "alerts.hpp"
 #include "asset_picker.hpp"
+#include "autosaver.hpp"
+#include "depth_list.hpp"
+#include "depth_panel.hpp"
 #include "filenames.hpp"
 #include "filesystem.hpp"
+#include "fx_graph.hpp"
+#include "job_scheduler.hpp"
+#include "log.hpp"
 #include "net_totals.hpp"
 #include "palette.hpp"
+#include "parse_number.hpp"
+#include "portfolio_file.hpp"
+#include "price_bus_config.hpp"
+#include "price_snapshot.hpp"
+#include "risk_config.hpp"
+#include "risk_engine.hpp"
+#include "risk_panel.hpp"
 #include "search_result.hpp"
+#include "sort_key.hpp"
+#include "symbol_id_json.hpp"
+#include "ticker_filter.hpp"
 #include "ticker_list.hpp"
+#include "trades_config.hpp"
 
 namespace crab {
 
@@ -59,24 +82,52 @@ class Status_bar : public ox::HPair<Status_box, ox::Button> {
     void set_status(ox::Glyph_string const& x) { status_box.set_status(x); }
 };
 
+/// Line above the column labels where Tickers can be filtered.
+class Filter_bar : public ox::HPair<ox::HLabel, ox::Line_edit> {
+   public:
+    ox::HLabel& title          = this->first;
+    ox::Line_edit& filter_text = this->second;
+
+   public:
+    /// Emitted with the parsed filter text when editing is finished.
+    sl::Signal<void(Ticker_filter const&)> filter_changed;
+
+   public:
+    Filter_bar()
+    {
+        using namespace ox::pipe;
+        *this | fixed_height(1);
+        title.set_text(U" Filter " | ox::Trait::Bold);
+        title | fixed_width(8);
+        filter_text | bg(crab::Almost_bg);
+        filter_text.edit_finished.connect([this](std::string const& s) {
+            filter_changed.emit(parse_ticker_filter(s));
+        });
+    }
+};
+
 class App_space
     : public ox::HTuple<
           Asset_picker,
-          ox::VTuple<ox::Widget,
+          ox::VTuple<Filter_bar,
                      Column_labels,
                      ox::HTuple<ox::VTuple<HLine, Ticker_list, ox::Widget>,
-                                ox::VScrollbar>,
+                                ox::VScrollbar,
+                                Risk_panel>,
+                     Depth_panel,
                      All_net_totals,
                      Status_bar>> {
    public:
     Asset_picker& asset_picker = this->get<0>();
     Column_labels& labels      = this->get<1>().get<1>();
-    ox::Widget& top_line       = this->get<1>().get<0>();
+    Filter_bar& filter_bar     = this->get<1>().get<0>();
     Ticker_list& ticker_list   = this->get<1>().get<2>().get<0>().get<1>();
     ox::Widget& bottom_buffer  = this->get<1>().get<2>().get<0>().get<2>();
-    All_net_totals& net_totals = this->get<1>().get<3>();
-    Status_bar& status_bar     = this->get<1>().get<4>();
+    Depth_panel& depth_panel   = this->get<1>().get<3>();
+    All_net_totals& net_totals = this->get<1>().get<4>();
+    Status_bar& status_bar     = this->get<1>().get<5>();
     ox::VScrollbar& scrollbar  = this->get<1>().get<2>().get<1>();
+    Risk_panel& risk_panel     = this->get<1>().get<2>().get<2>();
 
    public:
     App_space()
@@ -84,7 +135,9 @@ class App_space
         link(scrollbar, ticker_list);
         bottom_buffer.install_event_filter(scrollbar);
 
-        top_line | ox::pipe::fixed_height(1);
+        filter_bar.filter_changed.connect([this](Ticker_filter const& f) {
+            ticker_list.set_filter(f);
+        });
 
         asset_picker.search_results.selected.connect(
             [this](Asset const& asset) {
@@ -93,28 +146,75 @@ class App_space
 
         asset_picker.search_input.search_request.connect(
             [this](std::string const& s) {
-                asset_picker.search_results.clear_results();
+                asset_picker.search_results.begin_results();
                 this->ticker_list.request_search(s);
             });
 
         ticker_list.search_results_received.connect(
-            [this](std::vector<Search_result> const& results) {
-                asset_picker.search_results.clear_results();
-                asset_picker.search_input.stop_spinner();
-                for (auto const& search_result : results)
+            [this](std::vector<Search_result> const& chunk) {
+                for (auto const& search_result : chunk)
                     asset_picker.search_results.add_result(search_result);
             });
+        ticker_list.search_finished.connect([this] {
+            asset_picker.search_results.end_results();
+            asset_picker.search_input.stop_spinner();
+        });
         ticker_list.value_total_updated.connect(
             [this](std::string const& quote, double sum) {
                 net_totals.net_totals_manager.update_value(quote, sum);
+                consolidated_.set_value(quote, sum);
+                this->show_consolidated();
             });
         ticker_list.open_pl_total_updated.connect(
             [this](std::string const& quote, double sum) {
                 net_totals.net_totals_manager.update_open_pl(quote, sum);
+                consolidated_.set_open_pl(quote, sum);
+                this->show_consolidated();
             });
         ticker_list.daily_pl_total_updated.connect(
             [this](std::string const& quote, double sum) {
                 net_totals.net_totals_manager.update_daily_pl(quote, sum);
+                consolidated_.set_daily_pl(quote, sum);
+                this->show_consolidated();
+            });
+        ticker_list.last_price_received.connect(
+            [this](Asset const& asset, double price) {
+                auto const fired = alert_engine_.check(asset, price);
+                if (!fired.empty()) {
+                    this->alerts_fired(fired,
+                                       "last price " + std::to_string(price));
+                }
+                if (asset.exchange.empty())
+                    return;  // Stocks are not currencies.
+                if (consolidated_.set_rate(asset.currency, price))
+                    this->show_consolidated();
+            });
+        ticker_list.trade_range_received.connect(
+            [this](Asset const& asset, double low, double high) {
+                auto const fired = alert_engine_.check(asset, low, high);
+                if (!fired.empty()) {
+                    this->alerts_fired(fired, "traded " + std::to_string(low) +
+                                                  " to " +
+                                                  std::to_string(high));
+                }
+            });
+        ticker_list.last_close_received.connect(
+            [this](Asset const& asset, double last_close) {
+                alert_engine_.set_last_close(asset, last_close);
+            });
+        ticker_list.ticker_selected.connect([this](Asset const& asset) {
+            if (depth_assets_.count(asset) == 0)
+                depth_panel.show_unavailable(asset);
+            else
+                depth_panel.show(asset);
+        });
+        ticker_list.depth_update.connect(
+            [this](Asset const& asset, Depth const& depth) {
+                depth_panel.update(asset, depth);
+            });
+        ticker_list.position_changed.connect(
+            [this](Asset const& asset, double quantity, double cost) {
+                alert_engine_.set_position(asset, quantity, cost);
             });
 
         status_bar.save_btn.pressed.connect([this] { this->save_state(); });
@@ -122,45 +222,308 @@ class App_space
         setup_column_sorting(*this);
     }
 
+   public:
+    /// Save assets.crab in the background whenever the portfolio is edited.
+    /** Called once the initial assets are loaded, so loading them doesn't
+     *  rewrite the file. assets.txt is only written by the Save button. */
+    void start_autosave()
+    {
+        ticker_list.portfolio_changed.connect([this] {
+            autosaver_.schedule(
+                portfolio_filepath(),
+                [holdings = this->holdings()] {
+                    return render_portfolio(holdings);
+                });
+        });
+    }
+
+    /// Start watching the alerts in alerts.txt.
+    /** Called after any warm start so saved prices don't fire alerts. */
+    void load_alerts()
+    {
+        auto file      = read_alerts(alerts_filepath());
+        alert_command_ = std::move(file.command);
+        for (auto const& alert : file.alerts)
+            this->add_alert(alert);
+    }
+
+    /// Watch \p alert, streaming its Asset even if no Ticker lists it.
+    void add_alert(Alert const& alert)
+    {
+        alert_engine_.add(alert);
+        ticker_list.watch(alert.asset);
+    }
+
+    /// Keep live order books of the Assets listed in depth.txt.
+    /** Selecting a Ticker of one of them shows its book in the depth panel. */
+    void load_depth()
+    {
+        for (auto const& asset : read_depth_list(depth_filepath())) {
+            if (depth_assets_.insert(asset).second)
+                ticker_list.subscribe_depth(asset);
+        }
+    }
+
+    /// Show the trade volume, VWAP and count columns if trades.txt exists.
+    void load_trades()
+    {
+        auto const window = read_trade_window(trades_filepath());
+        if (!window.has_value())
+            return;
+        labels.show_trade_columns();
+        ticker_list.show_trade_columns(*window);
+    }
+
+    /// Show rolling volatility, beta and correlations if risk.txt exists.
+    /** Called after any warm start, so saved prices aren't taken as returns,
+     *  and before start_jobs(), which samples the prices. */
+    void load_risk()
+    {
+        auto const config = read_risk_config(risk_filepath());
+        if (!config.has_value())
+            return;
+        risk_.emplace(config->window, config->interval);
+        if (config->benchmark.has_value()) {
+            ticker_list.watch(*config->benchmark);
+            risk_->set_benchmark(*config->benchmark);
+        }
+        this->track_risk();
+        risk_panel.show(*config);
+        ticker_list.last_price_received.connect(
+            [this](Asset const& asset, double price) {
+                risk_->set_price(asset, price);
+            });
+        ticker_list.portfolio_changed.connect([this] { this->track_risk(); });
+        ticker_list.ticker_selected.connect([this](Asset const& asset) {
+            risk_panel.select(asset);
+            risk_panel.update(*risk_);
+        });
+    }
+
+    /// Use a running crabwise --daemon for market data, if there is one.
+    void connect_daemon()
+    {
+        auto const path = daemon_socket_filepath().string();
+        if (!ticker_list.connect_daemon(path))
+            return;
+        log_status("Served by the daemon at " + path);
+        status_bar.set_status("Prices served by crabwise --daemon.");
+    }
+
+    /// Publish streamed ticks to shared memory if price_bus.txt exists.
+    void load_price_bus()
+    {
+        auto const config = read_price_bus_config(price_bus_filepath());
+        if (!config.has_value())
+            return;
+        try {
+            ticker_list.open_price_bus(config->name, config->slot_count);
+            log_status("Publishing prices to " + config->name);
+        }
+        catch (Crab_error const& e) {
+            log_error(e.what());
+            status_bar.set_status(std::string{e.what()});
+        }
+    }
+
+    /// Start the periodic background jobs.
+    /** Stats are revalidated every five minutes and again at each day and US
+     *  session boundary, so last closes roll over while left running. Prices
+     *  are snapshotted every 30s and the symbol database refreshed nightly. */
+    void start_jobs()
+    {
+        using namespace std::chrono_literals;
+        auto const on_ui = [](auto f) {
+            return [f](ox::Event_queue& q) { q.append(ox::Custom_event{f}); };
+        };
+        jobs_.every(5min, on_ui([this] {
+                        ticker_list.refresh_stats(Rest_lane::Background);
+                    }));
+        // Crypto days end at midnight UTC, US stocks open at 9:30 New York
+        // time, which is 13:30 or 14:30 UTC depending on daylight saving.
+        for (auto const at : {std::chrono::minutes{0}, 13h + 30min,
+                              14h + 30min}) {
+            jobs_.daily_utc(at, on_ui([this] {
+                                ticker_list.refresh_stats(Rest_lane::Visible);
+                            }));
+        }
+        jobs_.every(30s, on_ui([this] { this->save_price_snapshot(); }));
+        jobs_.every(5s, on_ui([this] { ticker_list.mark_lagging(); }));
+        jobs_.every(1min, on_ui([this] { this->report_latency(); }));
+        if (risk_.has_value()) {
+            jobs_.every(risk_->interval(), on_ui([this] {
+                            risk_->sample();
+                            risk_panel.update(*risk_);
+                        }));
+        }
+        jobs_.daily_utc(8h, [](ox::Event_queue&) {
+            write_ids_json();
+            log_status("Symbol ID database refreshed.");
+        });
+        jobs_.start();
+    }
+
+    /// Log the feed latency of every market, warn of any far behind.
+    void report_latency()
+    {
+        for (auto const& m : ticker_list.latency_report()) {
+            auto line = "Latency " + m.market + ": " + std::to_string(m.ticks) +
+                        " ticks, last " + std::to_string(m.idle_ms / 1'000) +
+                        "s ago";
+            if (m.timed) {
+                auto const average = std::lround(m.average_ms);
+                line += ", average " + std::to_string(average) + "ms, worst " +
+                        std::to_string(m.worst_ms) + "ms";
+            }
+            log_status(line);
+            if (m.timed && m.average_ms > lag_warning_ms) {
+                status_bar.set_status(
+                    m.market + " feed is " +
+                    std::to_string(std::lround(m.average_ms / 1'000.)) +
+                    "s behind the exchange.");
+            }
+        }
+    }
+
+    /// Write current prices so the next run can show them right away.
+    void save_price_snapshot()
+    {
+        autosaver_.save_now(
+            price_snapshot_filepath(),
+            [entries = ticker_list.price_snapshot()] {
+                return render_price_snapshot(entries);
+            });
+    }
+
+   private:
+    /// A market averaging more latency than this is shown on the status bar.
+    static auto constexpr lag_warning_ms = 5'000.;
+
+   private:
+    // Destroyed before the widgets, writing anything still pending.
+    Autosaver autosaver_;
+
+    // Every quote currency converted to USD through streamed rates.
+    Consolidated_totals consolidated_{"USD"};
+
+    Alert_engine alert_engine_;
+    std::string alert_command_;  // From alerts.txt, may be empty.
+
+    std::set<Asset> depth_assets_;  // From depth.txt.
+
+    std::optional<Risk_engine> risk_;  // If risk.txt exists.
+
+    // Declared last so its worker stops before anything a job touches.
+    Job_scheduler jobs_;
+
+   private:
+    /// Track the Asset of every Ticker in the risk engine, in list order.
+    void track_risk()
+    {
+        auto assets = std::vector<Asset>{};
+        for (Ticker const& child : ticker_list.get_children())
+            assets.push_back(child.asset());
+        risk_->track(assets);
+    }
+
+    void show_consolidated()
+    {
+        auto const t = consolidated_.totals();
+        net_totals.net_totals_manager.update_consolidated(
+            consolidated_.reporting(), t.value, t.open_pl, t.daily_pl,
+            t.complete);
+    }
+
+    /// Show each of \p fired on the status bar, run the alert command on it.
+    /** \p prices describes the prices that fired them. */
+    void alerts_fired(std::vector<Alert> const& fired,
+                      std::string const& prices)
+    {
+        for (auto const& alert : fired) {
+            auto text = "Alert: " + describe(alert) + ", " + prices;
+            log_status(text);
+            if (!alert_command_.empty())
+                run_alert_command(alert_command_, text);
+            status_bar.set_status(std::move(text));
+        }
+        this->save_alerts();
+    }
+
+    /// Write alerts.txt in the background, fired alerts are left out.
+    void save_alerts()
+    {
+        autosaver_.schedule(
+            alerts_filepath(),
+            [file = Alerts_file{alert_command_, alert_engine_.alerts()}] {
+                return render_alerts(file);
+            });
+    }
+
    private:
     void save_state()
     {
         auto const filepath = assets_filepath();
-        {
-            auto file = std::ofstream{filepath.string()};
-            file << generate_save_string(ticker_list);
-        }
-        status_bar.set_status("Snapshot saved to: " + filepath.string());
+        auto holdings       = this->holdings();
+        // Text first, so assets.crab is not older than it and still loads.
+        autosaver_.save_now(filepath, [holdings] {
+            return generate_save_string(holdings);
+        });
+        autosaver_.save_now(portfolio_filepath(),
+                            [holdings = std::move(holdings)] {
+                                return render_portfolio(holdings);
+                            });
+        this->save_price_snapshot();
+        this->save_alerts();
+        status_bar.set_status("Snapshot saving to: " + filepath.string());
+    }
+
+    /// Copy the asset, quantity and cost basis of each Ticker, in order.
+    /** Rendered on the Autosaver thread, so it gets its own copy. */
+    [[nodiscard]] auto holdings() const -> std::vector<Holding>
+    {
+        auto result = std::vector<Holding>{};
+        for (Ticker const& child : ticker_list.get_children())
+            result.push_back({child.asset(), child.quantity(),
+                              child.cost_basis()});
+        return result;
     }
 
    private:
-    [[nodiscard]] static auto to_string(Ticker& ticker, bool add_exchange)
-        -> std::string
+    static void append_holding(std::string& out,
+                               Holding const& holding,
+                               bool add_exchange)
     {
-        auto result = std::string{};
+        auto const& [asset, quantity, cost_basis] = holding;
         if (add_exchange) {
-            auto exchange = ticker.asset().exchange;
-            if (exchange.empty())
-                exchange = "Stock";
-            result.append(exchange + ":\n");
+            out.append(asset.exchange.empty() ? "Stock" : asset.exchange);
+            out.append(":\n");
         }
-        result.append("    " + ticker.asset().currency.base + ' ' +
-                      ticker.asset().currency.quote + ' ' +
-                      std::to_string(ticker.quantity()) + ' ' +
-                      std::to_string(ticker.cost_basis()) + '\n');
-        return result;
+        out.append("    ")
+            .append(asset.currency.base)
+            .append(1, ' ')
+            .append(asset.currency.quote)
+            .append(1, ' ')
+            .append(std::to_string(quantity))
+            .append(1, ' ')
+            .append(std::to_string(cost_basis))
+            .append(1, '\n');
     }
 
-    [[nodiscard]] static auto generate_save_string(Ticker_list& list)
-        -> std::string
+    [[nodiscard]] static auto generate_save_string(
+        std::vector<Holding> const& holdings) -> std::string
     {
         auto result = std::string{
             "# ~ CrabWise ~\n# Exchange:\n#   Base Quote [Quantity] "
             "[Cost Basis]\n\n"};
+        result.reserve(result.size() + holdings.size() * 48);
         auto exchange = std::string{};
-        for (Ticker& child : list.get_children()) {
-            result.append(to_string(child, exchange != child.asset().exchange));
-            exchange = child.asset().exchange;
+        auto first    = true;
+        for (auto const& holding : holdings) {
+            auto const& asset = holding.asset;
+            append_holding(result, holding,
+                           first || exchange != asset.exchange);
+            exchange = asset.exchange;
+            first    = false;
         }
         return result;
     }
@@ -168,104 +531,19 @@ class App_space
     static void setup_column_sorting(App_space& w)
     {
         using namespace ox::pipe;
-        auto constexpr to_lower = [](std::string const& x) -> std::string {
-            auto result = std::string{};
-            for (unsigned char c : x)
-                result.push_back(std::tolower(c));
-            return result;
-        };
-        auto const hook_up = [&w](auto& label_widget, auto const& asc_comp,
-                                  auto const& desc_comp) {
-            label_widget |
-                on_mouse_press([&w, &asc_comp, &desc_comp,
-                                ascending = false](auto const& m) mutable {
-                    if (m.button == ox::Mouse::Button::Left) {
-                        if (ascending)
-                            w.ticker_list.sort(asc_comp);
-                        else
-                            w.ticker_list.sort(desc_comp);
-                        ascending = !ascending;
-                    }
-                });
-        };
-
-        // Value
-        auto value_acomp = [](auto const& a, auto const& b) {
-            return a.listings.value.amount.as_double() <
-                   b.listings.value.amount.as_double();
-        };
-        auto value_dcomp = [](auto const& a, auto const& b) {
-            return a.listings.value.amount.as_double() >
-                   b.listings.value.amount.as_double();
-        };
-        hook_up(w.labels.value, value_acomp, value_dcomp);
-
-        // Open P&L
-        auto open_pl_acomp = [](auto const& a, auto const& b) {
-            return a.listings.open_pl.amount.as_double() <
-                   b.listings.open_pl.amount.as_double();
-        };
-        auto open_pl_dcomp = [](auto const& a, auto const& b) {
-            return a.listings.open_pl.amount.as_double() >
-                   b.listings.open_pl.amount.as_double();
-        };
-        hook_up(w.labels.open_pl, open_pl_acomp, open_pl_dcomp);
-
-        // Daily P&L
-        auto daily_pl_acomp = [](auto const& a, auto const& b) {
-            return a.listings.daily_pl.amount.as_double() <
-                   b.listings.daily_pl.amount.as_double();
-        };
-        auto daily_pl_dcomp = [](auto const& a, auto const& b) {
-            return a.listings.daily_pl.amount.as_double() >
-                   b.listings.daily_pl.amount.as_double();
-        };
-        hook_up(w.labels.daily_pl, daily_pl_acomp, daily_pl_dcomp);
-
-        // % Change
-        auto percent_change_acomp = [](auto const& a, auto const& b) {
-            return a.listings.percent_change.get_percent() <
-                   b.listings.percent_change.get_percent();
-        };
-        auto percent_change_dcomp = [](auto const& a, auto const& b) {
-            return a.listings.percent_change.get_percent() >
-                   b.listings.percent_change.get_percent();
-        };
-        hook_up(w.labels.percent_change, percent_change_acomp,
-                percent_change_dcomp);
-
-        // Base
-        auto base_acomp = [](auto const& a, auto const& b) {
-            return a.listings.name.base.get_text().str() >
-                   b.listings.name.base.get_text().str();
-        };
-        auto base_dcomp = [](auto const& a, auto const& b) {
-            return a.listings.name.base.get_text().str() <
-                   b.listings.name.base.get_text().str();
-        };
-        hook_up(w.labels.base, base_acomp, base_dcomp);
-
-        // Market
-        auto market_acomp = [to_lower](auto const& a, auto const& b) {
-            return to_lower(a.listings.name.market.get_text().str()) >
-                   to_lower(b.listings.name.market.get_text().str());
-        };
-        auto market_dcomp = [to_lower](auto const& a, auto const& b) {
-            return to_lower(a.listings.name.market.get_text().str()) <
-                   to_lower(b.listings.name.market.get_text().str());
-        };
-        hook_up(w.labels.market, market_acomp, market_dcomp);
-
-        // Quote
-        auto quote_acomp = [to_lower](auto const& a, auto const& b) {
-            return to_lower(a.listings.name.quote.get_text().str()) >
-                   to_lower(b.listings.name.quote.get_text().str());
-        };
-        auto quote_dcomp = [to_lower](auto const& a, auto const& b) {
-            return to_lower(a.listings.name.quote.get_text().str()) <
-                   to_lower(b.listings.name.quote.get_text().str());
+        auto const hook_up = [&w](ox::HLabel& label, Sort_column column) {
+            label | on_mouse_press([&w, column](auto const& m) {
+                if (m.button == ox::Mouse::Button::Left)
+                    w.ticker_list.sort_by(column);
+            });
         };
-        hook_up(w.labels.quote, quote_acomp, quote_dcomp);
+        hook_up(w.labels.value, Sort_column::Value);
+        hook_up(w.labels.open_pl, Sort_column::Open_pl);
+        hook_up(w.labels.daily_pl, Sort_column::Daily_pl);
+        hook_up(w.labels.percent_change, Sort_column::Percent_change);
+        hook_up(w.labels.base, Sort_column::Base);
+        hook_up(w.labels.market, Sort_column::Market);
+        hook_up(w.labels.quote, Sort_column::Quote);
     }
 };
 
@@ -280,12 +558,54 @@ class Crabwise : public ox::VTuple<ox::Titlebar, App_space> {
     {
         titlebar.title.set_text(U"CrabWise" | ox::Trait::Bold);
         ox::Terminal::set_palette(crab::palette);
-        auto const init_assets = parse_init_file(assets_filepath());
-        for (auto const& [asset, quantity, cost_basis] : init_assets)
-            app_space.ticker_list.add_ticker(asset, quantity, cost_basis);
+        app_space.connect_daemon();
+        app_space.ticker_list.add_tickers(load_portfolio());
+        auto const snapshot = read_price_snapshot(price_snapshot_filepath());
+        if (!snapshot.empty()) {
+            app_space.ticker_list.warm_start(snapshot);
+            app_space.status_bar.set_status(
+                "Showing saved prices (~) until live prices arrive.");
+        }
+        app_space.load_alerts();
+        app_space.load_depth();
+        app_space.load_trades();
+        app_space.load_price_bus();
+        app_space.load_risk();
+        app_space.start_autosave();
+        app_space.start_jobs();
+    }
+
+    ~Crabwise()
+    {
+        try {
+            app_space.save_price_snapshot();
+        }
+        catch (std::exception const& e) {
+            log_error("Failed to save price snapshot: " +
+                      std::string{e.what()});
+        }
     }
 
    private:
+    /// Read assets.crab, or assets.txt if it has been edited since.
+    /** Falls back to assets.txt if assets.crab can't be read. */
+    [[nodiscard]] static auto load_portfolio() -> std::vector<Holding>
+    {
+        auto const binary = portfolio_filepath();
+        auto const text   = assets_filepath();
+        if (fs::exists(binary) &&
+            (!fs::exists(text) ||
+             fs::last_write_time(binary) >= fs::last_write_time(text))) {
+            try {
+                return read_portfolio(binary);
+            }
+            catch (std::exception const& e) {
+                log_error(e.what());
+            }
+        }
+        return parse_init_file(text);
+    }
+
     /// std::to_upper() each letter, returns ref to passed in modified string.
     [[nodiscard]] static auto upper(std::string& x) -> std::string&
     {
@@ -316,13 +636,12 @@ class Crabwise : public ox::VTuple<ox::Titlebar, App_space> {
         auto quote = std::string{};
         ss >> quote;
 
-        auto quantity = 0.;
-        if (ss)
-            ss >> quantity;
-        auto cost_basis = 0.;
-        if (ss)
-            ss >> cost_basis;
-        return {"", {upper(first), upper(quote)}, quantity, cost_basis};
+        auto quantity   = std::string{};
+        auto cost_basis = std::string{};
+        ss >> quantity >> cost_basis;
+        return {"", {upper(first), upper(quote)},
+                parse_double(quantity).value_or(0.),
+                parse_double(cost_basis).value_or(0.)};
     }
 
     /// Return true if string is all space characters or is empty.
@@ -346,11 +665,11 @@ class Crabwise : public ox::VTuple<ox::Titlebar, App_space> {
     //     Symbol Quantity Cost_basis
     // # Comment
     [[nodiscard]] static auto parse_init_file(fs::path const& filepath)
-        -> std::vector<std::tuple<Asset, double, double>>
+        -> std::vector<Holding>
     {
         if (!fs::exists(filepath))
             return {};
-        auto result = std::vector<std::tuple<Asset, double, double>>{};
+        auto result = std::vector<Holding>{};
         auto file   = std::ifstream{filepath.string()};
         auto line   = std::string{};
         auto current_exchange = std::string{};
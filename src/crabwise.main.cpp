@@ -6,18 +6,41 @@
 #include <termox/termox.hpp>
 
 #include "crabwise.hpp"
+#include "daemon.hpp"
 #include "filenames.hpp"
 #include "filesystem.hpp"
 #include "markets/error.hpp"
 #include "symbol_id_json.hpp"
+#include "thread_config.hpp"
 
 int main(int argc, char* argv[])
 {
+    // crabwise [--daemon] [--profile NAME] [key]
+    auto is_daemon = false;
+    auto key       = std::string_view{};
+    try {
+        for (auto i = 1; i < argc; ++i) {
+            auto const arg = std::string_view{argv[i]};
+            if (arg == "--daemon")
+                is_daemon = true;
+            else if (arg == "--profile") {
+                if (++i == argc)
+                    throw crab::Crab_error{"--profile needs a name."};
+                crab::set_profile(argv[i]);
+            }
+            else
+                key = arg;
+        }
+    }
+    catch (crab::Crab_error const& e) {
+        std::cerr << "Error: " << e.what() << '\n';
+        return 1;
+    }
+
     // Write key to file if does not exist
     try {
         auto const key_path = crab::finnhub_key_filepath();
-        if (argc > 1) {
-            auto key  = std::string_view{argv[1]};
+        if (!key.empty()) {
             auto file = std::ofstream{key_path.string()};
             file << key;
         }
@@ -34,6 +57,10 @@ int main(int argc, char* argv[])
         return 1;
     }
 
+    // The daemon has no asset picker, so needs no Symbol IDs.
+    if (is_daemon)
+        return crab::run_daemon();
+
     // Generate Symbol Ids from Finnhub, if they do not exist.
     if (!crab::fs::exists(crab::symbol_ids_json_filepath())) {
         try {
@@ -48,5 +75,7 @@ int main(int argc, char* argv[])
         }
     }
 
+    // The main thread runs TermOx input and rendering.
+    crab::enter_thread_role(crab::Thread_role::Ui, "crabwise");
     return ox::System{ox::Mouse_mode::Drag}.run<crab::Crabwise>();
 }
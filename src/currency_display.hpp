@@ -5,7 +5,7 @@
 
 #include <termox/termox.hpp>
 
-#include "format_money.hpp"
+#include "currency_registry.hpp"
 
 namespace crab {
 
@@ -25,8 +25,9 @@ class Currency_display : public ox::HLabel {
     /** Uses an underscore if no symbol found for the given currency. */
     void set(std::string x)
     {
-        currency_ = std::move(x);
-        this->ox::HLabel::set_text(currency_to_symbol(currency_));
+        currency_          = std::move(x);
+        auto const& symbol = currency_info(currency_).symbol;
+        this->ox::HLabel::set_text(std::string{symbol});
     }
 
     /// Return the string abbriviation currency was set with.
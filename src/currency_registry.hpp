@@ -0,0 +1,138 @@
+#ifndef CRAB_CURRENCY_REGISTRY_HPP
+#define CRAB_CURRENCY_REGISTRY_HPP
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace crab {
+
+enum class Currency_kind { Fiat, Stable, Crypto };
+
+/// Display and rounding rules of one currency.
+struct Currency_info {
+    std::string_view code;
+    std::string_view symbol;  // UTF-8, at most 3 cells wide.
+    Currency_kind kind;
+    int value_decimals;  // Rounding of values and P&L, -1 for none.
+};
+
+/// Every currency with a symbol. Adding a currency is one entry here.
+inline constexpr auto currencies = std::array{
+    // clang-format off
+    Currency_info{"USD",   "$",  Currency_kind::Fiat,   2},
+    Currency_info{"EUR",   "€",  Currency_kind::Fiat,   2},
+    Currency_info{"GBP",   "£",  Currency_kind::Fiat,   2},
+    Currency_info{"JPY",   "¥",  Currency_kind::Fiat,   2},
+    Currency_info{"CAD",   "$",  Currency_kind::Fiat,   2},
+    Currency_info{"CHF",   "₣",  Currency_kind::Fiat,   2},
+    Currency_info{"AUD",   "$",  Currency_kind::Fiat,   2},
+    Currency_info{"USDC",  "ᐥC", Currency_kind::Stable, 2},
+    Currency_info{"USDT",  "₮",  Currency_kind::Stable, 2},
+    Currency_info{"DAI",   "◈",  Currency_kind::Stable, 2},
+    Currency_info{"BTC",   "₿",  Currency_kind::Crypto, -1},
+    Currency_info{"XBT",   "₿",  Currency_kind::Crypto, -1},
+    Currency_info{"ETH",   "Ξ",  Currency_kind::Crypto, -1},
+    Currency_info{"XRP",   "✕",  Currency_kind::Crypto, -1},
+    Currency_info{"BCH",   "Ƀ",  Currency_kind::Crypto, -1},
+    Currency_info{"BSV",   "Ɓ",  Currency_kind::Crypto, -1},
+    Currency_info{"LTC",   "Ł",  Currency_kind::Crypto, -1},
+    Currency_info{"EOS",   "ε",  Currency_kind::Crypto, -1},
+    Currency_info{"ADA",   "₳",  Currency_kind::Crypto, -1},
+    Currency_info{"XTZ",   "ꜩ",  Currency_kind::Crypto, -1},
+    Currency_info{"XMR",   "ɱ",  Currency_kind::Crypto, -1},
+    Currency_info{"ETC",   "ξ",  Currency_kind::Crypto, -1},
+    Currency_info{"MKR",   "Μ",  Currency_kind::Crypto, -1},
+    Currency_info{"ZEC",   "ⓩ",  Currency_kind::Crypto, -1},
+    Currency_info{"DOGE",  "Ð",  Currency_kind::Crypto, -1},
+    Currency_info{"REP",   "Ɍ",  Currency_kind::Crypto, -1},
+    Currency_info{"REPV2", "Ɍ",  Currency_kind::Crypto, -1},
+    Currency_info{"STEEM", "ȿ",  Currency_kind::Crypto, -1},
+    // clang-format on
+};
+
+/// Returned for currencies not in the registry.
+inline constexpr auto unknown_currency =
+    Currency_info{"", "_", Currency_kind::Crypto, -1};
+
+namespace detail {
+
+inline constexpr auto currency_buckets = std::size_t{128};
+inline constexpr auto no_currency      = std::uint8_t{0xFF};
+
+static_assert(currencies.size() < currency_buckets / 2,
+              "Grow currency_buckets so a perfect hash is quick to find.");
+
+/// FNV-1a of \p code mixed with \p seed, finished so the low bits spread.
+[[nodiscard]] constexpr auto currency_hash(std::string_view code,
+                                           std::uint32_t seed) -> std::uint32_t
+{
+    auto h = std::uint32_t{2166136261u} ^ seed;
+    for (char const c : code) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 16777619u;
+    }
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    return h;
+}
+
+/// Bucket to index into currencies, no two codes share a bucket.
+struct Currency_hash {
+    std::uint32_t seed;
+    std::array<std::uint8_t, currency_buckets> index;
+};
+
+[[nodiscard]] constexpr auto has_unique_codes() -> bool
+{
+    for (auto i = std::size_t{0}; i < currencies.size(); ++i) {
+        for (auto j = i + 1; j < currencies.size(); ++j) {
+            if (currencies[i].code == currencies[j].code)
+                return false;
+        }
+    }
+    return true;
+}
+
+static_assert(has_unique_codes(), "Each currency code is listed once.");
+
+/// Try seeds until every code lands in its own bucket.
+[[nodiscard]] constexpr auto find_currency_hash() -> Currency_hash
+{
+    for (auto seed = std::uint32_t{0};; ++seed) {
+        auto result = Currency_hash{seed, {}};
+        for (auto& i : result.index)
+            i = no_currency;
+        auto collided = false;
+        for (auto i = std::size_t{0}; i < currencies.size() && !collided;
+             ++i) {
+            auto const hash = currency_hash(currencies[i].code, seed);
+            auto& bucket    = result.index[hash % currency_buckets];
+            collided        = bucket != no_currency;
+            bucket          = static_cast<std::uint8_t>(i);
+        }
+        if (!collided)
+            return result;
+    }
+}
+
+inline constexpr auto currency_lookup = find_currency_hash();
+
+}  // namespace detail
+
+/// Return the registry entry for \p code, or unknown_currency.
+/** One hash of the code and one string comparison. */
+[[nodiscard]] constexpr auto currency_info(std::string_view code)
+    -> Currency_info const&
+{
+    auto const& lookup = detail::currency_lookup;
+    auto const hash    = detail::currency_hash(code, lookup.seed);
+    auto const i       = lookup.index[hash % detail::currency_buckets];
+    if (i == detail::no_currency || currencies[i].code != code)
+        return unknown_currency;
+    return currencies[i];
+}
+
+}  // namespace crab
+#endif  // CRAB_CURRENCY_REGISTRY_HPP
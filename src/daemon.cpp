@@ -0,0 +1,568 @@
+#include "daemon.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <termox/system/event.hpp>
+#include <termox/system/event_loop.hpp>
+
+#include "asset.hpp"
+#include "filenames.hpp"
+#include "log.hpp"
+#include "markets/daemon_protocol.hpp"
+#include "markets/error.hpp"
+#include "markets/markets.hpp"
+#include "markets/reactor.hpp"
+#include "markets/rest_scheduler.hpp"
+#include "price.hpp"
+#include "price_bus_config.hpp"
+#include "stats.hpp"
+#include "thread_config.hpp"
+#include "trades_config.hpp"
+
+namespace {
+
+std::sig_atomic_t volatile stop_requested = 0;
+
+void request_stop(int) { stop_requested = 1; }
+
+using Client_id = std::uint64_t;
+
+/// One connected terminal view.
+struct Client {
+    int fd;
+    crab::Frame_splitter splitter;
+    std::string outbox;       // Encoded frames not yet written.
+    bool want_write = false;  // Current Reactor write interest.
+    bool greeted    = false;  // Has sent a Hello with a matching version.
+    std::set<crab::Asset> subscriptions;
+    std::set<crab::Asset> depth;
+    std::set<crab::Asset> stats_wanted;  // Requested and not yet delivered.
+};
+
+/// Markets calls left by changes to the Clients, made outside the lock.
+struct Changes {
+    std::vector<crab::Asset> subscribe;
+    std::vector<crab::Asset> unsubscribe;
+    std::vector<crab::Asset> subscribe_depth;
+    std::vector<crab::Asset> unsubscribe_depth;
+    std::vector<std::pair<crab::Rest_lane, std::vector<crab::Asset>>> stats;
+    std::optional<crab::Rest_lane> refresh;
+    std::optional<std::string> search;
+
+    [[nodiscard]] auto empty() const -> bool
+    {
+        return subscribe.empty() && unsubscribe.empty() &&
+               subscribe_depth.empty() && unsubscribe_depth.empty() &&
+               stats.empty() && !refresh.has_value() && !search.has_value();
+    }
+};
+
+/// A frame read from a Client, served on the Markets event side.
+using Request = std::pair<Client_id, std::string>;
+
+/// Serves a single Markets to every Client connected to the socket.
+/** Socket I/O runs in the loop function of loop_, Markets calls and signal
+ *  handlers run as Custom_events, mtx_ guards what both sides touch. */
+class Daemon {
+   public:
+    /// Slower clients are disconnected rather than buffered for.
+    static auto constexpr max_outbox = std::size_t{8} << 20;
+
+    /// Refresh_stats from any view is served at most this often.
+    static auto constexpr refresh_interval = std::chrono::seconds{60};
+
+   public:
+    /// Listen on \p path, throws Crab_error if it can't.
+    explicit Daemon(std::string path)
+        : path_{std::move(path)}, listen_fd_{crab::listen_unix(path_)}
+    {
+        reactor_.add(listen_fd_, false);
+        this->connect_signals();
+    }
+
+    Daemon(Daemon const&) = delete;
+    Daemon& operator=(Daemon const&) = delete;
+
+    ~Daemon()
+    {
+        markets_.shutdown();
+        for (auto const& [id, client] : clients_)
+            ::close(client.fd);
+        ::close(listen_fd_);
+        ::unlink(path_.c_str());
+    }
+
+   public:
+    /// Serve until SIGINT or SIGTERM, returns the exit code.
+    auto run() -> int
+    {
+        this->load_config();
+        markets_.launch_streams();
+        return loop_.run([this](ox::Event_queue& q) { this->serve_io(q); });
+    }
+
+   private:
+    std::string const path_;
+    int const listen_fd_;
+    crab::Reactor reactor_;
+    ox::Event_loop loop_;
+
+    std::mutex mtx_;
+    std::map<Client_id, Client> clients_;
+    std::map<int, Client_id> ids_;  // By fd, only touched by serve_io().
+    Client_id next_id_ = 0;
+
+    // Number of Clients subscribed to each Asset, streamed while non-zero.
+    std::map<crab::Asset, int> subscribers_;
+    std::map<crab::Asset, int> depth_watchers_;
+
+    // Replayed to Clients that subscribe to an already streamed Asset.
+    std::map<crab::Asset, crab::Price> last_price_;
+    std::map<crab::Asset, crab::Stats> last_stats_;
+
+    std::optional<Client_id> searcher_;  // Sent the latest search.
+    std::uint64_t search_generation_ = 0;  // Of the latest search, echoed.
+    std::optional<std::chrono::steady_clock::time_point> last_refresh_;
+
+    crab::Markets markets_;  // Last, its handlers use everything above.
+
+   private:
+    /// Apply trades.txt and price_bus.txt, as a terminal view would.
+    void load_config()
+    {
+        auto const window = crab::read_trade_window(crab::trades_filepath());
+        if (window.has_value())
+            markets_.set_trade_window(*window);
+        auto const bus =
+            crab::read_price_bus_config(crab::price_bus_filepath());
+        if (!bus.has_value())
+            return;
+        try {
+            markets_.open_price_bus(bus->name, bus->slot_count);
+            crab::log_status("Daemon: publishing prices to " + bus->name);
+        }
+        catch (crab::Crab_error const& e) {
+            crab::log_error(e.what());
+        }
+    }
+
+    void connect_signals()
+    {
+        using namespace crab;
+        markets_.price_update.connect(
+            [this](std::vector<Price> const& prices) {
+                auto const lock = std::lock_guard{mtx_};
+                for (auto const& price : prices) {
+                    last_price_[price.asset] = price;
+                    this->post(&Client::subscriptions, price.asset,
+                               price_frame(price));
+                }
+            });
+        markets_.stats_received.connect(
+            [this](Asset const& asset, Stats const& stats) {
+                auto const lock = std::lock_guard{mtx_};
+                if (subscribers_.count(asset) != 0)
+                    last_stats_[asset] = stats;
+                auto const frame = stats_frame(asset, stats);
+                for (auto& [id, client] : clients_) {
+                    if (client.stats_wanted.erase(asset) != 0 ||
+                        client.subscriptions.count(asset) != 0) {
+                        client.outbox += frame;
+                    }
+                }
+                reactor_.wake();
+            });
+        markets_.trades_update.connect(
+            [this](Asset const& asset, Trade_summary const& summary) {
+                auto const lock = std::lock_guard{mtx_};
+                this->post(&Client::subscriptions, asset,
+                           trades_frame(asset, summary));
+            });
+        markets_.depth_update.connect(
+            [this](Asset const& asset, Depth const& depth) {
+                auto const lock = std::lock_guard{mtx_};
+                this->post(&Client::depth, asset, depth_frame(asset, depth));
+            });
+        markets_.search_results_received.connect(
+            [this](std::vector<Search_result> const& results) {
+                auto const lock = std::lock_guard{mtx_};
+                this->post_searcher(
+                    search_results_frame(search_generation_, results));
+            });
+        markets_.search_finished.connect([this] {
+            auto const lock = std::lock_guard{mtx_};
+            this->post_searcher(search_finished_frame(search_generation_));
+        });
+    }
+
+    /// Queue \p frame to every Client with \p asset in its \p set.
+    /** Call with mtx_ held. */
+    void post(std::set<crab::Asset> Client::*set,
+              crab::Asset const& asset,
+              std::string const& frame)
+    {
+        for (auto& [id, client] : clients_) {
+            if ((client.*set).count(asset) != 0)
+                client.outbox += frame;
+        }
+        reactor_.wake();
+    }
+
+    /// Queue \p frame to the Client that sent the latest search, if any.
+    /** Call with mtx_ held. */
+    void post_searcher(std::string const& frame)
+    {
+        if (!searcher_.has_value())
+            return;
+        auto const at = clients_.find(*searcher_);
+        if (at == std::end(clients_))
+            return;
+        at->second.outbox += frame;
+        reactor_.wake();
+    }
+
+    /// Accept, read and write whatever the sockets are ready for.
+    /** Frames read are served as a single Custom_event. */
+    void serve_io(ox::Event_queue& q)
+    {
+        if (stop_requested != 0) {
+            loop_.exit(0);
+            return;
+        }
+        auto const ready = reactor_.wait(std::chrono::milliseconds{100});
+        auto requests    = std::vector<Request>{};
+        auto changes     = Changes{};
+        {
+            auto const lock = std::lock_guard{mtx_};
+            auto lost       = std::vector<Client_id>{};
+            for (auto const& r : ready) {
+                if (r.fd == listen_fd_) {
+                    this->accept_all();
+                    continue;
+                }
+                auto const at = ids_.find(r.fd);
+                if (at == std::end(ids_))
+                    continue;
+                if (r.readable &&
+                    !this->read_from(at->second, clients_.at(at->second),
+                                     requests)) {
+                    lost.push_back(at->second);
+                }
+            }
+            for (auto& [id, client] : clients_) {
+                if (!this->write_to(client))
+                    lost.push_back(id);
+            }
+            for (auto const id : lost)
+                this->disconnect(id, changes);
+        }
+        if (requests.empty() && changes.empty())
+            return;
+        q.append(ox::Custom_event{
+            [this, requests = std::move(requests),
+             changes = std::move(changes)]() mutable {
+                this->serve(requests, changes);
+            }});
+    }
+
+    /// Take every pending connection, each is greeted with a Hello.
+    /** Call with mtx_ held. */
+    void accept_all()
+    {
+        while (true) {
+            auto const fd = ::accept(listen_fd_, nullptr, nullptr);
+            if (fd == -1) {
+                if (errno == EINTR)
+                    continue;
+                return;  // EAGAIN, or nothing to be done for this one.
+            }
+            if (::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK) ==
+                -1) {
+                ::close(fd);
+                continue;
+            }
+            auto const id     = next_id_++;
+            auto& client      = clients_[id];
+            client.fd         = fd;
+            client.outbox     = crab::hello_frame();
+            client.want_write = true;
+            ids_[fd]          = id;
+            reactor_.add(fd, true);
+            crab::log_status("Daemon: view connected");
+        }
+    }
+
+    /// Read what is available from \p client, appending its requests.
+    /** Returns false if the client has gone away or misbehaved. Hello is
+     *  answered here, anything sent before it disconnects the client. Call
+     *  with mtx_ held. */
+    auto read_from(Client_id id, Client& client, std::vector<Request>& out)
+        -> bool
+    {
+        char buffer[65'536];
+        while (true) {
+            auto const n = ::recv(client.fd, buffer, sizeof(buffer), 0);
+            if (n > 0)
+                client.splitter.append(buffer, static_cast<std::size_t>(n));
+            else if (n == -1 && errno == EINTR)
+                continue;
+            else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            else
+                return false;
+        }
+        try {
+            auto frame = std::string{};
+            while (client.splitter.next(frame)) {
+                auto r = crab::Frame_reader{frame};
+                if (r.kind() == crab::Frame_kind::Hello) {
+                    if (r.u32() != crab::daemon_protocol_version)
+                        return false;
+                    client.greeted = true;
+                }
+                else if (!client.greeted)
+                    return false;
+                else
+                    out.push_back({id, std::move(frame)});
+            }
+        }
+        catch (crab::Crab_error const& e) {
+            crab::log_error(std::string{"Daemon: "} + e.what());
+            return false;
+        }
+        return true;
+    }
+
+    /// Write as much of the outbox of \p client as the socket takes.
+    /** Returns false if the client has gone away or fallen too far behind.
+     *  Call with mtx_ held. */
+    auto write_to(Client& client) -> bool
+    {
+        auto sent = std::size_t{0};
+        while (sent != client.outbox.size()) {
+            auto const n = crab::send_some(
+                client.fd, std::string_view{client.outbox}.substr(sent));
+            if (n > 0)
+                sent += static_cast<std::size_t>(n);
+            else if (n == -1 && errno == EINTR)
+                continue;
+            else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            else
+                return false;
+        }
+        client.outbox.erase(0, sent);
+        if (client.outbox.size() > max_outbox) {
+            crab::log_error("Daemon: dropping a view that is too slow");
+            return false;
+        }
+        auto const want_write = !client.outbox.empty();
+        if (want_write != client.want_write) {
+            reactor_.modify(client.fd, want_write);
+            client.want_write = want_write;
+        }
+        return true;
+    }
+
+    /// Close the connection to \p id and release everything it watched.
+    /** Call with mtx_ held. */
+    void disconnect(Client_id id, Changes& changes)
+    {
+        auto const at = clients_.find(id);
+        if (at == std::end(clients_))
+            return;
+        auto& client = at->second;
+        for (auto const& asset : client.subscriptions)
+            this->release_price(asset, changes);
+        for (auto const& asset : client.depth)
+            this->release_depth(asset, changes);
+        reactor_.remove(client.fd);
+        ::close(client.fd);
+        ids_.erase(client.fd);
+        clients_.erase(at);
+        if (searcher_ == id)
+            searcher_.reset();
+        crab::log_status("Daemon: view disconnected");
+    }
+
+    /// Serve \p requests and make the Markets calls they and \p changes need.
+    /** Runs as a Custom_event, like the Markets signal handlers. */
+    void serve(std::vector<Request> const& requests, Changes& changes)
+    {
+        {
+            auto const lock = std::lock_guard{mtx_};
+            for (auto const& [id, frame] : requests) {
+                auto const at = clients_.find(id);
+                if (at == std::end(clients_))
+                    continue;  // Disconnected since.
+                try {
+                    this->serve(id, at->second, frame, changes);
+                }
+                catch (crab::Crab_error const& e) {
+                    crab::log_error(std::string{"Daemon: "} + e.what());
+                }
+            }
+            reactor_.wake();
+        }
+        if (!changes.subscribe.empty())
+            markets_.subscribe(changes.subscribe);
+        for (auto const& asset : changes.unsubscribe)
+            markets_.unsubscribe(asset);
+        for (auto const& asset : changes.subscribe_depth)
+            markets_.subscribe_depth(asset);
+        for (auto const& asset : changes.unsubscribe_depth)
+            markets_.unsubscribe_depth(asset);
+        for (auto const& [lane, batch] : changes.stats)
+            markets_.request_stats(batch, lane);
+        if (changes.refresh.has_value())
+            markets_.refresh_stats(*changes.refresh);
+        if (changes.search.has_value())
+            markets_.request_search(*changes.search);
+    }
+
+    /// Serve a single \p frame from \p client. Call with mtx_ held.
+    /** Throws Crab_error if \p frame is malformed. */
+    void serve(Client_id id,
+               Client& client,
+               std::string const& frame,
+               Changes& changes)
+    {
+        using crab::Frame_kind;
+        auto r = crab::Frame_reader{frame};
+        switch (r.kind()) {
+            case Frame_kind::Subscribe:
+                for (auto const& asset : crab::read_assets(r)) {
+                    if (!client.subscriptions.insert(asset).second)
+                        continue;
+                    if (++subscribers_[asset] == 1)
+                        changes.subscribe.push_back(asset);
+                    else if (auto const at = last_price_.find(asset);
+                             at != std::end(last_price_)) {
+                        client.outbox += crab::price_frame(at->second);
+                    }
+                }
+                break;
+            case Frame_kind::Unsubscribe:
+                for (auto const& asset : crab::read_assets(r)) {
+                    if (client.subscriptions.erase(asset) != 0)
+                        this->release_price(asset, changes);
+                }
+                break;
+            case Frame_kind::Subscribe_depth:
+                for (auto const& asset : crab::read_assets(r)) {
+                    if (client.depth.insert(asset).second &&
+                        ++depth_watchers_[asset] == 1) {
+                        changes.subscribe_depth.push_back(asset);
+                    }
+                }
+                break;
+            case Frame_kind::Unsubscribe_depth:
+                for (auto const& asset : crab::read_assets(r)) {
+                    if (client.depth.erase(asset) != 0)
+                        this->release_depth(asset, changes);
+                }
+                break;
+            case Frame_kind::Request_stats: {
+                auto const lane = crab::read_lane(r);
+                auto batch      = std::vector<crab::Asset>{};
+                for (auto const& asset : crab::read_assets(r)) {
+                    auto const at = last_stats_.find(asset);
+                    if (at != std::end(last_stats_))
+                        client.outbox += crab::stats_frame(asset, at->second);
+                    else if (client.stats_wanted.insert(asset).second)
+                        batch.push_back(asset);
+                }
+                if (!batch.empty())
+                    changes.stats.push_back({lane, std::move(batch)});
+            } break;
+            case Frame_kind::Refresh_stats: {
+                auto const lane = crab::read_lane(r);
+                auto const now  = std::chrono::steady_clock::now();
+                if (last_refresh_.has_value() &&
+                    now - *last_refresh_ < refresh_interval) {
+                    break;
+                }
+                last_refresh_   = now;
+                changes.refresh = lane;
+            } break;
+            case Frame_kind::Search:
+                searcher_          = id;
+                search_generation_ = r.u64();
+                changes.search     = r.text();
+                break;
+            default:
+                throw crab::Crab_error{"unexpected frame from a view"};
+        }
+    }
+
+    /// Drop one subscriber of \p asset, unsubscribing after the last.
+    void release_price(crab::Asset const& asset, Changes& changes)
+    {
+        auto const at = subscribers_.find(asset);
+        if (at == std::end(subscribers_) || --at->second != 0)
+            return;
+        subscribers_.erase(at);
+        last_price_.erase(asset);
+        last_stats_.erase(asset);
+        changes.unsubscribe.push_back(asset);
+    }
+
+    /// Drop one watcher of the order book of \p asset.
+    void release_depth(crab::Asset const& asset, Changes& changes)
+    {
+        auto const at = depth_watchers_.find(asset);
+        if (at == std::end(depth_watchers_) || --at->second != 0)
+            return;
+        depth_watchers_.erase(at);
+        changes.unsubscribe_depth.push_back(asset);
+    }
+};
+
+}  // namespace
+
+namespace crab {
+
+auto run_daemon() -> int
+{
+    enter_thread_role(Thread_role::Ui, "crab-daemon");
+    try {
+        auto const path = daemon_socket_filepath().string();
+        try {
+            ::close(connect_unix(path));
+            std::cerr << "A daemon is already serving " << path << '\n';
+            return 1;
+        }
+        catch (Crab_error const&) {
+            ::unlink(path.c_str());  // Left behind by a crash, if anything.
+        }
+        auto daemon = Daemon{path};
+        std::signal(SIGINT, request_stop);
+        std::signal(SIGTERM, request_stop);
+        std::cout << "CrabWise daemon serving " << path << '\n';
+        return daemon.run();
+    }
+    catch (std::exception const& e) {
+        std::cerr << "Error: " << e.what() << '\n';
+        return 1;
+    }
+}
+
+}  // namespace crab
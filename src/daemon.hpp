@@ -0,0 +1,13 @@
+#ifndef CRAB_DAEMON_HPP
+#define CRAB_DAEMON_HPP
+
+namespace crab {
+
+/// Run crabwise --daemon until SIGINT or SIGTERM, returns the exit code.
+/** Owns the market connections and serves any number of terminal views over
+ *  the Unix socket at daemon_socket_filepath(). Each asset is subscribed to
+ *  once however many views list it. Fails if another daemon is running. */
+[[nodiscard]] auto run_daemon() -> int;
+
+}  // namespace crab
+#endif  // CRAB_DAEMON_HPP
@@ -0,0 +1,58 @@
+#include "depth_list.hpp"
+
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "asset.hpp"
+#include "filesystem.hpp"
+#include "log.hpp"
+
+namespace {
+
+// depth.txt Format, grouped under exchange headers like assets.txt:
+// Coinbase:
+//     Base Quote
+
+[[nodiscard]] auto upper(std::string x) -> std::string
+{
+    for (char& c : x)
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    return x;
+}
+
+}  // namespace
+
+namespace crab {
+
+auto read_depth_list(fs::path const& filepath) -> std::vector<Asset>
+{
+    if (!fs::exists(filepath))
+        return {};
+    auto result   = std::vector<Asset>{};
+    auto file     = std::ifstream{filepath.string()};
+    auto line     = std::string{};
+    auto exchange = std::string{};
+    while (std::getline(file, line, '\n')) {
+        auto ss    = std::istringstream{line};
+        auto first = std::string{};
+        if (!(ss >> first) || first.front() == '#')
+            continue;
+        if (first.back() == ':') {
+            first.pop_back();
+            exchange = upper(first);
+            continue;
+        }
+        auto quote = std::string{};
+        if (exchange.empty() || !(ss >> quote)) {
+            log_error("depth.txt skipped malformed line: " + line);
+            continue;
+        }
+        result.push_back({exchange, {upper(first), upper(quote)}});
+    }
+    return result;
+}
+
+}  // namespace crab
@@ -0,0 +1,17 @@
+#ifndef CRAB_DEPTH_LIST_HPP
+#define CRAB_DEPTH_LIST_HPP
+#include <vector>
+
+#include "asset.hpp"
+#include "filesystem.hpp"
+
+namespace crab {
+
+/// Read the Assets listed in the depth.txt file at \p filepath.
+/** These get a live order book. Returns an empty vector if the file does not
+ *  exist, malformed lines are logged and skipped. */
+[[nodiscard]] auto read_depth_list(fs::path const& filepath)
+    -> std::vector<Asset>;
+
+}  // namespace crab
+#endif  // CRAB_DEPTH_LIST_HPP
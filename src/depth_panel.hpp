@@ -0,0 +1,147 @@
+#ifndef CRAB_DEPTH_PANEL_HPP
+#define CRAB_DEPTH_PANEL_HPP
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string>
+
+#include <termox/termox.hpp>
+
+#include "asset.hpp"
+#include "format_money.hpp"
+#include "markets/order_book.hpp"
+#include "palette.hpp"
+
+namespace crab {
+
+/// Best bid and ask, spread and the top levels of one Asset's order book.
+/** Shows the Asset passed to show(), Depths of any other Asset are ignored.
+ *  Bids are on the left, highest first, asks on the right, lowest first. */
+class Depth_panel : public ox::layout::Vertical<ox::HLabel> {
+   public:
+    /// Levels shown per side.
+    static auto constexpr rows = std::size_t{5};
+
+    static_assert(rows <= Depth::max_levels);
+
+   public:
+    Depth_panel()
+    {
+        using namespace ox::pipe;
+        title_ = &this->make_child();
+        for (auto& row : rows_)
+            row = &this->make_child();
+        *this | fixed_height(rows + 1) | descendants() | bg(crab::Almost_bg);
+        this->show_none();
+    }
+
+   public:
+    /// Show the book of \p asset, blank until its first Depth arrives.
+    void show(Asset const& asset)
+    {
+        asset_ = asset;
+        this->set_title(ox::Glyph_string{label(asset) + "  waiting for book"} |
+                        ox::Trait::Dim);
+        for (auto* row : rows_)
+            row->set_text(U"");
+    }
+
+    /// Show that no order book is kept for \p asset.
+    void show_unavailable(Asset const& asset)
+    {
+        asset_.reset();
+        this->set_title(
+            ox::Glyph_string{label(asset) +
+                             "  no order book, list it in depth.txt"} |
+            ox::Trait::Dim);
+        for (auto* row : rows_)
+            row->set_text(U"");
+    }
+
+    /// Display \p depth if it is of the Asset being shown.
+    void update(Asset const& asset, Depth const& depth)
+    {
+        if (!asset_.has_value() || *asset_ != asset)
+            return;
+        auto title = label(asset);
+        if (depth.bid_count != 0)
+            title.append("  Bid ").append(to_text(depth.bids[0].price));
+        if (depth.ask_count != 0)
+            title.append("  Ask ").append(to_text(depth.asks[0].price));
+        if (auto const spread = depth.spread(); spread.has_value()) {
+            auto const mid = (depth.bids[0].price + depth.asks[0].price) / 2.;
+            title.append("  Spread ").append(to_text(*spread));
+            if (mid != 0.) {
+                title.append(" (")
+                    .append(round_and_to_string(100. * *spread / mid, 3))
+                    .append("%)");
+            }
+        }
+        this->set_title(title);
+        for (auto i = std::size_t{0}; i < rows; ++i) {
+            auto line = std::string{};
+            if (i < depth.bid_count) {
+                line.append(pad_left(to_text(depth.bids[i].size), 18))
+                    .append(pad_left(to_text(depth.bids[i].price), 18));
+            }
+            else
+                line.append(36, ' ');
+            line.append("  │  ");
+            if (i < depth.ask_count) {
+                line.append(pad_right(to_text(depth.asks[i].price), 18))
+                    .append(to_text(depth.asks[i].size));
+            }
+            rows_[i]->set_text(line);
+        }
+    }
+
+   private:
+    ox::HLabel* title_;
+    std::array<ox::HLabel*, rows> rows_;
+    std::optional<Asset> asset_;
+
+   private:
+    void show_none()
+    {
+        this->set_title(U"select a ticker" | ox::Trait::Dim);
+    }
+
+    /// Set the title line to the panel name followed by \p x.
+    void set_title(ox::Glyph_string const& x)
+    {
+        title_->set_text((U" Depth " | ox::Trait::Bold).append(x));
+    }
+
+    [[nodiscard]] static auto label(Asset const& asset) -> std::string
+    {
+        return asset.currency.base + '/' + asset.currency.quote;
+    }
+
+    /// Up to eight decimals, trailing zeros trimmed, thousands separated.
+    [[nodiscard]] static auto to_text(double x) -> std::string
+    {
+        auto result = round_and_to_string(x, 8);
+        format_decimal_zeros(result);
+        insert_thousands_separators(result);
+        return result;
+    }
+
+    [[nodiscard]] static auto pad_left(std::string x, std::size_t width)
+        -> std::string
+    {
+        if (x.size() < width)
+            x.insert(0, width - x.size(), ' ');
+        return x;
+    }
+
+    [[nodiscard]] static auto pad_right(std::string x, std::size_t width)
+        -> std::string
+    {
+        if (x.size() < width)
+            x.append(width - x.size(), ' ');
+        return x;
+    }
+};
+
+}  // namespace crab
+#endif  // CRAB_DEPTH_PANEL_HPP
@@ -2,6 +2,7 @@
 #define CRAB_FILENAMES_HPP
 #include <cstdlib>
 #include <string>
+#include <utility>
 
 #include "filesystem.hpp"
 #include "markets/error.hpp"
@@ -52,6 +53,49 @@ namespace crab {
     return data;
 }
 
+namespace detail {
+
+/// Name given to --profile, empty for the default profile.
+[[nodiscard]] inline auto profile_name() -> std::string&
+{
+    static auto name = std::string{};
+    return name;
+}
+
+}  // namespace detail
+
+/// Keep the portfolio, alerts and view settings in a profile named \p name.
+/** Call before any file of the profile is read. Throws Crab_error if \p name
+ *  is empty or is not a plain directory name. */
+inline void set_profile(std::string name)
+{
+    if (name.empty() || name == "." || name == ".." ||
+        name.find('/') != std::string::npos) {
+        throw Crab_error{"Invalid profile name: '" + name + "'."};
+    }
+    detail::profile_name() = std::move(name);
+}
+
+/// Return the directory of the files that belong to one view.
+/** ~/Documents/crabwise by default, ~/Documents/crabwise/profiles/<name>
+ *  after set_profile(). Makes the directory if it does not exist. Market
+ *  data files stay in crabwise_data_directory(), shared by every profile. */
+[[nodiscard]] inline auto profile_directory() -> fs::path
+{
+    auto const& name = detail::profile_name();
+    if (name.empty())
+        return crabwise_data_directory();
+    auto const profile = crabwise_data_directory() / "profiles" / name;
+    try {
+        fs::create_directories(profile);
+    }
+    catch (fs::filesystem_error const& e) {
+        throw Crab_error{"Error when creating profile directory: " +
+                         std::string{e.what()}};
+    }
+    return profile;
+}
+
 /// Return path to finnhub.key file, file might not exist yet.
 [[nodiscard]] inline auto finnhub_key_filepath() -> fs::path
 {
@@ -61,7 +105,61 @@ namespace crab {
 /// Return path to assets.txt file, file might not exist yet.
 [[nodiscard]] inline auto assets_filepath() -> fs::path
 {
-    return crabwise_data_directory() / "assets.txt";
+    return profile_directory() / "assets.txt";
+}
+
+/// Return path to assets.crab binary portfolio, file might not exist yet.
+[[nodiscard]] inline auto portfolio_filepath() -> fs::path
+{
+    return profile_directory() / "assets.crab";
+}
+
+/// Return path to snapshot.txt file, file might not exist yet.
+[[nodiscard]] inline auto price_snapshot_filepath() -> fs::path
+{
+    return profile_directory() / "snapshot.txt";
+}
+
+/// Return path to alerts.txt file, file might not exist yet.
+[[nodiscard]] inline auto alerts_filepath() -> fs::path
+{
+    return profile_directory() / "alerts.txt";
+}
+
+/// Return path to threads.txt file, file might not exist yet.
+[[nodiscard]] inline auto threads_filepath() -> fs::path
+{
+    return crabwise_data_directory() / "threads.txt";
+}
+
+/// Return path to depth.txt file, file might not exist yet.
+[[nodiscard]] inline auto depth_filepath() -> fs::path
+{
+    return profile_directory() / "depth.txt";
+}
+
+/// Return path to trades.txt file, file might not exist yet.
+[[nodiscard]] inline auto trades_filepath() -> fs::path
+{
+    return crabwise_data_directory() / "trades.txt";
+}
+
+/// Return path to risk.txt file, file might not exist yet.
+[[nodiscard]] inline auto risk_filepath() -> fs::path
+{
+    return profile_directory() / "risk.txt";
+}
+
+/// Return path to price_bus.txt file, file might not exist yet.
+[[nodiscard]] inline auto price_bus_filepath() -> fs::path
+{
+    return crabwise_data_directory() / "price_bus.txt";
+}
+
+/// Return path to the Unix socket of crabwise --daemon.
+[[nodiscard]] inline auto daemon_socket_filepath() -> fs::path
+{
+    return crabwise_data_directory() / "crabwise.sock";
 }
 
 /// Return path to crabwise.log file, file might not exist yet.
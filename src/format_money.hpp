@@ -7,7 +7,6 @@
 #include <iterator>
 #include <sstream>
 #include <string>
-#include <string_view>
 
 namespace crab {
 
@@ -51,76 +50,6 @@ inline void format_decimal_zeros(std::string& value)
     return ss.str();
 }
 
-[[nodiscard]] inline auto currency_to_symbol(std::string const& x)
-    -> std::string
-{
-    if (x == "USD")
-        return "$";
-    if (x == "ETH")
-        return "Ξ";
-    if (x == "BTC")
-        return "₿";
-    if (x == "XBT")
-        return "₿";
-    if (x == "EUR")
-        return "€";
-    if (x == "GBP")
-        return "£";
-    if (x == "DAI")
-        return "◈";
-    if (x == "USDC")
-        return "ᐥC";
-    if (x == "USDT")
-        return "₮";
-    if (x == "XRP")
-        return "✕";
-    if (x == "BCH")
-        return "Ƀ";
-    if (x == "BSV")
-        return "Ɓ";
-    if (x == "LTC")
-        return "Ł";
-    if (x == "EOS")
-        return "ε";
-    if (x == "ADA")
-        return "₳";
-    if (x == "XTZ")
-        return "ꜩ";
-    if (x == "XMR")
-        return "ɱ";
-    if (x == "ETC")
-        return "ξ";
-    if (x == "MKR")
-        return "Μ";
-    if (x == "ZEC")
-        return "ⓩ";
-    if (x == "DOGE")
-        return "Ð";
-    if (x == "REP")
-        return "Ɍ";
-    if (x == "REPV2")
-        return "Ɍ";
-    if (x == "STEEM")
-        return "ȿ";
-    if (x == "JPY")
-        return "¥";
-    if (x == "CAD")
-        return "$";
-    if (x == "CHF")
-        return "₣";
-    if (x == "AUD")
-        return "$";
-    return "_";
-}
-
-/// Returns true if the currency is directly related to USD or is USD.
-/** Used to determine rounding on Value column. */
-[[nodiscard]] inline auto is_USD_like(std::string_view x) -> bool
-{
-    return (x == "USD" || x == "EUR" || x == "GBP" || x == "USDC" ||
-            x == "USDT" || x == "CAD" || x == "CHF" || x == "AUD");
-}
-
 /// Inserts space at front of \p value to align decimal place to \p offset.
 /** Should be applied after thousands separators are inserted. */
 [[nodiscard]] inline auto align_decimal(std::string const& value,
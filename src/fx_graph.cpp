@@ -0,0 +1,149 @@
+#include "fx_graph.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "currency_pair.hpp"
+
+namespace crab {
+
+Fx_graph::Fx_graph(std::string reporting)
+{
+    root_                = this->node_id(reporting);
+    nodes_[root_].factor = 1.;
+}
+
+auto Fx_graph::set_rate(Currency_pair const& pair, double price)
+    -> std::vector<std::string>
+{
+    auto changed = std::vector<std::string>{};
+    if (!(price > 0.) || pair.base == pair.quote)
+        return changed;
+    auto const base  = this->node_id(pair.base);
+    auto const quote = this->node_id(pair.quote);
+    auto const key   = std::pair{base, quote};
+    auto const at    = edge_ids_.find(key);
+    if (at == std::end(edge_ids_)) {
+        auto const edge = edges_.size();
+        edges_.push_back({base, quote, price});
+        edge_ids_.emplace(key, edge);
+        nodes_[base].edges.push_back(edge);
+        nodes_[quote].edges.push_back(edge);
+        auto before = std::vector<std::optional<double>>{};
+        for (auto const& node : nodes_)
+            before.push_back(node.factor);
+        this->rebuild_paths();
+        for (auto i = std::size_t{0}; i < nodes_.size(); ++i) {
+            if (nodes_[i].factor != before[i])
+                changed.push_back(nodes_[i].name);
+        }
+        return changed;
+    }
+    auto const edge    = at->second;
+    edges_[edge].price = price;
+    // Only the end of a path edge that is further from reporting depends on it.
+    for (auto const node : {base, quote}) {
+        if (nodes_[node].parent_edge == edge)
+            this->refresh_subtree(node, changed);
+    }
+    return changed;
+}
+
+auto Fx_graph::factor(std::string const& currency) const
+    -> std::optional<double>
+{
+    auto const at = node_ids_.find(currency);
+    if (at == std::end(node_ids_))
+        return std::nullopt;
+    return nodes_[at->second].factor;
+}
+
+auto Fx_graph::node_id(std::string const& currency) -> std::size_t
+{
+    auto const [at, is_new] = node_ids_.emplace(currency, nodes_.size());
+    if (is_new)
+        nodes_.push_back({currency, {}, std::nullopt, {}, std::nullopt});
+    return at->second;
+}
+
+auto Fx_graph::factor_via_parent(std::size_t node) const -> double
+{
+    auto const& edge  = edges_[*nodes_[node].parent_edge];
+    auto const parent = edge.base == node ? edge.quote : edge.base;
+    auto const rate   = edge.base == node ? edge.price : 1. / edge.price;
+    return rate * *nodes_[parent].factor;
+}
+
+void Fx_graph::rebuild_paths()
+{
+    for (auto& node : nodes_) {
+        node.parent_edge.reset();
+        node.children.clear();
+        node.factor.reset();
+    }
+    nodes_[root_].factor = 1.;
+    auto queue           = std::deque<std::size_t>{root_};
+    while (!queue.empty()) {
+        auto const current = queue.front();
+        queue.pop_front();
+        for (auto const e : nodes_[current].edges) {
+            auto const& edge = edges_[e];
+            auto const next  = edge.base == current ? edge.quote : edge.base;
+            if (nodes_[next].factor.has_value())
+                continue;
+            nodes_[next].parent_edge = e;
+            nodes_[next].factor      = this->factor_via_parent(next);
+            nodes_[current].children.push_back(next);
+            queue.push_back(next);
+        }
+    }
+}
+
+void Fx_graph::refresh_subtree(std::size_t node,
+                               std::vector<std::string>& changed)
+{
+    auto stack = std::vector<std::size_t>{node};
+    while (!stack.empty()) {
+        auto const current = stack.back();
+        stack.pop_back();
+        nodes_[current].factor = this->factor_via_parent(current);
+        changed.push_back(nodes_[current].name);
+        stack.insert(std::end(stack), std::begin(nodes_[current].children),
+                     std::end(nodes_[current].children));
+    }
+}
+
+auto Consolidated_totals::set_rate(Currency_pair const& pair, double price)
+    -> bool
+{
+    auto const changed = graph_.set_rate(pair, price);
+    return std::any_of(std::begin(changed), std::end(changed),
+                       [this](std::string const& currency) {
+                           return quotes_.count(currency) != 0;
+                       });
+}
+
+auto Consolidated_totals::totals() const -> Totals
+{
+    auto result = Totals{};
+    for (auto const& [quote, sums] : quotes_) {
+        auto const factor = graph_.factor(quote);
+        if (!factor.has_value()) {
+            if (sums.value != 0. || sums.open_pl != 0. || sums.daily_pl != 0.)
+                result.complete = false;
+            continue;
+        }
+        result.value += sums.value * *factor;
+        result.open_pl += sums.open_pl * *factor;
+        result.daily_pl += sums.daily_pl * *factor;
+    }
+    return result;
+}
+
+}  // namespace crab
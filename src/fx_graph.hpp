@@ -0,0 +1,129 @@
+#ifndef CRAB_FX_GRAPH_HPP
+#define CRAB_FX_GRAPH_HPP
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "currency_pair.hpp"
+
+namespace crab {
+
+/// Converts amounts to a reporting currency through streamed exchange rates.
+/** Each currency pair is an edge between its two currencies. Conversions
+ *  follow the fewest hops to the reporting currency, found by a breadth first
+ *  search that is only redone when a new pair is added. A rate change only
+ *  recomputes the currencies that convert through that pair. */
+class Fx_graph {
+   public:
+    explicit Fx_graph(std::string reporting);
+
+   public:
+    /// Set the price of one \p pair.base in \p pair.quote.
+    /** Returns the currencies whose conversion factor changed. */
+    auto set_rate(Currency_pair const& pair, double price)
+        -> std::vector<std::string>;
+
+    /// Return the factor converting an amount in \p currency to reporting.
+    /** Returns std::nullopt if there is no path of known rates. */
+    [[nodiscard]] auto factor(std::string const& currency) const
+        -> std::optional<double>;
+
+    [[nodiscard]] auto reporting() const -> std::string const&
+    {
+        return nodes_[root_].name;
+    }
+
+   private:
+    struct Edge {
+        std::size_t base;
+        std::size_t quote;
+        double price;
+    };
+
+    struct Node {
+        std::string name;
+        std::vector<std::size_t> edges;
+        std::optional<std::size_t> parent_edge;  // Next hop to reporting.
+        std::vector<std::size_t> children;       // Nodes that hop to this.
+        std::optional<double> factor;
+    };
+
+    std::vector<Node> nodes_;
+    std::vector<Edge> edges_;
+    std::map<std::string, std::size_t> node_ids_;
+    std::map<std::pair<std::size_t, std::size_t>, std::size_t> edge_ids_;
+    std::size_t root_;
+
+   private:
+    /// Return the id of the node for \p currency, adding it if new.
+    auto node_id(std::string const& currency) -> std::size_t;
+
+    /// Return the factor of \p node from its parent's factor.
+    [[nodiscard]] auto factor_via_parent(std::size_t node) const -> double;
+
+    /// Redo the breadth first search from the reporting currency.
+    void rebuild_paths();
+
+    /// Recompute the factors of \p node and every node that hops through it.
+    void refresh_subtree(std::size_t node, std::vector<std::string>& changed);
+};
+
+/// Sums the per quote currency totals into one reporting currency total.
+class Consolidated_totals {
+   public:
+    struct Totals {
+        double value    = 0.;
+        double open_pl  = 0.;
+        double daily_pl = 0.;
+        bool complete   = true;  // False if a quote can't be converted.
+    };
+
+   public:
+    explicit Consolidated_totals(std::string reporting)
+        : graph_{std::move(reporting)}
+    {}
+
+   public:
+    /// Set the price of one \p pair.base in \p pair.quote.
+    /** Returns true if the totals changed. */
+    auto set_rate(Currency_pair const& pair, double price) -> bool;
+
+    void set_value(std::string const& quote, double sum)
+    {
+        quotes_[quote].value = sum;
+    }
+
+    void set_open_pl(std::string const& quote, double sum)
+    {
+        quotes_[quote].open_pl = sum;
+    }
+
+    void set_daily_pl(std::string const& quote, double sum)
+    {
+        quotes_[quote].daily_pl = sum;
+    }
+
+    /// Return the totals of all quote currencies, in the reporting currency.
+    [[nodiscard]] auto totals() const -> Totals;
+
+    [[nodiscard]] auto reporting() const -> std::string const&
+    {
+        return graph_.reporting();
+    }
+
+   private:
+    struct Sums {
+        double value    = 0.;
+        double open_pl  = 0.;
+        double daily_pl = 0.;
+    };
+
+    Fx_graph graph_;
+    std::map<std::string, Sums> quotes_;
+};
+
+}  // namespace crab
+#endif  // CRAB_FX_GRAPH_HPP
@@ -0,0 +1,168 @@
+#include "job_scheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <termox/system/event.hpp>
+
+#include "log.hpp"
+#include "thread_config.hpp"
+#include "timer_wheel.hpp"
+
+namespace {
+
+/// Return the time from \p from until UTC time next reaches \p time_of_day.
+[[nodiscard]] auto until_next_utc(std::chrono::system_clock::time_point from,
+                                  std::chrono::minutes time_of_day)
+    -> std::chrono::system_clock::duration
+{
+    // The system clock counts from midnight UTC and has no leap seconds.
+    auto const day            = std::chrono::hours{24};
+    auto const since_midnight = from.time_since_epoch() % day;
+    auto wait = std::chrono::system_clock::duration{time_of_day} -
+                since_midnight;
+    if (wait <= std::chrono::system_clock::duration::zero())
+        wait += day;
+    return wait;
+}
+
+}  // namespace
+
+namespace crab {
+
+Job_scheduler::~Job_scheduler()
+{
+    if (!loop_.is_running())
+        return;
+    loop_.exit(0);
+    {
+        auto const lock = std::lock_guard{mtx_};
+        wake_           = true;
+    }
+    cv_.notify_one();
+    loop_.wait();
+}
+
+void Job_scheduler::start()
+{
+    if (loop_.is_running())
+        return;
+    loop_.run_async([this, entered = false](ox::Event_queue& q) mutable {
+        if (!entered) {
+            enter_thread_role(Thread_role::Persistence, "crab-jobs");
+            entered = true;
+        }
+        this->run_due(q);
+    });
+}
+
+auto Job_scheduler::every(Clock_t::duration period, Job_t job) -> Job_id
+{
+    return this->add(Clock_t::now() + period, std::move(job),
+                     [period](Clock_t::time_point due) {
+                         // Once late, don't try to catch up on missed runs.
+                         return std::max(due + period, Clock_t::now());
+                     });
+}
+
+auto Job_scheduler::daily_utc(std::chrono::minutes time_of_day, Job_t job)
+    -> Job_id
+{
+    auto const next = [time_of_day](Clock_t::time_point) {
+        // A minute ahead so a run a little early by the wall clock isn't
+        // followed by another run at the same time of day.
+        auto const from = std::chrono::system_clock::now() +
+                          std::chrono::minutes{1};
+        return Clock_t::now() + std::chrono::minutes{1} +
+               until_next_utc(from, time_of_day);
+    };
+    return this->add(
+        Clock_t::now() +
+            until_next_utc(std::chrono::system_clock::now(), time_of_day),
+        std::move(job), next);
+}
+
+auto Job_scheduler::cancel(Job_id id) -> bool
+{
+    auto const lock = std::lock_guard{mtx_};
+    auto const at   = jobs_.find(id);
+    if (at == std::end(jobs_))
+        return false;
+    wheel_.cancel(at->second.timer);
+    jobs_.erase(at);
+    return true;
+}
+
+auto Job_scheduler::add(Clock_t::time_point due, Job_t job, Next_t next)
+    -> Job_id
+{
+    auto id = Job_id{};
+    {
+        auto const lock  = std::lock_guard{mtx_};
+        id               = next_id_++;
+        auto const timer = wheel_.add(this->to_tick(due), id);
+        jobs_.emplace(id, Job{std::move(job), std::move(next), due, timer});
+        wake_ = true;
+    }
+    cv_.notify_one();
+    return id;
+}
+
+auto Job_scheduler::to_tick(Clock_t::time_point t) const
+    -> Timer_wheel::Tick_t
+{
+    auto const ticks = std::chrono::ceil<Tick_t>(t - start_).count();
+    return static_cast<Timer_wheel::Tick_t>(std::max(ticks, Tick_t::rep{0}));
+}
+
+void Job_scheduler::run_due(ox::Event_queue& q)
+{
+    auto lock        = std::unique_lock{mtx_};
+    auto const woken = [this] { return wake_; };
+    if (auto const event = wheel_.next_event(); !event.has_value())
+        cv_.wait(lock, woken);
+    else {
+        auto const ticks = static_cast<Tick_t::rep>(*event);
+        cv_.wait_until(lock, start_ + Tick_t{ticks}, woken);
+    }
+    wake_ = false;
+
+    fired_.clear();
+    auto const now = std::chrono::floor<Tick_t>(Clock_t::now() - start_);
+    wheel_.advance(static_cast<Timer_wheel::Tick_t>(now.count()), fired_);
+    auto due = std::vector<std::pair<Job_id, Job_t>>{};
+    for (auto const id : fired_) {
+        auto const at = jobs_.find(id);
+        if (at != std::end(jobs_))
+            due.emplace_back(id, at->second.run);
+    }
+
+    // Run without the lock so jobs can add and cancel jobs.
+    lock.unlock();
+    for (auto const& [id, run] : due) {
+        try {
+            run(q);
+        }
+        catch (std::exception const& e) {
+            log_error("Scheduled job failed: " + std::string{e.what()});
+        }
+    }
+    lock.lock();
+
+    for (auto const& [id, run] : due) {
+        auto const at = jobs_.find(id);
+        if (at == std::end(jobs_))
+            continue;  // Cancelled while running.
+        auto& job = at->second;
+        job.due   = job.next(job.due);
+        job.timer = wheel_.add(this->to_tick(job.due), id);
+    }
+}
+
+}  // namespace crab
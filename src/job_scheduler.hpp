@@ -0,0 +1,91 @@
+#ifndef CRAB_JOB_SCHEDULER_HPP
+#define CRAB_JOB_SCHEDULER_HPP
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ratio>
+#include <unordered_map>
+#include <vector>
+
+#include <termox/system/event.hpp>
+#include <termox/system/event_loop.hpp>
+
+#include "timer_wheel.hpp"
+
+namespace crab {
+
+/// Runs periodic background jobs on one worker thread.
+/** Jobs are timers on a Timer_wheel, so adding and cancelling them is O(1).
+ *  The worker sleeps until the wheel's next event or until a job is added.
+ *  Jobs run on the worker and are passed the event queue so they can post
+ *  Custom_events to the UI thread. Thread safe. */
+class Job_scheduler {
+   public:
+    using Clock_t = std::chrono::steady_clock;
+    using Job_t   = std::function<void(ox::Event_queue&)>;
+    using Job_id  = std::uint64_t;
+
+    /// Resolution of due times, 100ms, jobs run up to one tick late.
+    using Tick_t = std::chrono::duration<Clock_t::rep, std::deci>;
+
+   public:
+    Job_scheduler() = default;
+
+    Job_scheduler(Job_scheduler const&) = delete;
+    Job_scheduler& operator=(Job_scheduler const&) = delete;
+
+    /// Stops the worker, waiting on any job that is running.
+    ~Job_scheduler();
+
+   public:
+    /// Launch the worker, jobs may be added before or after.
+    void start();
+
+    /// Run \p job every \p period, starting one \p period from now.
+    auto every(Clock_t::duration period, Job_t job) -> Job_id;
+
+    /// Run \p job every day when UTC time reaches \p time_of_day.
+    /** The next run is found from the system clock each time, so it follows
+     *  changes to the wall clock. */
+    auto daily_utc(std::chrono::minutes time_of_day, Job_t job) -> Job_id;
+
+    /// Stop running the job \p id, returns false if there is no such job.
+    /** A run already in progress is finished. */
+    auto cancel(Job_id id) -> bool;
+
+   private:
+    using Next_t = std::function<Clock_t::time_point(Clock_t::time_point)>;
+
+    struct Job {
+        Job_t run;
+        Next_t next;  // Next due time from the last.
+        Clock_t::time_point due;
+        Timer_wheel::Timer_id timer;
+    };
+
+    Clock_t::time_point const start_ = Clock_t::now();
+    Timer_wheel wheel_{0};
+    std::unordered_map<Job_id, Job> jobs_;
+    Job_id next_id_ = 0;
+    std::vector<Timer_wheel::Key_t> fired_;
+
+    bool wake_ = false;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    ox::Event_loop loop_;
+
+   private:
+    auto add(Clock_t::time_point due, Job_t job, Next_t next) -> Job_id;
+
+    /// Return the first tick at or after \p t.
+    [[nodiscard]] auto to_tick(Clock_t::time_point t) const
+        -> Timer_wheel::Tick_t;
+
+    /// Wait for the next event, then run and rearm every job that is due.
+    void run_due(ox::Event_queue& q);
+};
+
+}  // namespace crab
+#endif  // CRAB_JOB_SCHEDULER_HPP
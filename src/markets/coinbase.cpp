@@ -1,22 +1,28 @@
 #include "coinbase.hpp"
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <iterator>
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 
 #include <simdjson.h>
 
 #include "../log.hpp"
+#include "../parse_number.hpp"
 #include "error.hpp"
+#include "order_book.hpp"
 
 namespace {
 
 using JSON_element_t = simdjson::simdjson_result<simdjson::dom::element>;
 
-// Parser specifically for coinbase thread. Make sure you aren't using in
+// Parser specifically for the network thread. Make sure you aren't using in
 // multiple threads.
 [[nodiscard]] auto json_parser() -> simdjson::dom::parser&
 {
@@ -34,6 +40,18 @@ auto extract_price(JSON_element_t const& e) -> std::string
     return (std::string)e["price"];
 }
 
+/// Read a number sent as a JSON string, such as a price or size.
+auto to_number(JSON_element_t const& e) -> double
+{
+    auto const text  = (std::string_view)e;
+    auto const value = crab::parse_double(text);
+    if (!value.has_value()) {
+        throw crab::Crab_error{"Coinbase: Can't parse number from: " +
+                               std::string{text}};
+    }
+    return *value;
+}
+
 // Split on '-': "XTZ-BTC" extracts "XTZ"
 auto parse_base_currency(std::string const& pair_str) -> std::string
 {
@@ -68,13 +86,63 @@ auto extract_quote_currency(JSON_element_t const& e) -> std::string
     return parse_quote_currency((std::string)e["product_id"]);
 }
 
+/// Return days since 1970-01-01 of the proleptic Gregorian date given.
+[[nodiscard]] auto days_from_civil(std::int64_t y, unsigned m, unsigned d)
+    -> std::int64_t
+{
+    y -= m <= 2;
+    auto const era = (y >= 0 ? y : y - 399) / 400;
+    auto const yoe = static_cast<unsigned>(y - era * 400);
+    auto const doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    auto const doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146'097 + static_cast<std::int64_t>(doe) - 719'468;
+}
+
+/// Parse "2021-03-04T05:06:07.123456Z" into ms since epoch, 0 if malformed.
+[[nodiscard]] auto parse_time(std::string_view x) -> std::int64_t
+{
+    auto const digits = [&](std::size_t at, std::size_t n) -> std::int64_t {
+        auto result = std::int64_t{0};
+        for (auto i = at; i < at + n; ++i) {
+            if (i >= x.size() || x[i] < '0' || x[i] > '9')
+                return -1;
+            result = result * 10 + (x[i] - '0');
+        }
+        return result;
+    };
+    auto const year   = digits(0, 4);
+    auto const month  = digits(5, 2);
+    auto const day    = digits(8, 2);
+    auto const hour   = digits(11, 2);
+    auto const minute = digits(14, 2);
+    auto const second = digits(17, 2);
+    if (year < 0 || month < 1 || month > 12 || day < 1 || day > 31 ||
+        hour < 0 || minute < 0 || second < 0) {
+        return 0;
+    }
+    auto ms = std::int64_t{0};
+    if (x.size() > 20 && x[19] == '.') {
+        auto const fraction = digits(20, 3);
+        ms                  = fraction < 0 ? 0 : fraction;
+    }
+    auto const days = days_from_civil(year, static_cast<unsigned>(month),
+                                      static_cast<unsigned>(day));
+    return ((days * 24 + hour) * 60 + minute) * 60'000 + second * 1'000 + ms;
+}
+
 auto parse_trade(JSON_element_t const& e) -> std::optional<crab::Price>
 {
     try {
-        return crab::Price{
+        auto result = crab::Price{
             extract_price(e),
             {"COINBASE",
              {extract_base_currency(e), extract_quote_currency(e)}}};
+        // Size and time are left at zero on messages without a trade.
+        if (auto const size = e["last_size"]; !size.error())
+            result.volume = to_number(size);
+        if (auto const time = e["time"]; !time.error())
+            result.time = parse_time((std::string_view)time);
+        return result;
     }
     catch (std::exception const& e) {
         crab::log_error("Coinbase could not parse trade json element.");
@@ -82,89 +150,141 @@ auto parse_trade(JSON_element_t const& e) -> std::optional<crab::Price>
     }
 }
 
-// JSON message to Last_price
-auto parse(std::string const& json) -> std::optional<crab::Price>
+/// Currency_pair to coinbase formatted id: [base]-[quote]
+[[nodiscard]] auto to_id(crab::Currency_pair currency) -> std::string
 {
-    auto const element = json_parser().parse(json);
-    auto const event   = (std::string)element["type"];
-    if (event == "ticker")
-        return parse_trade(element);
-    if (event == "error") {
-        throw crab::Crab_error{"coinbase.cpp anon::parse(): " +
-                               extract_error(element)};
+    return currency.base + '-' + currency.quote;
+}
+
+// Heartbeat channel is included so quiet products still produce frames, this
+// lets a stalled connection be told apart from an idle market.
+auto constexpr ticker_channels = R"("ticker","heartbeat")";
+
+// Order book snapshot followed by every change.
+auto constexpr depth_channels = R"("level2")";
+
+/// Build a subscribe or unsubscribe message for \p channels.
+template <typename Iter_t>
+[[nodiscard]] auto subscription_json(std::string const& type,
+                                     Iter_t first,
+                                     Iter_t last,
+                                     char const* channels) -> std::string
+{
+    auto result = "{\"type\":\"" + type + "\",\"product_ids\":[";
+    auto div    = "";
+    for (; first != last; ++first) {
+        result.append(div).append(1, '\"');
+        result.append(to_id(first->currency)).append(1, '\"');
+        div = ",";
     }
-    return std::nullopt;
+    result.append("],\"channels\":[").append(channels).append("]}");
+    return result;
 }
 
-/// Currency_pair to coinbase formatted id: [base]-[quote]
-[[nodiscard]] auto to_id(crab::Currency_pair currency) -> std::string
+/// Read the [price, size] pairs of one side of a snapshot.
+[[nodiscard]] auto parse_levels(JSON_element_t const& e)
+    -> std::vector<crab::Book_level>
 {
-    return currency.base + '-' + currency.quote;
+    auto result = std::vector<crab::Book_level>{};
+    for (auto level : e) {
+        result.push_back({to_number(level.at(0)), to_number(level.at(1))});
+    }
+    return result;
 }
 
 }  // namespace
 
 namespace crab {
 
-void Coinbase::subscribe(Asset const& asset)
+auto Coinbase::subscribe_messages(std::vector<Asset> const& batch) const
+    -> std::vector<std::string>
 {
-    if (!ws_.is_connected())
-        this->ws_connect();
-    auto const json =
-        std::string{"{\"type\":\"subscribe\",\"product_ids\":[\""} +
-        to_id(asset.currency) + "\"],\"channels\":[\"ticker\"]}";
-    log_status("Coinbase WS Subscribing: " + asset.exchange + ' ' +
-               asset.currency.base + ' ' + asset.currency.quote);
-    try {
-        ws_.write(json);
-        ++subscription_count_;
-    }
-    catch (std::exception const& e) {
-        log_error("Coinbase failed to subscribe to: " + asset.currency.quote +
-                  ' ' + asset.currency.quote + ' ' + e.what());
-    }
+    return {subscription_json("subscribe", std::cbegin(batch),
+                              std::cend(batch), ticker_channels)};
 }
 
-void Coinbase::unsubscribe(Asset const& asset)
+auto Coinbase::unsubscribe_messages(std::vector<Asset> const& batch) const
+    -> std::vector<std::string>
 {
-    if (!ws_.is_connected())
-        this->ws_connect();
-    auto const json =
-        std::string{"{\"type\":\"unsubscribe\",\"product_ids\":[\""} +
-        to_id(asset.currency) + "\"],\"channels\":[\"ticker\"]}";
-    log_status("Coinbase WS Unsubscribing: " + asset.exchange + ' ' +
-               asset.currency.base + ' ' + asset.currency.quote);
-    try {
-        ws_.write(json);
-        --subscription_count_;
+    return {subscription_json("unsubscribe", std::cbegin(batch),
+                              std::cend(batch), ticker_channels)};
+}
+
+auto Coinbase::subscribe_depth_messages(std::vector<Asset> const& batch)
+    -> std::vector<std::string>
+{
+    for (auto const& asset : batch)
+        books_.try_emplace(to_id(asset.currency), Tracked_book{asset, {}});
+    return {subscription_json("subscribe", std::cbegin(batch),
+                              std::cend(batch), depth_channels)};
+}
+
+auto Coinbase::unsubscribe_depth_messages(std::vector<Asset> const& batch)
+    -> std::vector<std::string>
+{
+    for (auto const& asset : batch)
+        books_.erase(to_id(asset.currency));
+    return {subscription_json("unsubscribe", std::cbegin(batch),
+                              std::cend(batch), depth_channels)};
+}
+
+auto Coinbase::parse(std::string const& message) -> std::vector<Price>
+{
+    auto const element = json_parser().parse(message);
+    auto const event   = (std::string)element["type"];
+    if (event == "ticker") {
+        if (auto const price = parse_trade(element); price)
+            return {*price};
+        return {};
     }
-    catch (std::exception const& e) {
-        log_error("Coinbase failed to unsubscribe to: " + asset.currency.quote +
-                  ' ' + asset.currency.quote + ' ' + e.what());
+    if (event == "l2update") {
+        auto* const book = this->find_book((std::string)element["product_id"]);
+        if (book == nullptr)
+            return {};  // Unsubscribed while in flight.
+        for (auto change : element["changes"]) {
+            auto const side = (std::string)change.at(0) == "buy"
+                                  ? Order_book::Side::Bid
+                                  : Order_book::Side::Ask;
+            book->set(side, to_number(change.at(1)), to_number(change.at(2)));
+        }
+        return {};
+    }
+    if (event == "snapshot") {
+        auto* const book = this->find_book((std::string)element["product_id"]);
+        if (book == nullptr)
+            return {};
+        book->assign(Order_book::Side::Bid, parse_levels(element["bids"]));
+        book->assign(Order_book::Side::Ask, parse_levels(element["asks"]));
+        return {};
     }
+    if (event == "error")
+        throw Crab_error{"Coinbase: " + extract_error(element)};
+    return {};
 }
 
-auto Coinbase::stream_read() -> Price
+void Coinbase::take_depth(std::vector<std::pair<Asset, Depth>>& out)
 {
-    if (!ws_.is_connected())
-        this->ws_connect();
+    for (auto const& id : changed_) {
+        auto const at = books_.find(id);
+        if (at == std::end(books_))
+            continue;
+        at->second.changed = false;
+        out.emplace_back(at->second.asset, at->second.book.depth());
+    }
+    changed_.clear();
+}
 
-    auto price = std::optional<Price>{std::nullopt};
-    while (!price) {
-        try {
-            price = parse(ws_.read());
-        }
-        catch (Crab_error const& e) {
-            log_error("Coinbase got non-fatal error from WS read: " +
-                      std::string{e.what()});
-        }
-        catch (ntwk::Error const& e) {
-            log_error("Coinbase Failed to read from Websocket: " +
-                      std::string{e.what()});
-            throw;
-        }
+auto Coinbase::find_book(std::string const& product_id) -> Order_book*
+{
+    auto const at = books_.find(product_id);
+    if (at == std::end(books_))
+        return nullptr;
+    auto& tracked = at->second;
+    if (!tracked.changed) {
+        tracked.changed = true;
+        changed_.push_back(product_id);
     }
-    return *price;
+    return &tracked.book;
 }
 
 }  // namespace crab
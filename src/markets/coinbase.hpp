@@ -1,53 +1,73 @@
 #ifndef CRAB_MARKETS_COINBASE_HPP
 #define CRAB_MARKETS_COINBASE_HPP
-#include <exception>
+#include <chrono>
 #include <string>
-
-#include <ntwk/websocket.hpp>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "../asset.hpp"
-#include "../log.hpp"
 #include "../price.hpp"
+#include "order_book.hpp"
 
 namespace crab {
 
-/// Provides access to Coinbase websocket API for live prices.
+/// Coinbase websocket protocol for live prices and order book depth.
+/** Market adapter with depth, see market_adapter.hpp. Order books are built
+ *  from the level2 channel, a snapshot followed by every change. */
 class Coinbase {
    public:
-    void disconnect_websocket() { ws_.disconnect(); }
+    static auto constexpr name = "Coinbase";
+
+    static auto constexpr host = "ws-feed.pro.coinbase.com";
+
+    // Heartbeat channel sends a frame every second for every subscription.
+    static auto constexpr stall_timeout = std::chrono::seconds{10};
+
+   public:
+    [[nodiscard]] auto resource() const -> std::string { return "/"; }
+
+    /// Single message subscribing to every Asset in \p batch.
+    [[nodiscard]] auto subscribe_messages(std::vector<Asset> const& batch) const
+        -> std::vector<std::string>;
 
-    /// Start listening for live prices for \p asset.
-    /** Connects websocket if not connected yet. */
-    void subscribe(Asset const& asset);
+    /// Single message unsubscribing from every Asset in \p batch.
+    [[nodiscard]] auto unsubscribe_messages(
+        std::vector<Asset> const& batch) const -> std::vector<std::string>;
 
-    /// Stop listening for live prices for \p asset.
-    /** Connects websocket if not connected yet. */
-    void unsubscribe(Asset const& asset);
+    /// Single message subscribing to the level2 channel of each of \p batch.
+    [[nodiscard]] auto subscribe_depth_messages(std::vector<Asset> const& batch)
+        -> std::vector<std::string>;
 
-    [[nodiscard]] auto subscription_count() const -> int
-    {
-        return subscription_count_;
-    }
+    /// Single message unsubscribing from level2, their books are dropped.
+    [[nodiscard]] auto unsubscribe_depth_messages(
+        std::vector<Asset> const& batch) -> std::vector<std::string>;
 
-    /// Read a single response from the coinbase server.
-    [[nodiscard]] auto stream_read() -> Price;
+    /// Parse a single message from the coinbase server.
+    /** Returns an empty vector for heartbeats, order book updates and other
+     *  non-price messages. Throws Crab_error if the message reports an
+     *  error. */
+    [[nodiscard]] auto parse(std::string const& message) -> std::vector<Price>;
+
+    /// Append the Depth of each book changed since the last call.
+    void take_depth(std::vector<std::pair<Asset, Depth>>& out);
 
    private:
-    ntwk::Websocket ws_;
-    int subscription_count_ = 0;
+    struct Tracked_book {
+        Asset asset;
+        Order_book book;
+        bool changed = false;
+    };
+
+    // By product id, only subscribed products have an entry.
+    std::unordered_map<std::string, Tracked_book> books_;
+    std::vector<std::string> changed_;  // Product ids.
 
    private:
-    void ws_connect()
-    {
-        log_status("WS connect: ws-feed.pro.coinbase.com");
-        try {
-            ws_.connect("ws-feed.pro.coinbase.com");
-        }
-        catch (std::exception const& e) {
-            log_error("Coinbase Websocket failed to connect: " +
-                      std::string{e.what()});
-        }
-    }
+    /// Return the book of \p product_id marked as changed, or nullptr.
+    /** nullptr if \p product_id is not subscribed to. */
+    [[nodiscard]] auto find_book(std::string const& product_id)
+        -> Order_book*;
 };
 
 }  // namespace crab
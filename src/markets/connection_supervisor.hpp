@@ -0,0 +1,172 @@
+#ifndef CRAB_MARKETS_CONNECTION_SUPERVISOR_HPP
+#define CRAB_MARKETS_CONNECTION_SUPERVISOR_HPP
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../log.hpp"
+
+namespace crab {
+
+/// Record of a single stream outage, from detection until recovery.
+struct Outage {
+    using Clock_t = std::chrono::steady_clock;
+
+    std::string reason;
+    Clock_t::time_point start;
+    Clock_t::duration downtime = Clock_t::duration::zero();
+    int attempts               = 0;
+    bool recovered             = false;
+};
+
+/// Watches the health of a single market stream and paces its reconnects.
+/** Failures are reported by the stream thread, stalls are detected by
+ *  comparing the time of the last received frame to \p stall_timeout.
+ *  Reconnect attempts are spaced with jittered exponential backoff. Every
+ *  outage is logged and kept in a bounded history. Thread safe. */
+class Connection_supervisor {
+   public:
+    using Clock_t    = std::chrono::steady_clock;
+    using Duration_t = std::chrono::milliseconds;
+
+   public:
+    Connection_supervisor(std::string name,
+                          Duration_t stall_timeout,
+                          Duration_t initial_backoff = Duration_t{250},
+                          Duration_t max_backoff     = Duration_t{10'000})
+        : name_{std::move(name)},
+          stall_timeout_{stall_timeout},
+          initial_backoff_{initial_backoff},
+          max_backoff_{max_backoff}
+    {
+        this->mark_alive();
+    }
+
+   public:
+    /// Call whenever a frame is received from the stream, priced or not.
+    void mark_alive()
+    {
+        last_frame_.store(Clock_t::now().time_since_epoch().count(),
+                          std::memory_order_relaxed);
+    }
+
+    /// Return true if no frame has been received within the stall timeout.
+    [[nodiscard]] auto is_stalled() const -> bool
+    {
+        auto const last = Clock_t::time_point{
+            Clock_t::duration{last_frame_.load(std::memory_order_relaxed)}};
+        return (Clock_t::now() - last) > stall_timeout_;
+    }
+
+    /// Return the configured stall timeout.
+    [[nodiscard]] auto stall_timeout() const -> Duration_t
+    {
+        return stall_timeout_;
+    }
+
+    /// Report that the stream has failed, opens an outage if not in one.
+    /** If already in an outage, counts as another failed attempt. */
+    void report_failure(std::string const& reason)
+    {
+        auto const lock = std::lock_guard{mtx_};
+        auto const now  = Clock_t::now();
+        if (!current_) {
+            log_error(name_ + " stream down: " + reason);
+            current_         = Outage{reason, now};
+            current_backoff_ = initial_backoff_;
+        }
+        else {
+            ++current_->attempts;
+            current_backoff_ = std::min(current_backoff_ * 2, max_backoff_);
+            log_error(name_ + " reconnect attempt " +
+                      std::to_string(current_->attempts) +
+                      " failed: " + reason);
+        }
+        next_attempt_ = now + this->jittered(current_backoff_);
+        in_outage_.store(true);
+    }
+
+    /// Close the current outage, call after reconnect and resubscribe.
+    void recovered()
+    {
+        auto const lock = std::lock_guard{mtx_};
+        if (!current_)
+            return;
+        current_->downtime  = Clock_t::now() - current_->start;
+        current_->recovered = true;
+        ++current_->attempts;
+        log_status(
+            name_ + " stream recovered after " +
+            std::to_string(
+                std::chrono::duration_cast<Duration_t>(current_->downtime)
+                    .count()) +
+            "ms, " + std::to_string(current_->attempts) + " attempt(s).");
+        if (history_.size() == history_limit)
+            history_.erase(std::begin(history_));
+        history_.push_back(std::move(*current_));
+        current_.reset();
+        in_outage_.store(false);
+        this->mark_alive();
+    }
+
+    /// Return true if the stream is currently down and needs reconnecting.
+    [[nodiscard]] auto in_outage() const -> bool { return in_outage_.load(); }
+
+    /// Return the time left until the next reconnect attempt should be made.
+    /** Returns zero if it is time to attempt. */
+    [[nodiscard]] auto time_until_attempt() const -> Duration_t
+    {
+        auto const lock = std::lock_guard{mtx_};
+        auto const now  = Clock_t::now();
+        if (now >= next_attempt_)
+            return Duration_t::zero();
+        return std::chrono::duration_cast<Duration_t>(next_attempt_ - now);
+    }
+
+    /// Return all recorded, recovered outages, oldest first.
+    [[nodiscard]] auto outages() const -> std::vector<Outage>
+    {
+        auto const lock = std::lock_guard{mtx_};
+        return history_;
+    }
+
+    /// Return the name of the market this supervises.
+    [[nodiscard]] auto name() const -> std::string const& { return name_; }
+
+   private:
+    static auto constexpr history_limit = std::size_t{64};
+
+    std::string const name_;
+    Duration_t const stall_timeout_;
+    Duration_t const initial_backoff_;
+    Duration_t const max_backoff_;
+
+    std::atomic<Clock_t::rep> last_frame_{0};
+    std::atomic<bool> in_outage_{false};
+
+    mutable std::mutex mtx_;
+    std::optional<Outage> current_;
+    std::vector<Outage> history_;
+    Duration_t current_backoff_;
+    Clock_t::time_point next_attempt_;
+    std::minstd_rand rng_{std::random_device{}()};
+
+   private:
+    /// Return a random duration in [d/2, d], keeps reconnects from syncing.
+    [[nodiscard]] auto jittered(Duration_t d) -> Duration_t
+    {
+        auto dist = std::uniform_int_distribution<Duration_t::rep>{
+            d.count() / 2, d.count()};
+        return Duration_t{dist(rng_)};
+    }
+};
+
+}  // namespace crab
+#endif  // CRAB_MARKETS_CONNECTION_SUPERVISOR_HPP
@@ -0,0 +1,98 @@
+#include "daemon_client.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../log.hpp"
+#include "daemon_protocol.hpp"
+#include "error.hpp"
+
+namespace crab {
+
+Daemon_client::Daemon_client(std::string const& path,
+                             std::chrono::milliseconds timeout)
+    : fd_{connect_unix(path)}
+{
+    auto frames = std::vector<std::string>{};
+    if (this->send(hello_frame()) && this->receive(frames, timeout) &&
+        !frames.empty()) {
+        try {
+            auto r = Frame_reader{frames.front()};
+            if (r.kind() == Frame_kind::Hello &&
+                r.u32() == daemon_protocol_version) {
+                early_.assign(std::next(std::begin(frames)), std::end(frames));
+                return;
+            }
+        }
+        catch (std::exception const&) {
+        }
+    }
+    ::close(fd_);
+    throw Crab_error{"Daemon at " + path + " did not answer."};
+}
+
+Daemon_client::~Daemon_client() { ::close(fd_); }
+
+auto Daemon_client::send(std::string const& frame) -> bool
+{
+    auto const lock = std::lock_guard{send_mtx_};
+    auto sent       = std::size_t{0};
+    while (this->is_connected() && sent != frame.size()) {
+        auto const n = send_some(fd_, std::string_view{frame}.substr(sent));
+        if (n > 0)
+            sent += static_cast<std::size_t>(n);
+        else if (n == -1 && errno == EINTR)
+            continue;
+        else
+            connected_.store(false, std::memory_order_release);
+    }
+    return this->is_connected();
+}
+
+auto Daemon_client::receive(std::vector<std::string>& out,
+                            std::chrono::milliseconds timeout) -> bool
+{
+    if (!this->is_connected())
+        return false;
+    if (!early_.empty()) {
+        out.insert(std::end(out), std::begin(early_), std::end(early_));
+        early_.clear();
+        return true;
+    }
+    auto pfd = ::pollfd{fd_, POLLIN, 0};
+    if (::poll(&pfd, 1, static_cast<int>(timeout.count())) <= 0)
+        return true;
+    char buffer[65'536];
+    auto const n = ::recv(fd_, buffer, sizeof(buffer), 0);
+    if (n == -1 && (errno == EINTR || errno == EAGAIN))
+        return true;
+    if (n <= 0) {
+        connected_.store(false, std::memory_order_release);
+        return false;
+    }
+    splitter_.append(buffer, static_cast<std::size_t>(n));
+    try {
+        auto frame = std::string{};
+        while (splitter_.next(frame))
+            out.push_back(frame);
+    }
+    catch (Crab_error const& e) {
+        log_error(e.what());
+        connected_.store(false, std::memory_order_release);
+        return false;
+    }
+    return true;
+}
+
+}  // namespace crab
@@ -0,0 +1,52 @@
+#ifndef CRAB_MARKETS_DAEMON_CLIENT_HPP
+#define CRAB_MARKETS_DAEMON_CLIENT_HPP
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "daemon_protocol.hpp"
+
+namespace crab {
+
+/// Connection from a terminal view to a crabwise --daemon.
+/** Frames may be sent from any thread, and are received by a single thread.
+ *  Once the daemon goes away the client stays disconnected, sends are then
+ *  dropped. */
+class Daemon_client {
+   public:
+    /// Connect to the daemon listening at \p path and exchange Hello.
+    /** Throws Crab_error if nothing answers within \p timeout or it speaks a
+     *  different protocol version. */
+    Daemon_client(std::string const& path, std::chrono::milliseconds timeout);
+
+    Daemon_client(Daemon_client const&) = delete;
+    Daemon_client& operator=(Daemon_client const&) = delete;
+
+    ~Daemon_client();
+
+   public:
+    /// Write the whole of \p frame, returns false if disconnected.
+    auto send(std::string const& frame) -> bool;
+
+    /// Wait up to \p timeout for frames and append each to \p out.
+    /** Returns false once disconnected. */
+    auto receive(std::vector<std::string>& out,
+                 std::chrono::milliseconds timeout) -> bool;
+
+    [[nodiscard]] auto is_connected() const -> bool
+    {
+        return connected_.load(std::memory_order_acquire);
+    }
+
+   private:
+    int fd_;
+    std::atomic<bool> connected_{true};
+    std::mutex send_mtx_;
+    Frame_splitter splitter_;         // Only touched by the receiving thread.
+    std::vector<std::string> early_;  // Read along with the Hello.
+};
+
+}  // namespace crab
+#endif  // CRAB_MARKETS_DAEMON_CLIENT_HPP
@@ -0,0 +1,425 @@
+#include "daemon_protocol.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "error.hpp"
+
+namespace {
+
+[[nodiscard]] auto errno_message(std::string const& what) -> std::string
+{
+    return "Daemon socket: " + what + ": " + std::strerror(errno);
+}
+
+/// Return an address for \p path, throws Crab_error if it is too long.
+[[nodiscard]] auto unix_address(std::string const& path) -> ::sockaddr_un
+{
+    auto address = ::sockaddr_un{};
+    if (path.size() >= sizeof(address.sun_path))
+        throw crab::Crab_error{"Daemon socket: path too long: " + path};
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.data(), path.size());
+    return address;
+}
+
+/// Append the \p n low bytes of \p x to \p out, least significant first.
+void put_le(std::string& out, std::uint64_t x, std::size_t n)
+{
+    for (auto i = std::size_t{0}; i < n; ++i)
+        out.push_back(static_cast<char>((x >> (8 * i)) & 0xFF));
+}
+
+[[nodiscard]] auto get_le(std::string_view bytes) -> std::uint64_t
+{
+    auto result = std::uint64_t{0};
+    for (auto i = bytes.size(); i != 0; --i)
+        result = (result << 8) | static_cast<std::uint8_t>(bytes[i - 1]);
+    return result;
+}
+
+[[nodiscard]] auto count_of(std::size_t size) -> std::uint32_t
+{
+    return static_cast<std::uint32_t>(size);
+}
+
+}  // namespace
+
+namespace crab {
+
+Frame_writer::Frame_writer(Frame_kind kind)
+{
+    bytes_.assign(4, '\0');  // Length, filled in by finish().
+    this->u8(static_cast<std::uint8_t>(kind));
+}
+
+auto Frame_writer::u8(std::uint8_t x) -> Frame_writer&
+{
+    put_le(bytes_, x, 1);
+    return *this;
+}
+
+auto Frame_writer::u16(std::uint16_t x) -> Frame_writer&
+{
+    put_le(bytes_, x, 2);
+    return *this;
+}
+
+auto Frame_writer::u32(std::uint32_t x) -> Frame_writer&
+{
+    put_le(bytes_, x, 4);
+    return *this;
+}
+
+auto Frame_writer::u64(std::uint64_t x) -> Frame_writer&
+{
+    put_le(bytes_, x, 8);
+    return *this;
+}
+
+auto Frame_writer::f64(double x) -> Frame_writer&
+{
+    auto bits = std::uint64_t{0};
+    std::memcpy(&bits, &x, sizeof(bits));
+    return this->u64(bits);
+}
+
+auto Frame_writer::text(std::string_view x) -> Frame_writer&
+{
+    auto const size = std::min<std::size_t>(x.size(), UINT16_MAX);
+    this->u16(static_cast<std::uint16_t>(size));
+    bytes_.append(x.data(), size);
+    return *this;
+}
+
+auto Frame_writer::asset(Asset const& x) -> Frame_writer&
+{
+    return this->text(x.exchange).text(x.currency.base).text(x.currency.quote);
+}
+
+auto Frame_writer::finish() -> std::string
+{
+    auto const length = bytes_.size() - 4;
+    for (auto i = std::size_t{0}; i < 4; ++i)
+        bytes_[i] = static_cast<char>((length >> (8 * i)) & 0xFF);
+    return std::move(bytes_);
+}
+
+Frame_reader::Frame_reader(std::string_view frame) : bytes_{frame}
+{
+    kind_ = static_cast<Frame_kind>(this->u8());
+}
+
+auto Frame_reader::u8() -> std::uint8_t
+{
+    return static_cast<std::uint8_t>(get_le(this->take(1)));
+}
+
+auto Frame_reader::u16() -> std::uint16_t
+{
+    return static_cast<std::uint16_t>(get_le(this->take(2)));
+}
+
+auto Frame_reader::u32() -> std::uint32_t
+{
+    return static_cast<std::uint32_t>(get_le(this->take(4)));
+}
+
+auto Frame_reader::u64() -> std::uint64_t { return get_le(this->take(8)); }
+
+auto Frame_reader::f64() -> double
+{
+    auto const bits = this->u64();
+    auto result     = 0.;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+auto Frame_reader::text() -> std::string
+{
+    auto const size = this->u16();
+    return std::string{this->take(size)};
+}
+
+auto Frame_reader::asset() -> Asset
+{
+    auto exchange = this->text();
+    auto base     = this->text();
+    auto quote    = this->text();
+    return {std::move(exchange), {std::move(base), std::move(quote)}};
+}
+
+auto Frame_reader::take(std::size_t n) -> std::string_view
+{
+    if (n > bytes_.size())
+        throw Crab_error{"Daemon protocol: frame is too short."};
+    auto const result = bytes_.substr(0, n);
+    bytes_.remove_prefix(n);
+    return result;
+}
+
+void Frame_splitter::append(char const* data, std::size_t size)
+{
+    if (read_ != 0 && read_ == buffer_.size()) {
+        buffer_.clear();
+        read_ = 0;
+    }
+    buffer_.append(data, size);
+}
+
+auto Frame_splitter::next(std::string& frame) -> bool
+{
+    auto const available = buffer_.size() - read_;
+    if (available < 4)
+        return false;
+    auto const length = get_le(std::string_view{buffer_}.substr(read_, 4));
+    if (length == 0 || length > max_frame)
+        throw Crab_error{"Daemon protocol: bad frame length."};
+    if (available - 4 < length)
+        return false;
+    frame.assign(buffer_, read_ + 4, length);
+    read_ += 4 + length;
+    if (read_ > buffer_.size() / 2) {  // Keep the buffer from growing.
+        buffer_.erase(0, read_);
+        read_ = 0;
+    }
+    return true;
+}
+
+auto hello_frame() -> std::string
+{
+    return Frame_writer{Frame_kind::Hello}
+        .u32(daemon_protocol_version)
+        .finish();
+}
+
+auto assets_frame(Frame_kind kind, std::vector<Asset> const& assets)
+    -> std::string
+{
+    auto w = Frame_writer{kind};
+    w.u32(count_of(assets.size()));
+    for (auto const& asset : assets)
+        w.asset(asset);
+    return w.finish();
+}
+
+auto request_stats_frame(Rest_lane lane, std::vector<Asset> const& assets)
+    -> std::string
+{
+    auto w = Frame_writer{Frame_kind::Request_stats};
+    w.u8(static_cast<std::uint8_t>(lane)).u32(count_of(assets.size()));
+    for (auto const& asset : assets)
+        w.asset(asset);
+    return w.finish();
+}
+
+auto refresh_stats_frame(Rest_lane lane) -> std::string
+{
+    return Frame_writer{Frame_kind::Refresh_stats}
+        .u8(static_cast<std::uint8_t>(lane))
+        .finish();
+}
+
+auto search_frame(std::string const& query, std::uint64_t generation)
+    -> std::string
+{
+    return Frame_writer{Frame_kind::Search}
+        .u64(generation)
+        .text(query)
+        .finish();
+}
+
+auto price_frame(Price const& price) -> std::string
+{
+    return Frame_writer{Frame_kind::Price}
+        .asset(price.asset)
+        .text(price.value)
+        .f64(price.volume)
+        .u64(static_cast<std::uint64_t>(price.time))
+        .f64(price.low)
+        .f64(price.high)
+        .finish();
+}
+
+auto stats_frame(Asset const& asset, Stats const& stats) -> std::string
+{
+    return Frame_writer{Frame_kind::Stats}
+        .asset(asset)
+        .f64(stats.last_price)
+        .f64(stats.last_close)
+        .finish();
+}
+
+auto trades_frame(Asset const& asset, Trade_summary const& summary)
+    -> std::string
+{
+    return Frame_writer{Frame_kind::Trades}
+        .asset(asset)
+        .f64(summary.session_volume)
+        .f64(summary.window_volume)
+        .f64(summary.vwap)
+        .u64(summary.window_trades)
+        .finish();
+}
+
+auto depth_frame(Asset const& asset, Depth const& depth) -> std::string
+{
+    auto w = Frame_writer{Frame_kind::Depth};
+    w.asset(asset)
+        .u8(static_cast<std::uint8_t>(depth.bid_count))
+        .u8(static_cast<std::uint8_t>(depth.ask_count));
+    for (auto i = std::size_t{0}; i < depth.bid_count; ++i)
+        w.f64(depth.bids[i].price).f64(depth.bids[i].size);
+    for (auto i = std::size_t{0}; i < depth.ask_count; ++i)
+        w.f64(depth.asks[i].price).f64(depth.asks[i].size);
+    return w.finish();
+}
+
+auto search_results_frame(std::uint64_t generation,
+                          std::vector<Search_result> const& results)
+    -> std::string
+{
+    auto w = Frame_writer{Frame_kind::Search_results};
+    w.u64(generation).u32(count_of(results.size()));
+    for (auto const& result : results)
+        w.text(result.type).text(result.description).asset(result.asset);
+    return w.finish();
+}
+
+auto search_finished_frame(std::uint64_t generation) -> std::string
+{
+    return Frame_writer{Frame_kind::Search_finished}.u64(generation).finish();
+}
+
+auto read_assets(Frame_reader& r) -> std::vector<Asset>
+{
+    auto const count = r.u32();
+    auto result      = std::vector<Asset>{};
+    for (auto i = std::uint32_t{0}; i < count; ++i)
+        result.push_back(r.asset());
+    return result;
+}
+
+auto read_lane(Frame_reader& r) -> Rest_lane
+{
+    auto const lane = r.u8();
+    if (lane > static_cast<std::uint8_t>(Rest_lane::Background))
+        throw Crab_error{"Daemon protocol: unknown Rest_lane."};
+    return static_cast<Rest_lane>(lane);
+}
+
+auto read_price(Frame_reader& r) -> Price
+{
+    auto result   = Price{};
+    result.asset  = r.asset();
+    result.value  = r.text();
+    result.volume = r.f64();
+    result.time   = static_cast<std::int64_t>(r.u64());
+    result.low    = r.f64();
+    result.high   = r.f64();
+    return result;
+}
+
+auto read_stats(Frame_reader& r) -> std::pair<Asset, Stats>
+{
+    auto asset       = r.asset();
+    auto const price = r.f64();
+    auto const close = r.f64();
+    return {std::move(asset), Stats{price, close}};
+}
+
+auto read_trades(Frame_reader& r) -> std::pair<Asset, Trade_summary>
+{
+    auto asset             = r.asset();
+    auto summary           = Trade_summary{};
+    summary.session_volume = r.f64();
+    summary.window_volume  = r.f64();
+    summary.vwap           = r.f64();
+    summary.window_trades  = r.u64();
+    return {std::move(asset), summary};
+}
+
+auto read_depth(Frame_reader& r) -> std::pair<Asset, Depth>
+{
+    auto asset      = r.asset();
+    auto depth      = Depth{};
+    depth.bid_count = std::min<std::size_t>(r.u8(), Depth::max_levels);
+    depth.ask_count = std::min<std::size_t>(r.u8(), Depth::max_levels);
+    for (auto i = std::size_t{0}; i < depth.bid_count; ++i) {
+        depth.bids[i].price = r.f64();
+        depth.bids[i].size  = r.f64();
+    }
+    for (auto i = std::size_t{0}; i < depth.ask_count; ++i) {
+        depth.asks[i].price = r.f64();
+        depth.asks[i].size  = r.f64();
+    }
+    return {std::move(asset), depth};
+}
+
+auto read_search_results(Frame_reader& r) -> std::vector<Search_result>
+{
+    auto const count = r.u32();
+    auto result      = std::vector<Search_result>{};
+    for (auto i = std::uint32_t{0}; i < count; ++i) {
+        auto type        = r.text();
+        auto description = r.text();
+        result.push_back({std::move(type), std::move(description), r.asset()});
+    }
+    return result;
+}
+
+auto listen_unix(std::string const& path) -> int
+{
+    auto const address = unix_address(path);
+    auto const fd      = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1)
+        throw Crab_error{errno_message("socket")};
+    if (::bind(fd, reinterpret_cast<::sockaddr const*>(&address),
+               sizeof(address)) == -1 ||
+        ::listen(fd, 16) == -1 ||
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK) == -1) {
+        auto const message = errno_message("listen on " + path);
+        ::close(fd);
+        throw Crab_error{message};
+    }
+    return fd;
+}
+
+auto send_some(int fd, std::string_view bytes) -> long
+{
+#if defined(MSG_NOSIGNAL)
+    auto constexpr flags = MSG_NOSIGNAL;
+#else
+    auto constexpr flags = 0;
+#endif
+    return static_cast<long>(::send(fd, bytes.data(), bytes.size(), flags));
+}
+
+auto connect_unix(std::string const& path) -> int
+{
+    auto const address = unix_address(path);
+    auto const fd      = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1)
+        throw Crab_error{errno_message("socket")};
+    if (::connect(fd, reinterpret_cast<::sockaddr const*>(&address),
+                  sizeof(address)) == -1) {
+        auto const message = errno_message("connect to " + path);
+        ::close(fd);
+        throw Crab_error{message};
+    }
+    return fd;
+}
+
+}  // namespace crab
@@ -0,0 +1,202 @@
+#ifndef CRAB_MARKETS_DAEMON_PROTOCOL_HPP
+#define CRAB_MARKETS_DAEMON_PROTOCOL_HPP
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "../asset.hpp"
+#include "../price.hpp"
+#include "../search_result.hpp"
+#include "../stats.hpp"
+#include "order_book.hpp"
+#include "rest_scheduler.hpp"
+#include "trade_tracker.hpp"
+
+namespace crab {
+
+// Binary protocol spoken over the Unix socket of crabwise --daemon.
+//
+// Every frame is a uint32 length, then that many bytes: a Frame_kind byte
+// followed by its payload. Integers are little endian, doubles are their
+// IEEE 754 bits as a uint64, and text is a uint16 length then UTF-8 bytes.
+// An Asset is three texts: exchange, base and quote. Both sides send Hello
+// first, a peer with a different version is disconnected.
+
+auto constexpr daemon_protocol_version = std::uint32_t{3};
+
+enum class Frame_kind : std::uint8_t {
+    Hello = 0,  // uint32 version.
+
+    // Client to daemon.
+    Subscribe = 1,      // uint32 count, Assets.
+    Unsubscribe,        // uint32 count, Assets.
+    Subscribe_depth,    // uint32 count, Assets.
+    Unsubscribe_depth,  // uint32 count, Assets.
+    Request_stats,      // uint8 Rest_lane, uint32 count, Assets.
+    Refresh_stats,      // uint8 Rest_lane.
+    Search,             // uint64 generation, text query.
+
+    // Daemon to client.
+    Price = 64,       // Asset, text value, double volume, int64 time,
+                      // double low, double high.
+    Stats,            // Asset, double last price, double last close.
+    Trades,           // Asset, 3 doubles, uint64 window trades.
+    Depth,            // Asset, uint8 bid count, uint8 ask count, levels.
+    Search_results,   // uint64 generation, uint32 count, then each text type,
+                      // text description, Asset.
+    Search_finished,  // uint64 generation.
+};
+
+/// Builds a single frame, the length is filled in by finish().
+class Frame_writer {
+   public:
+    explicit Frame_writer(Frame_kind kind);
+
+   public:
+    auto u8(std::uint8_t x) -> Frame_writer&;
+
+    auto u16(std::uint16_t x) -> Frame_writer&;
+
+    auto u32(std::uint32_t x) -> Frame_writer&;
+
+    auto u64(std::uint64_t x) -> Frame_writer&;
+
+    auto f64(double x) -> Frame_writer&;
+
+    /// Text longer than 65535 bytes is cut off.
+    auto text(std::string_view x) -> Frame_writer&;
+
+    auto asset(Asset const& x) -> Frame_writer&;
+
+    /// Return the whole frame, length prefix included.
+    [[nodiscard]] auto finish() -> std::string;
+
+   private:
+    std::string bytes_;
+};
+
+/// Reads the payload of a single frame, as split by a Frame_splitter.
+/** Every read throws Crab_error if it runs past the end of the frame. */
+class Frame_reader {
+   public:
+    /// \p frame is the kind byte and payload, without the length prefix.
+    explicit Frame_reader(std::string_view frame);
+
+   public:
+    [[nodiscard]] auto kind() const -> Frame_kind { return kind_; }
+
+    [[nodiscard]] auto u8() -> std::uint8_t;
+
+    [[nodiscard]] auto u16() -> std::uint16_t;
+
+    [[nodiscard]] auto u32() -> std::uint32_t;
+
+    [[nodiscard]] auto u64() -> std::uint64_t;
+
+    [[nodiscard]] auto f64() -> double;
+
+    [[nodiscard]] auto text() -> std::string;
+
+    [[nodiscard]] auto asset() -> Asset;
+
+   private:
+    std::string_view bytes_;
+    Frame_kind kind_;
+
+   private:
+    /// Return the next \p n bytes and step over them.
+    [[nodiscard]] auto take(std::size_t n) -> std::string_view;
+};
+
+/// Splits bytes read from a stream socket into frames.
+class Frame_splitter {
+   public:
+    /// Frames longer than this are refused, the peer is misbehaving.
+    static auto constexpr max_frame = std::size_t{4} << 20;
+
+   public:
+    void append(char const* data, std::size_t size);
+
+    /// Move the next complete frame, without its length, into \p frame.
+    /** Returns false if no complete frame is buffered. Throws Crab_error if
+     *  the next frame is empty or longer than max_frame. */
+    auto next(std::string& frame) -> bool;
+
+   private:
+    std::string buffer_;
+    std::size_t read_ = 0;  // Start of the first unread frame in buffer_.
+};
+
+// Frames, see Frame_kind for each payload.
+
+[[nodiscard]] auto hello_frame() -> std::string;
+
+/// Build a Subscribe, Unsubscribe, Subscribe_depth or Unsubscribe_depth.
+[[nodiscard]] auto assets_frame(Frame_kind kind,
+                                std::vector<Asset> const& assets)
+    -> std::string;
+
+[[nodiscard]] auto request_stats_frame(Rest_lane lane,
+                                       std::vector<Asset> const& assets)
+    -> std::string;
+
+[[nodiscard]] auto refresh_stats_frame(Rest_lane lane) -> std::string;
+
+/// \p generation is echoed by the results, so stale ones can be dropped.
+[[nodiscard]] auto search_frame(std::string const& query,
+                                std::uint64_t generation) -> std::string;
+
+[[nodiscard]] auto price_frame(Price const& price) -> std::string;
+
+[[nodiscard]] auto stats_frame(Asset const& asset, Stats const& stats)
+    -> std::string;
+
+[[nodiscard]] auto trades_frame(Asset const& asset,
+                                Trade_summary const& summary) -> std::string;
+
+[[nodiscard]] auto depth_frame(Asset const& asset, Depth const& depth)
+    -> std::string;
+
+[[nodiscard]] auto search_results_frame(
+    std::uint64_t generation,
+    std::vector<Search_result> const& results) -> std::string;
+
+[[nodiscard]] auto search_finished_frame(std::uint64_t generation)
+    -> std::string;
+
+// Payloads, read after checking Frame_reader::kind().
+
+[[nodiscard]] auto read_assets(Frame_reader& r) -> std::vector<Asset>;
+
+[[nodiscard]] auto read_lane(Frame_reader& r) -> Rest_lane;
+
+[[nodiscard]] auto read_price(Frame_reader& r) -> Price;
+
+[[nodiscard]] auto read_stats(Frame_reader& r) -> std::pair<Asset, Stats>;
+
+[[nodiscard]] auto read_trades(Frame_reader& r)
+    -> std::pair<Asset, Trade_summary>;
+
+[[nodiscard]] auto read_depth(Frame_reader& r) -> std::pair<Asset, Depth>;
+
+/// Read after the generation, which starts every search frame.
+[[nodiscard]] auto read_search_results(Frame_reader& r)
+    -> std::vector<Search_result>;
+
+/// Bind and listen on the Unix socket at \p path, returns a non-blocking fd.
+/** Throws Crab_error on failure, including if \p path already exists. */
+[[nodiscard]] auto listen_unix(std::string const& path) -> int;
+
+/// Write as much of \p bytes to \p fd as it takes, as ::send() returns.
+/** A peer that has gone away gives an error rather than SIGPIPE. */
+[[nodiscard]] auto send_some(int fd, std::string_view bytes) -> long;
+
+/// Connect to the Unix socket at \p path, returns a blocking fd.
+/** Throws Crab_error on failure. */
+[[nodiscard]] auto connect_unix(std::string const& path) -> int;
+
+}  // namespace crab
+#endif  // CRAB_MARKETS_DAEMON_PROTOCOL_HPP
@@ -8,5 +8,10 @@ class Crab_error : public std::runtime_error {
     using std::runtime_error::runtime_error;
 };
 
+/// A REST API refused a request for exceeding its rate limit, retry later.
+class Rate_limited : public Crab_error {
+    using Crab_error::Crab_error;
+};
+
 }  // namespace crab
 #endif  // CRAB_MARKETS_ERROR_HPP
@@ -0,0 +1,523 @@
+#ifndef CRAB_MARKETS_FEED_HPP
+#define CRAB_MARKETS_FEED_HPP
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../asset.hpp"
+#include "../log.hpp"
+#include "../parse_number.hpp"
+#include "../price.hpp"
+#include "connection_supervisor.hpp"
+#include "latency_monitor.hpp"
+#include "locking_list.hpp"
+#include "market_adapter.hpp"
+#include "order_book.hpp"
+#include "price_bus.hpp"
+#include "reactor.hpp"
+#include "tick_ring.hpp"
+#include "trade_tracker.hpp"
+#include "websocket_client.hpp"
+
+namespace crab {
+
+/// Running counters for a single Feed.
+struct Feed_stats {
+    std::uint64_t frames  = 0;
+    std::uint64_t prices  = 0;
+    std::uint64_t dropped = 0;  // Ticks lost to a full ring.
+    int subscriptions     = 0;
+    std::size_t outages   = 0;
+    bool connected        = true;
+};
+
+/// Streaming connection to a single market, driven by a shared Reactor.
+/** Owns the websocket, the active subscriptions, pending subscription queues
+ *  and the Connection_supervisor that brings the stream back after failures.
+ *  The adapter only builds and parses messages. Prices are handed to the UI
+ *  thread through a lock-free ring of Ticks, read with drain(), which also
+ *  keeps the rolling trade statistics of each Asset. If the adapter
+ *  streams depth, the Depth of each changed order book is published once per
+ *  wakeup and read with drain_depth(). Everything except the (un)subscribe
+ *  functions, the drains and the accessors is called from the network
+ *  thread. */
+template <typename Adapter_t>
+class Feed {
+    static_assert(is_market_adapter_v<Adapter_t>,
+                  "Feed: Adapter_t does not meet market adapter requirements.");
+
+   public:
+    static auto constexpr has_depth = has_depth_v<Adapter_t>;
+
+   public:
+    /// Queue \p asset to be subscribed to from the network thread.
+    void subscribe(Asset const& asset)
+    {
+        auto const lock = to_subscribe_.lock();
+        to_subscribe_.push_back(asset);
+    }
+
+    /// Queue every Asset in \p batch to be subscribed to, under one lock.
+    void subscribe(std::vector<Asset> const& batch)
+    {
+        auto const lock = to_subscribe_.lock();
+        for (auto const& asset : batch)
+            to_subscribe_.push_back(asset);
+    }
+
+    /// Queue \p asset to be unsubscribed from on the network thread.
+    void unsubscribe(Asset const& asset)
+    {
+        auto const lock = to_unsubscribe_.lock();
+        to_unsubscribe_.push_back(asset);
+    }
+
+    /// Queue the order book of \p asset to be subscribed to.
+    void subscribe_depth(Asset const& asset)
+    {
+        static_assert(has_depth_v<Adapter_t>,
+                      "Feed: Adapter_t does not stream order book depth.");
+        auto const lock = to_subscribe_depth_.lock();
+        to_subscribe_depth_.push_back(asset);
+    }
+
+    /// Queue the order book of \p asset to be unsubscribed from.
+    void unsubscribe_depth(Asset const& asset)
+    {
+        static_assert(has_depth_v<Adapter_t>,
+                      "Feed: Adapter_t does not stream order book depth.");
+        auto const lock = to_unsubscribe_depth_.lock();
+        to_unsubscribe_depth_.push_back(asset);
+    }
+
+    /// Handle readiness of fd(), reported by \p reactor.
+    /** Returns true if any Ticks or Depths were published for drain() or
+     *  drain_depth() to pick up. */
+    auto ready(Readiness const& r, Reactor& reactor) -> bool
+    {
+        auto const pushed_before = prices_.load(std::memory_order_relaxed);
+        try {
+            auto const was_open = ws_.is_open();
+            auto const fd       = ws_.fd();
+            ws_.progress(r.readable, r.writable);
+            if (ws_.fd() != fd) {  // Moved on to the host's next address.
+                reactor.remove(fd);
+                want_write_ = true;
+                reactor.add(ws_.fd(), want_write_);
+            }
+            if (!was_open && ws_.is_open())
+                this->opened();
+            while (ws_.next_message(message_))
+                this->handle_message();
+        }
+        catch (std::exception const& e) {
+            this->fail(reactor, e.what());
+        }
+        auto published = false;
+        if constexpr (has_depth_v<Adapter_t>)
+            published = this->publish_depth();
+        this->update_interest(reactor);
+        return published ||
+               prices_.load(std::memory_order_relaxed) != pushed_before;
+    }
+
+    /// Append the newest Price of each Asset pushed since the last drain.
+    /** Every Tick is recorded in \p latency and every Tick with a volume is
+     *  added to the trade statistics, before any are merged. The
+     *  Trade_summary of each Asset traded is appended to \p trades. Called
+     *  from the UI thread, takes a single lock for the whole batch.
+     *
+     *  Ticks of the same Asset within a batch are merged to the newest, with
+     *  the lowest and highest price of the batch in Price::low and high, so
+     *  alerts still see every level traded through. The risk sampling sees
+     *  only the newest price. Bursts of trades and a busy UI thread both
+     *  make batches larger. */
+    void drain(std::vector<Price>& out,
+               std::vector<std::pair<Asset, Trade_summary>>& trades,
+               Latency_monitor& latency)
+    {
+        batch_.clear();
+        if (ring_->pop_all(batch_) == 0)
+            return;
+        traded_.assign(traded_.size(), false);
+        auto const lock = std::lock_guard{assets_mtx_};
+        for (Tick const& t : batch_) {
+            latency.record(assets_[t.asset_id], t.received, t.time);
+            if (t.volume <= 0.)
+                continue;
+            if (t.asset_id >= traded_.size())
+                traded_.resize(t.asset_id + 1, false);
+            traded_[t.asset_id] = true;
+            tracker_.add(t.asset_id, t.price, t.volume, t.trade_time());
+        }
+        auto constexpr none = static_cast<std::size_t>(-1);
+        drained_at_.assign(assets_.size(), none);
+        for (auto t = std::crbegin(batch_); t != std::crend(batch_); ++t) {
+            if (auto const at = drained_at_[t->asset_id]; at != none) {
+                if (t->price > 0.) {  // Unparsed prices are 0.
+                    out[at].low  = std::min(out[at].low, t->price);
+                    out[at].high = std::max(out[at].high, t->price);
+                }
+                continue;
+            }
+            drained_at_[t->asset_id] = out.size();
+            auto const& asset        = assets_[t->asset_id];
+            out.push_back({t->text(), asset, t->volume, t->time, t->received,
+                           t->price, t->price});
+            if (t->asset_id < traded_.size() && traded_[t->asset_id])
+                trades.emplace_back(asset, tracker_.summary(t->asset_id));
+        }
+    }
+
+    /// Also publish every Tick to \p bus, which must outlive the Feed.
+    /** Any thread, takes effect from the next message. */
+    void set_price_bus(Price_bus* bus)
+    {
+        bus_.store(bus, std::memory_order_release);
+    }
+
+    /// Set the window of the trade statistics, clears them. UI thread only.
+    void set_trade_window(Trade_tracker::Window_t window)
+    {
+        tracker_.set_window(window);
+    }
+
+    /// Append the newest Depth of each order book changed since last drain.
+    /** Called from the UI thread. */
+    void drain_depth(std::vector<std::pair<Asset, Depth>>& out)
+    {
+        auto const lock = std::lock_guard{depth_mtx_};
+        out.insert(std::end(out), std::begin(pending_depth_),
+                   std::end(pending_depth_));
+        pending_depth_.clear();
+    }
+
+    /// Flush subscription queues, reconnect and check for a stall.
+    /** Called once per reactor wakeup, after all readiness is handled. */
+    void poll(Reactor& reactor)
+    {
+        this->flush_subscriptions();
+        if (!this->has_subscriptions())
+            supervisor_.mark_alive();
+        if (ws_.state() == Websocket_client::State::Closed) {
+            if (this->has_subscriptions() &&
+                supervisor_.time_until_attempt() ==
+                    Connection_supervisor::Duration_t::zero()) {
+                this->open(reactor);
+            }
+            return;
+        }
+        if (supervisor_.is_stalled()) {
+            this->fail(reactor,
+                       "no frames for " +
+                           std::to_string(
+                               std::chrono::duration_cast<std::chrono::seconds>(
+                                   supervisor_.stall_timeout())
+                                   .count()) +
+                           " seconds");
+            return;
+        }
+        this->update_interest(reactor);
+    }
+
+    /// Close the connection, call after the network thread has stopped.
+    void shutdown() { ws_.close(); }
+
+    /// Return the socket watched by the Reactor, -1 while closed.
+    [[nodiscard]] auto fd() const -> int { return ws_.fd(); }
+
+    /// Return the name of the adapter's market.
+    [[nodiscard]] static auto constexpr name() -> char const*
+    {
+        return Adapter_t::name;
+    }
+
+    /// Return recorded and recovered outages, oldest first.
+    [[nodiscard]] auto outages() const -> std::vector<Outage>
+    {
+        return supervisor_.outages();
+    }
+
+    [[nodiscard]] auto stats() const -> Feed_stats
+    {
+        auto result          = Feed_stats{};
+        result.frames        = frames_.load(std::memory_order_relaxed);
+        result.prices        = prices_.load(std::memory_order_relaxed);
+        result.dropped       = dropped_.load(std::memory_order_relaxed);
+        result.subscriptions =
+            subscription_count_.load(std::memory_order_relaxed);
+        result.outages       = supervisor_.outages().size();
+        result.connected     = !supervisor_.in_outage();
+        return result;
+    }
+
+   private:
+    Adapter_t adapter_;
+    Websocket_client ws_;
+    Connection_supervisor supervisor_{Adapter_t::name,
+                                      Adapter_t::stall_timeout};
+
+    // Active subscriptions, replayed each time the websocket opens.
+    std::set<Asset> subscriptions_;
+
+    detail::Locking_asset_list to_subscribe_;
+    detail::Locking_asset_list to_unsubscribe_;
+
+    // Order book subscriptions, only used if has_depth_v<Adapter_t>.
+    std::set<Asset> depth_subscriptions_;
+    detail::Locking_asset_list to_subscribe_depth_;
+    detail::Locking_asset_list to_unsubscribe_depth_;
+
+    // Depth of each changed book, pending_depth_ holds the newest per Asset
+    // until drain_depth(). Depths are fixed size, publishing doesn't
+    // allocate once these have grown.
+    std::vector<std::pair<Asset, Depth>> changed_depth_;
+    std::vector<std::pair<Asset, Depth>> pending_depth_;
+    std::mutex depth_mtx_;
+
+    std::string message_;  // Reused for every incoming message.
+    bool want_write_ = false;
+
+    using Tick_ring_t = Spsc_ring<Tick, 4'096>;
+    std::unique_ptr<Tick_ring_t> ring_ = std::make_unique<Tick_ring_t>();
+    std::atomic<Price_bus*> bus_{nullptr};  // Optional, not owned.
+
+    // Asset ids used in Ticks. Ids are assigned on the network thread and
+    // never reused, assets_ is also read by drain() so it is locked.
+    std::map<Asset, std::uint32_t> ids_;
+    std::vector<Asset> assets_;
+    std::mutex assets_mtx_;
+
+    // drain() scratch space and trade statistics, only touched on the UI
+    // thread.
+    std::vector<Tick> batch_;
+    std::vector<std::size_t> drained_at_;  // Asset id to index in out.
+    std::vector<bool> traded_;
+    Trade_tracker tracker_;
+
+    std::atomic<std::uint64_t> frames_{0};
+    std::atomic<std::uint64_t> prices_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+    std::atomic<int> subscription_count_{0};
+
+   private:
+    void handle_message()
+    {
+        supervisor_.mark_alive();
+        frames_.fetch_add(1, std::memory_order_relaxed);
+        auto const received = Latency_monitor::now();
+        try {
+            auto* const bus = bus_.load(std::memory_order_acquire);
+            for (Price const& price : adapter_.parse(message_)) {
+                auto const tick = Tick::make(
+                    this->asset_id(price.asset), price.value,
+                    parse_double(price.value).value_or(0.), price.volume,
+                    price.time, received);
+                if (bus != nullptr) {
+                    bus->publish(price.asset, price.value, tick.price,
+                                 tick.volume, tick.trade_time());
+                }
+                if (ring_->push(tick))
+                    prices_.fetch_add(1, std::memory_order_relaxed);
+                else
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        catch (std::exception const& e) {
+            log_error(std::string{Adapter_t::name} +
+                      " got non-fatal error from WS read: " + e.what());
+        }
+    }
+
+    /// Return the id of \p asset, assigning a new one if not seen before.
+    [[nodiscard]] auto asset_id(Asset const& asset) -> std::uint32_t
+    {
+        auto const at = ids_.find(asset);
+        if (at != std::end(ids_))
+            return at->second;
+        auto const lock = std::lock_guard{assets_mtx_};
+        auto const id   = static_cast<std::uint32_t>(assets_.size());
+        assets_.push_back(asset);
+        ids_.emplace(asset, id);
+        return id;
+    }
+
+    /// Start connecting, the Reactor reports when the socket can progress.
+    void open(Reactor& reactor)
+    {
+        log_status(std::string{"WS connect: "} + Adapter_t::host);
+        try {
+            ws_.open(Adapter_t::host, adapter_.resource());
+        }
+        catch (std::exception const& e) {
+            supervisor_.report_failure(e.what());
+            return;
+        }
+        // Connect and handshake count against the stall timeout.
+        supervisor_.mark_alive();
+        want_write_ = true;
+        reactor.add(ws_.fd(), want_write_);
+    }
+
+    /// Return true if any price or order book stream is wanted.
+    /** A feed with neither has no reason to connect or to hear frames. */
+    [[nodiscard]] auto has_subscriptions() const -> bool
+    {
+        return !subscriptions_.empty() || !depth_subscriptions_.empty();
+    }
+
+    /// Replay every active subscription once the websocket is open.
+    void opened()
+    {
+        if (supervisor_.in_outage())
+            supervisor_.recovered();
+        if (!subscriptions_.empty()) {
+            log_status(std::string{Adapter_t::name} + " WS Subscribing to " +
+                       std::to_string(subscriptions_.size()) + " asset(s).");
+            this->send(adapter_.subscribe_messages(
+                {std::cbegin(subscriptions_), std::cend(subscriptions_)}));
+        }
+        if constexpr (has_depth_v<Adapter_t>) {
+            // Each book is rebuilt from the snapshot sent after subscribing.
+            if (!depth_subscriptions_.empty()) {
+                this->send(adapter_.subscribe_depth_messages(
+                    {std::cbegin(depth_subscriptions_),
+                     std::cend(depth_subscriptions_)}));
+            }
+        }
+    }
+
+    /// Move the Depth of each changed book to pending_depth_.
+    /** Returns true if any were moved. Takes the lock once per wakeup rather
+     *  than once per message. */
+    auto publish_depth() -> bool
+    {
+        changed_depth_.clear();
+        adapter_.take_depth(changed_depth_);
+        if (changed_depth_.empty())
+            return false;
+        auto const lock = std::lock_guard{depth_mtx_};
+        for (auto& [asset, depth] : changed_depth_) {
+            auto const at = std::find_if(
+                std::begin(pending_depth_), std::end(pending_depth_),
+                [&](auto const& pending) { return pending.first == asset; });
+            if (at == std::end(pending_depth_))
+                pending_depth_.emplace_back(asset, depth);
+            else
+                at->second = depth;
+        }
+        return true;
+    }
+
+    /// Drop the connection and record the failure with the supervisor.
+    void fail(Reactor& reactor, std::string const& reason)
+    {
+        reactor.remove(ws_.fd());
+        ws_.close();
+        supervisor_.report_failure(reason);
+    }
+
+    void send(std::vector<std::string> const& messages)
+    {
+        for (auto const& message : messages)
+            ws_.send_text(message);
+    }
+
+    /// Only ask the Reactor for writability while there is something to send.
+    void update_interest(Reactor& reactor)
+    {
+        if (ws_.fd() == -1 || ws_.wants_write() == want_write_)
+            return;
+        want_write_ = ws_.wants_write();
+        reactor.modify(ws_.fd(), want_write_);
+    }
+
+    /// Apply queued subscribe and unsubscribe requests as two batches.
+    /** Sent right away if the websocket is open, otherwise they are sent as
+     *  part of the replay when it opens. */
+    void flush_subscriptions()
+    {
+        auto batch = std::vector<Asset>{};
+        {
+            auto const lock = to_subscribe_.lock();
+            batch.assign(std::begin(to_subscribe_), std::end(to_subscribe_));
+            to_subscribe_.clear();
+        }
+        if (!batch.empty()) {
+            log_status(std::string{Adapter_t::name} + " WS Subscribing to " +
+                       std::to_string(batch.size()) + " asset(s).");
+            subscriptions_.insert(std::cbegin(batch), std::cend(batch));
+            if (ws_.is_open())
+                this->send(adapter_.subscribe_messages(batch));
+        }
+        batch.clear();
+        {
+            auto const lock = to_unsubscribe_.lock();
+            batch.assign(std::begin(to_unsubscribe_),
+                         std::end(to_unsubscribe_));
+            to_unsubscribe_.clear();
+        }
+        if (!batch.empty()) {
+            log_status(std::string{Adapter_t::name} +
+                       " WS Unsubscribing from " +
+                       std::to_string(batch.size()) + " asset(s).");
+            for (auto const& asset : batch)
+                subscriptions_.erase(asset);
+            if (ws_.is_open())
+                this->send(adapter_.unsubscribe_messages(batch));
+        }
+        subscription_count_.store(static_cast<int>(subscriptions_.size()),
+                                  std::memory_order_relaxed);
+        if constexpr (has_depth_v<Adapter_t>)
+            this->flush_depth_subscriptions();
+    }
+
+    /// Apply queued order book subscribe and unsubscribe requests.
+    void flush_depth_subscriptions()
+    {
+        auto batch = std::vector<Asset>{};
+        {
+            auto const lock = to_subscribe_depth_.lock();
+            batch.assign(std::begin(to_subscribe_depth_),
+                         std::end(to_subscribe_depth_));
+            to_subscribe_depth_.clear();
+        }
+        if (!batch.empty()) {
+            log_status(std::string{Adapter_t::name} +
+                       " WS Subscribing to order books of " +
+                       std::to_string(batch.size()) + " asset(s).");
+            depth_subscriptions_.insert(std::cbegin(batch), std::cend(batch));
+            auto const messages = adapter_.subscribe_depth_messages(batch);
+            if (ws_.is_open())
+                this->send(messages);
+        }
+        batch.clear();
+        {
+            auto const lock = to_unsubscribe_depth_.lock();
+            batch.assign(std::begin(to_unsubscribe_depth_),
+                         std::end(to_unsubscribe_depth_));
+            to_unsubscribe_depth_.clear();
+        }
+        if (!batch.empty()) {
+            for (auto const& asset : batch)
+                depth_subscriptions_.erase(asset);
+            auto const messages = adapter_.unsubscribe_depth_messages(batch);
+            if (ws_.is_open())
+                this->send(messages);
+        }
+    }
+};
+
+}  // namespace crab
+#endif  // CRAB_MARKETS_FEED_HPP
@@ -1,7 +1,7 @@
 #include "finnhub.hpp"
 
-#include <algorithm>
-#include <iterator>
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -10,12 +10,14 @@
 #include <ntwk/check_response.hpp>
 #include <ntwk/https_socket.hpp>
 #include <ntwk/url_encode.hpp>
-#include <ntwk/websocket.hpp>
 
 #include "../asset.hpp"
+#include "../filenames.hpp"
 #include "../log.hpp"
 #include "../price.hpp"
 #include "../stats.hpp"
+#include "../symbol_id_json.hpp"
+#include "error.hpp"
 #include "symbol_id_cache.hpp"
 
 namespace {
@@ -31,10 +33,18 @@ namespace {
     return "/api/v1/" + resource + key;
 }
 
+/// Throw Rate_limited if \p body is Finnhub's over the limit response.
+/** Finnhub answers with HTTP 429 and this message in the body. */
+void check_rate_limit(std::string const& body)
+{
+    if (body.find("API limit reached") != std::string::npos)
+        throw crab::Rate_limited{"Finnhub API limit reached"};
+}
+
 using JSON_element_t = simdjson::simdjson_result<simdjson::dom::element>;
 
 [[nodiscard]] auto parse_prices(JSON_element_t const& e,
-                                crab::Symbol_ID_cache& id_cache)
+                                crab::Symbol_ID_cache const& id_cache)
     -> std::vector<crab::Price>
 {
     if ((std::string)e["type"] != "trade")
@@ -44,11 +54,38 @@ using JSON_element_t = simdjson::simdjson_result<simdjson::dom::element>;
     for (auto item : array) {
         auto const symbol_id = (std::string)item["s"];
         result.push_back({std::to_string((double)item["p"]),
-                          id_cache.find_asset(symbol_id)});
+                          id_cache.find_asset(symbol_id), (double)item["v"],
+                          (std::int64_t)item["t"]});
     }
     return result;
 }
 
+/// Build a subscribe or unsubscribe message for the given \p symbol_id.
+[[nodiscard]] auto subscription_json(std::string const& type,
+                                     std::string const& symbol_id)
+    -> std::string
+{
+    return "{\"type\":\"" + type + "\",\"symbol\":\"" + symbol_id + "\"}";
+}
+
+/// Symbol ids shared by the REST and websocket clients, loaded on first use.
+/** Falls back to an empty cache if ids.json can't be read. */
+[[nodiscard]] auto id_cache() -> crab::Symbol_ID_cache const&
+{
+    static auto const cache = [] {
+        try {
+            return crab::Symbol_ID_cache{
+                crab::read_ids_json(crab::symbol_ids_json_filepath())};
+        }
+        catch (std::exception const& e) {
+            crab::log_error("Failed to read ids.json: " +
+                            std::string{e.what()});
+            return crab::Symbol_ID_cache{{}};
+        }
+    }();
+    return cache;
+}
+
 [[nodiscard]] auto https_json_parser() -> simdjson::dom::parser&
 {
     static auto parser = simdjson::dom::parser{};
@@ -67,21 +104,25 @@ namespace crab {
 
 auto Finnhub::stats(Asset const& asset) -> Stats
 {
-    auto const asset_str = id_cache_.find_symbol_id(asset);
+    auto const asset_str = id_cache().find_symbol_id(asset);
     if (!https_socket_.is_connected())
         this->make_https_connection();
     auto const request = build_rest_query(
-        "quote?symbol=" + ntwk::url_encode(asset_str), this->get_key_param());
+        "quote?symbol=" + ntwk::url_encode(asset_str), key_.param());
     {
         auto const no_key_request = request.substr(0, request.find("token"));
         log_status("GET finnhub.io" + no_key_request);
     }
     try {
         auto const message = https_socket_.get(request);
+        check_rate_limit(message.body);
         check_response(message, "Finnhub - Failed to get stats");
         auto const element = https_json_parser().parse(message.body);
         return {(double)element["c"], (double)element["pc"]};
     }
+    catch (Rate_limited const&) {
+        throw;
+    }
     catch (std::exception const& e) {
         log_error("Finnhub failed to retrieve stats for: " + asset.exchange +
                   ' ' + asset.currency.base + ' ' + asset.currency.quote + ' ' +
@@ -90,17 +131,22 @@ auto Finnhub::stats(Asset const& asset) -> Stats
     }
 }
 
-auto Finnhub::search(std::string const& query) -> std::vector<Search_result>
+auto Finnhub::search(std::string const& query,
+                     std::function<bool()> const& is_abandoned)
+    -> std::vector<Search_result>
 {
     if (!https_socket_.is_connected())
         this->make_https_connection();
     auto const request = build_rest_query("search?q=" + ntwk::url_encode(query),
-                                          this->get_key_param());
+                                          key_.param());
     auto const no_key_request = request.substr(0, request.find("token"));
     log_status("GET finnhub.io" + no_key_request);
     try {
         auto const message = https_socket_.get(request);
+        check_rate_limit(message.body);
         check_response(message, "Finnhub - Failed to search for: " + query);
+        if (is_abandoned())
+            return {};
 
         auto result      = std::vector<Search_result>{};
         auto const array = https_json_parser().parse(message.body)["result"];
@@ -110,8 +156,8 @@ auto Finnhub::search(std::string const& query) -> std::vector<Search_result>
             auto const type        = (std::string)x["type"];
             auto sr                = Search_result{type, description, {}};
             if (type == "Crypto") {
-                if (id_cache_.is_cached(symbol_id)) {
-                    sr.asset = id_cache_.find_asset(symbol_id);
+                if (id_cache().is_cached(symbol_id)) {
+                    sr.asset = id_cache().find_asset(symbol_id);
                     result.push_back(sr);
                 }
             }
@@ -124,72 +170,43 @@ auto Finnhub::search(std::string const& query) -> std::vector<Search_result>
         }
         return result;
     }
+    catch (Rate_limited const&) {
+        throw;
+    }
     catch (std::exception const& e) {
         log_error("Finnhub failed to search for: " + query + " : " + e.what());
         return {};
     }
 }
 
-void Finnhub::subscribe(Asset const& asset)
+auto Finnhub_stream::subscribe_messages(std::vector<Asset> const& batch) const
+    -> std::vector<std::string>
 {
-    auto const json = std::string{"{\"type\":\"subscribe\",\"symbol\":\""} +
-                      id_cache_.find_symbol_id(asset) + "\"}";
-    if (!ws_.is_connected())
-        this->ws_connect();
-    log_status("Finnhub WS Subscribing: " + asset.exchange + ' ' +
-               asset.currency.base + ' ' + asset.currency.quote);
-    try {
-        ws_.write(json);
-        ++subscription_count_;
-    }
-    catch (std::exception const& e) {
-        log_error("Finnhub failed to subscribe to: " + asset.exchange + ' ' +
-                  asset.currency.quote + ' ' + asset.currency.quote + ' ' +
-                  e.what());
+    auto result = std::vector<std::string>{};
+    result.reserve(batch.size());
+    for (Asset const& asset : batch) {
+        result.push_back(
+            subscription_json("subscribe", id_cache().find_symbol_id(asset)));
     }
+    return result;
 }
 
-void Finnhub::unsubscribe(Asset const& asset)
+auto Finnhub_stream::unsubscribe_messages(
+    std::vector<Asset> const& batch) const -> std::vector<std::string>
 {
-    auto const json = std::string{"{\"type\":\"unsubscribe\",\"symbol\":\""} +
-                      id_cache_.find_symbol_id(asset) + "\"}";
-    if (!ws_.is_connected())
-        this->ws_connect();
-    log_status("Finnhub WS Unsubscribing: " + asset.exchange + ' ' +
-               asset.currency.base + ' ' + asset.currency.quote);
-    try {
-        ws_.write(json);
-        --subscription_count_;
-    }
-    catch (std::exception const& e) {
-        log_error("Finnhub failed to unsubscribe to: " + asset.exchange + ' ' +
-                  asset.currency.quote + ' ' + asset.currency.quote + ' ' +
-                  e.what());
+    auto result = std::vector<std::string>{};
+    result.reserve(batch.size());
+    for (Asset const& asset : batch) {
+        result.push_back(
+            subscription_json("unsubscribe", id_cache().find_symbol_id(asset)));
     }
+    return result;
 }
 
-auto Finnhub::stream_read() -> std::vector<Price>
+auto Finnhub_stream::parse(std::string const& message) -> std::vector<Price>
 {
-    if (!ws_.is_connected())
-        this->ws_connect();
-    try {
-        auto prices =
-            parse_prices(ws_json_parser().parse(ws_.read()), id_cache_);
-        // Remove Duplicates so up/down indicators work properly. Keep newest.
-        std::stable_sort(
-            std::begin(prices), std::end(prices),
-            [](auto const& a, auto const& b) { return a.asset < b.asset; });
-        auto const end = std::unique(
-            std::rbegin(prices), std::rend(prices),
-            [](auto const& a, auto const& b) { return a.asset == b.asset; });
-        prices.erase(std::begin(prices), end.base());
-        return prices;
-    }
-    catch (std::exception const& e) {
-        log_error("Finnhub Failed to read from Websocket: " +
-                  std::string{e.what()});
-        throw;
-    }
+    // Every trade is kept for volume, the Feed only displays the newest.
+    return parse_prices(ws_json_parser().parse(message), id_cache());
 }
 
 }  // namespace crab
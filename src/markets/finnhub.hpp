@@ -1,14 +1,15 @@
 #ifndef CRAB_MARKETS_FINNHUB_HPP
 #define CRAB_MARKETS_FINNHUB_HPP
 #include <cassert>
+#include <chrono>
 #include <exception>
 #include <fstream>
+#include <functional>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
 #include <ntwk/https_socket.hpp>
-#include <ntwk/websocket.hpp>
 
 #include <simdjson.h>
 
@@ -19,12 +20,47 @@
 #include "../price.hpp"
 #include "../search_result.hpp"
 #include "../stats.hpp"
-#include "../symbol_id_json.hpp"
 #include "error.hpp"
-#include "symbol_id_cache.hpp"
+
+namespace crab::detail {
+
+/// Lazily reads the Finnhub API key into a "token=..." query parameter.
+class Finnhub_key {
+   public:
+    /// Return the key parameter, retries reading the key file while empty.
+    auto param() -> std::string const&
+    {
+        if (key_param_.empty()) {
+            try {
+                key_param_ = "token=" + parse_key(finnhub_key_filepath());
+            }
+            catch (std::exception const& e) {
+                log_error(e.what());
+            }
+        }
+        return key_param_;
+    }
+
+   private:
+    std::string key_param_;
+
+   private:
+    [[nodiscard]] static auto parse_key(fs::path const& filepath) -> std::string
+    {
+        auto file = std::ifstream{filepath.string()};
+        auto key  = std::string{};
+        file >> key;
+        if (key.empty())
+            throw std::runtime_error{"Empty Finnhub API Key in finnhub.key"};
+        return key;
+    }
+};
+
+}  // namespace crab::detail
 
 namespace crab {
 
+/// Finnhub REST API, used for stats and search of any Asset.
 class Finnhub {
    public:
     /// Connect internal https socket.
@@ -43,75 +79,53 @@ class Finnhub {
     /// Disconnect internal https socket.
     void disconnect_https() { https_socket_.disconnect(); }
 
-    /// Disconnect internal Websocket.
-    void disconnect_websocket() { ws_.disconnect(); }
-
    public:
     /// HTTPS Request for Current and Opening price of Stock or Crypto.
+    /** Throws Rate_limited if over the API call limit. */
     [[nodiscard]] auto stats(Asset const& asset) -> Stats;
 
     /// HTTPS Request for Assets, using \p query.
-    [[nodiscard]] auto search(std::string const& query)
+    /** Returns nothing if \p is_abandoned is true once the response arrives.
+     *  Throws Rate_limited if over the API call limit. */
+    [[nodiscard]] auto search(std::string const& query,
+                              std::function<bool()> const& is_abandoned)
         -> std::vector<Search_result>;
 
+   private:
+    mutable ntwk::HTTPS_socket https_socket_;
+    detail::Finnhub_key key_;
+};
+
+/// Finnhub websocket protocol for live prices, serves non-direct exchanges.
+/** Market adapter, see market_adapter.hpp. */
+class Finnhub_stream {
    public:
-    /// Subscribe to websocket update for \p asset.
-    void subscribe(Asset const& asset);
+    static auto constexpr name = "Finnhub";
 
-    /// Subscribe to websocket update for \p asset.
-    void unsubscribe(Asset const& asset);
+    static auto constexpr host = "ws.finnhub.io";
 
-    /// Read a single response from the websocket, parsed into multiple Prices
-    auto stream_read() -> std::vector<Price>;
+    // Finnhub does not heartbeat per symbol, so quiet periods are expected.
+    static auto constexpr stall_timeout = std::chrono::seconds{60};
 
-    /// Return number of subscriptions on the websocket.
-    [[nodiscard]] auto subscription_count() const
-    {
-        return subscription_count_;
-    }
+   public:
+    /// Websocket resource with the API key query parameter.
+    [[nodiscard]] auto resource() -> std::string { return "/?" + key_.param(); }
 
-   private:
-    ntwk::Websocket ws_;
-    mutable ntwk::HTTPS_socket https_socket_;
-    std::string key_param_;
-    int subscription_count_   = 0;
-    Symbol_ID_cache id_cache_ = read_ids_json(symbol_ids_json_filepath());
+    /// One subscribe message for each Asset in \p batch.
+    [[nodiscard]] auto subscribe_messages(std::vector<Asset> const& batch) const
+        -> std::vector<std::string>;
 
-   private:
-    [[nodiscard]] static auto parse_key(fs::path const& filepath) -> std::string
-    {
-        auto file = std::ifstream{filepath.string()};
-        auto key  = std::string{};
-        file >> key;
-        if (key.empty())
-            throw std::runtime_error{"Empty Finnhub API Key in finnhub.key"};
-        return key;
-    }
+    /// One unsubscribe message for each Asset in \p batch.
+    [[nodiscard]] auto unsubscribe_messages(
+        std::vector<Asset> const& batch) const -> std::vector<std::string>;
 
-    auto get_key_param() -> std::string const&
-    {
-        if (key_param_.empty()) {
-            try {
-                key_param_ = "token=" + parse_key(finnhub_key_filepath());
-            }
-            catch (std::exception const& e) {
-                log_error(e.what());
-            }
-        }
-        return key_param_;
-    }
+    /// Parse a single message from the websocket into multiple Prices.
+    /** Every trade in the message is returned, in order, so their volume is
+     *  counted. The Feed merges them to the newest Price of each Asset. */
+    [[nodiscard]] auto parse(std::string const& message) -> std::vector<Price>;
 
-    void ws_connect()
-    {
-        log_status("WS connect: ws.finnhub.io");
-        try {
-            ws_.connect("ws.finnhub.io", "/?" + this->get_key_param());
-        }
-        catch (std::exception const& e) {
-            log_error("Finnhub Websocket failed to connect: " +
-                      std::string{e.what()});
-        }
-    }
+   private:
+    detail::Finnhub_key key_;
 };
 
 }  // namespace crab
@@ -0,0 +1,79 @@
+#include "latency_monitor.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../asset.hpp"
+
+namespace {
+
+auto constexpr minute_ms = std::int64_t{60'000};
+
+}  // namespace
+
+namespace crab {
+
+void Latency_monitor::record(Asset const& asset,
+                             std::int64_t received,
+                             std::int64_t time)
+{
+    if (received == 0)
+        return;
+    auto& m = markets_[asset.exchange.empty() ? "Stock" : asset.exchange];
+    ++m.ticks;
+    m.received = std::max(m.received, received);
+    if (time == 0)
+        return;
+
+    auto const latency = std::max(std::int64_t{0}, received - time);
+    if (!m.timed) {
+        m.timed   = true;
+        m.average = static_cast<double>(latency);
+    }
+    else
+        m.average += smoothing * (static_cast<double>(latency) - m.average);
+
+    auto const minute = received / minute_ms;
+    if (minute != m.minute) {
+        m.previous = minute == m.minute + 1 ? m.worst : 0;
+        m.worst    = 0;
+        m.minute   = minute;
+    }
+    m.worst = std::max(m.worst, latency);
+}
+
+auto Latency_monitor::report(std::int64_t now) const
+    -> std::vector<Market_latency>
+{
+    auto result = std::vector<Market_latency>{};
+    result.reserve(markets_.size());
+    for (auto const& [name, m] : markets_) {
+        auto entry    = Market_latency{};
+        entry.market  = name;
+        entry.ticks   = m.ticks;
+        entry.idle_ms = std::max(std::int64_t{0}, now - m.received);
+        entry.timed   = m.timed;
+        if (m.timed) {
+            entry.average_ms  = m.average;
+            auto const minute = now / minute_ms;
+            if (minute == m.minute)
+                entry.worst_ms = std::max(m.worst, m.previous);
+            else if (minute == m.minute + 1)
+                entry.worst_ms = m.worst;
+        }
+        result.push_back(entry);
+    }
+    return result;
+}
+
+auto Latency_monitor::now() -> std::int64_t
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+}  // namespace crab
@@ -0,0 +1,69 @@
+#ifndef CRAB_MARKETS_LATENCY_MONITOR_HPP
+#define CRAB_MARKETS_LATENCY_MONITOR_HPP
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../asset.hpp"
+#include "../price.hpp"
+
+namespace crab {
+
+/// Feed latency and staleness of one market, as of a report.
+struct Market_latency {
+    std::string market;             // Exchange name, "Stock" for stocks.
+    std::uint64_t ticks   = 0;      // Received since startup, see record().
+    std::int64_t idle_ms  = 0;      // Since the last tick was received.
+    bool timed            = false;  // Trade times reported, below are valid.
+    double average_ms     = 0.;     // Smoothed receive time - trade time.
+    std::int64_t worst_ms = 0;      // Largest over the last one or two minutes.
+};
+
+/// Exchange to screen latency of every market, from the times of each tick.
+/** Latency is the local receive time less the exchange trade time, so it
+ *  includes any clock skew between the two, negative values count as 0.
+ *  Ticks without a trade time only count towards staleness. Not thread
+ *  safe. */
+class Latency_monitor {
+   public:
+    /// Weight of each new latency in the smoothed average.
+    static auto constexpr smoothing = 0.05;
+
+   public:
+    /// Record the receipt of one tick of \p asset, in order of receipt.
+    /** \p received and the trade \p time are in ms since epoch, \p time is
+     *  0 if unknown. Ignored without a receive time. Feed::drain() records
+     *  every tick as received from the exchange. */
+    void record(Asset const& asset, std::int64_t received, std::int64_t time);
+
+    /// Record the receipt of \p price, as one tick.
+    /** For prices from the daemon, which are already merged per drain. */
+    void record(Price const& price)
+    {
+        this->record(price.asset, price.received, price.time);
+    }
+
+    /// Return the statistics of every market seen, \p now in ms since epoch.
+    [[nodiscard]] auto report(std::int64_t now) const
+        -> std::vector<Market_latency>;
+
+    /// Return the system time in ms since epoch, comparable to trade times.
+    [[nodiscard]] static auto now() -> std::int64_t;
+
+   private:
+    struct Market {
+        std::uint64_t ticks   = 0;
+        std::int64_t received = 0;   // Of the latest tick.
+        bool timed            = false;
+        double average        = 0.;
+        std::int64_t minute   = -1;  // received / 60'000 of worst.
+        std::int64_t worst    = 0;   // Within minute.
+        std::int64_t previous = 0;   // Within the minute before.
+    };
+
+    std::map<std::string, Market> markets_;
+};
+
+}  // namespace crab
+#endif  // CRAB_MARKETS_LATENCY_MONITOR_HPP
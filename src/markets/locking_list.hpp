@@ -0,0 +1,54 @@
+#ifndef CRAB_MARKETS_LOCKING_LIST_HPP
+#define CRAB_MARKETS_LOCKING_LIST_HPP
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../asset.hpp"
+
+namespace crab::detail {
+
+/// List of values with mutex lock.
+template <typename T>
+class Locking_list {
+   public:
+    auto lock() { return std::lock_guard{mtx_}; }
+
+   public:
+    void push_back(T value) { values_.push_back(std::move(value)); }
+
+    void clear() { values_.clear(); }
+
+   public:
+    auto begin() const { return std::cbegin(values_); }
+
+    auto begin() { return std::begin(values_); }
+
+    auto end() const { return std::cend(values_); }
+
+    auto end() { return std::end(values_); }
+
+    auto front() const { return values_.front(); }
+
+    auto front() { return values_.front(); }
+
+    auto back() const { return values_.back(); }
+
+    auto back() { return values_.back(); }
+
+    auto size() const { return values_.size(); }
+
+    auto empty() const { return values_.empty(); }
+
+   private:
+    std::vector<T> values_;
+    std::mutex mtx_;
+};
+
+using Locking_asset_list  = Locking_list<Asset>;
+using Locking_string_list = Locking_list<std::string>;
+
+}  // namespace crab::detail
+#endif  // CRAB_MARKETS_LOCKING_LIST_HPP
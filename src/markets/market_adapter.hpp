@@ -0,0 +1,105 @@
+#ifndef CRAB_MARKETS_MARKET_ADAPTER_HPP
+#define CRAB_MARKETS_MARKET_ADAPTER_HPP
+#include <chrono>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../asset.hpp"
+#include "../price.hpp"
+#include "order_book.hpp"
+
+namespace crab {
+
+/* Market Adapter Requirements
+ * ---------------------------
+ * A market adapter describes the websocket protocol of a single venue, it
+ * does no I/O itself. Feed<T> owns the socket and drives it from the shared
+ * network Reactor, calling into the adapter to build and parse messages.
+ * Feed<T> is instantiated with the concrete adapter type, so every call is
+ * resolved at compile time, there is no virtual dispatch on the read path.
+ *
+ *   static constexpr char const* name;
+ *       Used in logs and outage records.
+ *
+ *   static constexpr char const* host;
+ *       Websocket host, always connected to over TLS on port 443.
+ *
+ *   static constexpr std::chrono::seconds stall_timeout;
+ *       Time without any frame before the connection is considered stalled.
+ *
+ *   auto resource() -> std::string;
+ *       Resource requested in the websocket upgrade, may include a query.
+ *
+ *   auto subscribe_messages(std::vector<Asset> const& batch)
+ *       -> std::vector<std::string>;
+ *   auto unsubscribe_messages(std::vector<Asset> const& batch)
+ *       -> std::vector<std::string>;
+ *       Text messages that (un)subscribe every Asset in batch.
+ *
+ *   auto parse(std::string const& message) -> std::vector<Price>;
+ *       Return the Prices held in a single message, possibly none. Throws on
+ *       malformed messages or errors reported by the venue, the connection
+ *       is kept open in that case.
+ *
+ * Optional, for venues that stream order book depth, see has_depth_v:
+ *
+ *   auto subscribe_depth_messages(std::vector<Asset> const& batch)
+ *       -> std::vector<std::string>;
+ *   auto unsubscribe_depth_messages(std::vector<Asset> const& batch)
+ *       -> std::vector<std::string>;
+ *       Text messages that start or stop order book updates for every Asset
+ *       in batch. The adapter keeps an Order_book per Asset, built by parse()
+ *       from the updates, unsubscribing drops it.
+ *
+ *   void take_depth(std::vector<std::pair<Asset, Depth>>& out);
+ *       Append the Depth of each Order_book changed since the last call.
+ */
+
+namespace detail {
+
+template <typename T, typename = void>
+struct Is_market_adapter : std::false_type {};
+
+template <typename T>
+struct Is_market_adapter<
+    T,
+    std::void_t<decltype(T::name),
+                decltype(T::host),
+                decltype(T::stall_timeout),
+                decltype(std::declval<T&>().resource()),
+                decltype(std::declval<T&>().subscribe_messages(
+                    std::declval<std::vector<Asset> const&>())),
+                decltype(std::declval<T&>().unsubscribe_messages(
+                    std::declval<std::vector<Asset> const&>()))>>
+    : std::is_same<decltype(std::declval<T&>().parse(
+                       std::declval<std::string const&>())),
+                   std::vector<Price>> {};
+
+template <typename T, typename = void>
+struct Has_depth : std::false_type {};
+
+template <typename T>
+struct Has_depth<
+    T,
+    std::void_t<decltype(std::declval<T&>().subscribe_depth_messages(
+                    std::declval<std::vector<Asset> const&>())),
+                decltype(std::declval<T&>().unsubscribe_depth_messages(
+                    std::declval<std::vector<Asset> const&>())),
+                decltype(std::declval<T&>().take_depth(
+                    std::declval<std::vector<std::pair<Asset, Depth>>&>()))>>
+    : std::true_type {};
+
+}  // namespace detail
+
+/// True if \p T meets the market adapter requirements above.
+template <typename T>
+bool constexpr is_market_adapter_v = detail::Is_market_adapter<T>::value;
+
+/// True if the market adapter \p T also streams order book depth.
+template <typename T>
+bool constexpr has_depth_v = detail::Has_depth<T>::value;
+
+}  // namespace crab
+#endif  // CRAB_MARKETS_MARKET_ADAPTER_HPP
@@ -1,291 +1,716 @@
 #ifndef CRAB_MARKETS_MARKETS_HPP
 #define CRAB_MARKETS_MARKETS_HPP
-#include <mutex>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
 #include <string>
 #include <thread>
+#include <tuple>
 #include <type_traits>
 #include <utility>
+#include <variant>
 #include <vector>
 
 #include <signals_light/signal.hpp>
+#include <termox/system/event.hpp>
 #include <termox/system/event_loop.hpp>
 
 #include "../asset.hpp"
+#include "../log.hpp"
 #include "../stats.hpp"
+#include "../thread_config.hpp"
 #include "coinbase.hpp"
+#include "connection_supervisor.hpp"
+#include "daemon_client.hpp"
+#include "daemon_protocol.hpp"
+#include "feed.hpp"
 #include "finnhub.hpp"
-#include "termox/system/event.hpp"
+#include "latency_monitor.hpp"
+#include "error.hpp"
+#include "order_book.hpp"
+#include "price_bus.hpp"
+#include "reactor.hpp"
+#include "rest_scheduler.hpp"
+#include "trade_tracker.hpp"
 
 namespace crab::detail {
 
-/// List of values with mutex lock.
-template <typename T>
-class Locking_list {
-   public:
-    auto lock() { return std::lock_guard{mtx_}; }
-
-   public:
-    void push_back(T value) { values_.push_back(std::move(value)); }
-
-    void clear() { values_.clear(); }
-
-   public:
-    auto begin() const { return std::cbegin(values_); }
-
-    auto begin() { return std::begin(values_); }
-
-    auto end() const { return std::cend(values_); }
-
-    auto end() { return std::end(values_); }
-
-    auto front() const { return values_.front(); }
-
-    auto front() { return values_.front(); }
-
-    auto back() const { return values_.back(); }
-
-    auto back() { return values_.back(); }
-
-    auto size() const { return values_.size(); }
-
-    auto empty() const { return values_.empty(); }
-
-   private:
-    std::vector<T> values_;
-    std::mutex mtx_;
-};
-
-using Locking_asset_list  = Locking_list<Asset>;
-using Locking_string_list = Locking_list<std::string>;
+template <typename T, typename Tuple_t>
+struct Tuple_index;
+
+template <typename T, typename... Ts>
+struct Tuple_index<T, std::tuple<T, Ts...>>
+    : std::integral_constant<std::size_t, 0> {};
+
+template <typename T, typename U, typename... Ts>
+struct Tuple_index<T, std::tuple<U, Ts...>>
+    : std::integral_constant<std::size_t,
+                             1 + Tuple_index<T, std::tuple<Ts...>>::value> {};
+
+/// Call \p f with the element of \p t at runtime index \p i.
+template <typename Tuple_t, typename F, std::size_t... Is>
+void visit_at(Tuple_t& t, std::size_t i, F&& f, std::index_sequence<Is...>)
+{
+    ((i == Is ? (f(std::get<Is>(t)), true) : false) || ...);
+}
+
+template <typename Tuple_t, typename F>
+void visit_at(Tuple_t& t, std::size_t i, F&& f)
+{
+    visit_at(t, i, std::forward<F>(f),
+             std::make_index_sequence<std::tuple_size_v<Tuple_t>>{});
+}
+
+/// Call \p f with each element of \p t.
+template <typename Tuple_t, typename F>
+void for_each(Tuple_t& t, F&& f)
+{
+    std::apply([&f](auto&... x) { (f(x), ...); }, t);
+}
 
 }  // namespace crab::detail
 
 namespace crab {
 
 /// Wrapper around all concrete markets, makes decisions on which market to use.
+/** Streaming markets are market adapters, each run by its own Feed. Feeds are
+ *  spread over the network threads set in threads.txt, one by default, each
+ *  blocked on its own Reactor. All REST requests go through a single worker,
+ *  so the thread count does not grow with venues or connections. To add a
+ *  direct feed for a venue, add its adapter to Feeds_t and route its exchange
+ *  name to it in routes_.
+ *
+ *  After connect_daemon(), requests are sent to a crabwise --daemon instead
+ *  and its replies are emitted by the same signals, no market connections are
+ *  opened. If the daemon goes away, the Markets falls back to its own. */
 class Markets {
    public:
-    sl::Signal<void(Price const&)> price_update;
+    /// Emitted once per drain with every Price in it, on the UI thread.
+    sl::Signal<void(std::vector<Price> const&)> price_update;
     sl::Signal<void(Asset const&, Stats const&)> stats_received;
     sl::Signal<void(std::vector<Search_result> const&)> search_results_received;
+    sl::Signal<void()> search_finished;
 
-   private:
-    std::mutex price_update_mtx_;  // locked when emitting
+    /// Emitted with the newest Depth of each order book that changed.
+    /** Only for Assets passed to subscribe_depth(), at most once per Asset
+     *  per drain of the Feeds. */
+    sl::Signal<void(Asset const&, Depth const&)> depth_update;
+
+    /// Emitted with the rolling trade statistics of each Asset traded.
+    /** Only for streamed trades that report a size, at most once per Asset
+     *  per drain of the Feeds. */
+    sl::Signal<void(Asset const&, Trade_summary const&)> trades_update;
 
    public:
+    /// Serve every request through the daemon listening at \p path.
+    /** Returns false if none answers. Call before launch_streams(). */
+    auto connect_daemon(std::string const& path) -> bool
+    {
+        try {
+            daemon_ = std::make_unique<Daemon_client>(
+                path, std::chrono::milliseconds{500});
+        }
+        catch (Crab_error const&) {
+            return false;
+        }
+        remote_ = true;
+        return true;
+    }
+
+    /// Return the feed latency and staleness of every market streamed.
+    /** Call from the UI thread. Every tick from the exchange is counted.
+     *  While remote, each price from the daemon counts as one tick, and
+     *  latency is measured to its receipt. */
+    [[nodiscard]] auto latency_report() const -> std::vector<Market_latency>
+    {
+        return latency_.report(Latency_monitor::now());
+    }
+
+    /// Return true while requests are served by a daemon.
+    [[nodiscard]] auto is_remote() const -> bool { return remote_; }
+
     void shutdown()
     {
-        finnhub_.disconnect_https();
-        finnhub_loop_.exit(0);
-        finnhub_loop_.wait();
-        finnhub_.disconnect_websocket();
+        daemon_loop_.exit(0);
+        daemon_loop_.wait();
+        for (auto t = std::size_t{0}; t < net_threads_; ++t) {
+            net_loops_[t].exit(0);
+            reactors_[t]->wake();
+        }
+        for (auto t = std::size_t{0}; t < net_threads_; ++t)
+            net_loops_[t].wait();
+        detail::for_each(feeds_, [](auto& feed) { feed.shutdown(); });
 
-        coinbase_loop_.exit(0);
-        coinbase_loop_.wait();
-        coinbase_.disconnect_websocket();
+        rest_loop_.exit(0);
+        rest_loop_.wait();
+        finnhub_.disconnect_https();
+    }
 
-        stats_loop_.exit(0);
-        stats_loop_.wait();
+    void request_stats(Asset const& asset,
+                       Rest_lane lane = Rest_lane::Visible)
+    {
+        if (remote_) {
+            daemon_->send(request_stats_frame(lane, {asset}));
+            return;
+        }
+        if (!rest_loop_.is_running())
+            this->launch_rest_loop();
+        rest_.request_stats(asset, lane);
+    }
 
-        search_loop_.exit(0);
-        search_loop_.wait();
+    /// Queue a stats request for every Asset in \p batch.
+    void request_stats(std::vector<Asset> const& batch,
+                       Rest_lane lane = Rest_lane::Visible)
+    {
+        if (remote_) {
+            daemon_->send(request_stats_frame(lane, batch));
+            return;
+        }
+        if (!rest_loop_.is_running())
+            this->launch_rest_loop();
+        for (auto const& asset : batch)
+            rest_.request_stats(asset, lane);
     }
 
-    void request_stats(Asset const& asset)
+    /// Queue a stats request in \p lane for every subscribed Asset.
+    /** Called periodically so last closes roll over while left running. */
+    void refresh_stats(Rest_lane lane = Rest_lane::Background)
     {
-        auto const lock = stats_requested_.lock();
-        if (!stats_loop_.is_running())
-            this->launch_stats_loop();
-        stats_requested_.push_back(asset);
+        if (remote_) {
+            daemon_->send(refresh_stats_frame(lane));
+            return;
+        }
+        if (!rest_loop_.is_running())
+            this->launch_rest_loop();
+        rest_.refresh_all(lane);
     }
 
+    /// Search for \p query, abandoning any earlier search.
+    /** Results are emitted in chunks by search_results_received, followed by
+     *  search_finished. Nothing more is emitted for an abandoned search. */
     void request_search(std::string const& query)
     {
-        auto const lock = search_requested_.lock();
-        if (!search_loop_.is_running())
-            this->launch_search_loop();
-        search_requested_.push_back(query);
+        if (search_running_ && query == last_search_)
+            return;
+        last_search_          = query;
+        search_running_       = true;
+        auto const generation =
+            search_generation_.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (remote_) {
+            daemon_->send(search_frame(query, generation));
+            return;
+        }
+        if (!rest_loop_.is_running())
+            this->launch_rest_loop();
+        rest_.request_search({query, generation});
     }
 
     void launch_streams()
     {
-        this->launch_stats_loop();
-        this->launch_search_loop();
-        this->launch_finnhub();
-        this->launch_coinbase();
+        if (remote_) {
+            this->launch_daemon_loop();
+            return;
+        }
+        this->launch_rest_loop();
+        this->launch_net_loop();
     }
 
     void subscribe(Asset const& asset)
     {
-        if (asset.exchange == "COINBASE") {
-            auto const lock = coinbase_to_subscribe_to_.lock();
-            coinbase_to_subscribe_to_.push_back(asset);
+        if (remote_) {
+            remote_subscriptions_.insert(asset);
+            daemon_->send(assets_frame(Frame_kind::Subscribe, {asset}));
+            return;
+        }
+        auto const feed = this->route(asset.exchange);
+        detail::visit_at(feeds_, feed,
+                         [&asset](auto& feed) { feed.subscribe(asset); });
+        this->reactor_of(feed).wake();
+    }
+
+    /// Subscribe to every Asset in \p batch, split into one batch per Feed.
+    void subscribe(std::vector<Asset> const& batch)
+    {
+        if (remote_) {
+            remote_subscriptions_.insert(std::cbegin(batch), std::cend(batch));
+            daemon_->send(assets_frame(Frame_kind::Subscribe, batch));
+            return;
         }
-        else {
-            auto const lock = finnhub_to_subscribe_to_.lock();
-            finnhub_to_subscribe_to_.push_back(asset);
+        auto per_feed = std::vector<std::vector<Asset>>(
+            std::tuple_size_v<Feeds_t>);
+        for (auto const& asset : batch)
+            per_feed[this->route(asset.exchange)].push_back(asset);
+        for (auto i = std::size_t{0}; i < per_feed.size(); ++i) {
+            if (per_feed[i].empty())
+                continue;
+            detail::visit_at(feeds_, i, [&per_feed, i](auto& feed) {
+                feed.subscribe(per_feed[i]);
+            });
+            this->reactor_of(i).wake();
         }
     }
 
     void unsubscribe(Asset const& asset)
     {
-        if (asset.exchange == "COINBASE") {
-            auto const lock = coinbase_to_unsubscribe_to_.lock();
-            coinbase_to_unsubscribe_to_.push_back(asset);
+        if (remote_) {
+            remote_subscriptions_.erase(asset);
+            daemon_->send(assets_frame(Frame_kind::Unsubscribe, {asset}));
+            return;
         }
-        else {
-            auto const lock = finnhub_to_unsubscribe_to_.lock();
-            finnhub_to_unsubscribe_to_.push_back(asset);
+        rest_.forget(asset);
+        auto const feed = this->route(asset.exchange);
+        detail::visit_at(feeds_, feed,
+                         [&asset](auto& feed) { feed.unsubscribe(asset); });
+        this->reactor_of(feed).wake();
+    }
+
+    /// Keep an order book of \p asset, reported by depth_update.
+    /** Logs and does nothing if the market of \p asset has no depth feed. */
+    void subscribe_depth(Asset const& asset)
+    {
+        if (remote_) {
+            remote_depth_.insert(asset);
+            daemon_->send(assets_frame(Frame_kind::Subscribe_depth, {asset}));
+            return;
         }
+        this->visit_depth(asset, [&asset](auto& feed) {
+            feed.subscribe_depth(asset);
+        });
     }
 
-   private:
-    Finnhub finnhub_;
-    Coinbase coinbase_;
+    void unsubscribe_depth(Asset const& asset)
+    {
+        if (remote_) {
+            remote_depth_.erase(asset);
+            daemon_->send(assets_frame(Frame_kind::Unsubscribe_depth, {asset}));
+            return;
+        }
+        this->visit_depth(asset, [&asset](auto& feed) {
+            feed.unsubscribe_depth(asset);
+        });
+    }
+
+    /// Set the window of trades_update's volume, VWAP and trade count.
+    /** Statistics so far are cleared. Call from the UI thread. A daemon
+     *  keeps its own window, from its trades.txt. */
+    void set_trade_window(Trade_tracker::Window_t window)
+    {
+        detail::for_each(feeds_, [window](auto& feed) {
+            feed.set_trade_window(window);
+        });
+    }
+
+    /// Publish every streamed tick to the shared memory region \p name.
+    /** Other processes on the host can read it with a Price_bus_reader. Call
+     *  at most once. Throws Crab_error if the region can't be created. Does
+     *  nothing while remote, the daemon publishes its own. */
+    void open_price_bus(std::string const& name, std::size_t slot_count)
+    {
+        if (remote_)
+            return;
+        bus_ = std::make_unique<Price_bus>(name, slot_count);
+        detail::for_each(feeds_, [this](auto& feed) {
+            feed.set_price_bus(bus_.get());
+        });
+    }
 
-    ox::Event_loop finnhub_loop_;
-    ox::Event_loop coinbase_loop_;
+    /// Return recorded outages of every streaming market, by market name.
+    [[nodiscard]] auto outages() const
+        -> std::map<std::string, std::vector<Outage>>
+    {
+        auto result = std::map<std::string, std::vector<Outage>>{};
+        detail::for_each(feeds_, [&result](auto const& feed) {
+            result[feed.name()] = feed.outages();
+        });
+        return result;
+    }
 
-    detail::Locking_asset_list coinbase_to_subscribe_to_;
-    detail::Locking_asset_list coinbase_to_unsubscribe_to_;
+    /// Return running counters of every streaming market, by market name.
+    [[nodiscard]] auto feed_stats() const -> std::map<std::string, Feed_stats>
+    {
+        auto result = std::map<std::string, Feed_stats>{};
+        detail::for_each(feeds_, [&result](auto const& feed) {
+            result[feed.name()] = feed.stats();
+        });
+        return result;
+    }
 
-    detail::Locking_asset_list finnhub_to_subscribe_to_;
-    detail::Locking_asset_list finnhub_to_unsubscribe_to_;
+   private:
+    using Feeds_t = std::tuple<Feed<Coinbase>, Feed<Finnhub_stream>>;
 
-    detail::Locking_asset_list stats_requested_;
-    ox::Event_loop stats_loop_;
+    template <typename Adapter_t>
+    static auto constexpr feed_index =
+        detail::Tuple_index<Feed<Adapter_t>, Feeds_t>::value;
 
-    detail::Locking_string_list search_requested_;
-    ox::Event_loop search_loop_;
+    /// Exchange name to index into feeds_, for exchanges with a direct feed.
+    struct Routes {
+        std::size_t fallback;
+        std::map<std::string, std::size_t> direct;
+    };
 
-    // search and stats both use the finnhub https socket.
-    std::mutex https_socket_mtx_;
+   private:
+    std::unique_ptr<Price_bus> bus_;  // Outlives the Feeds that publish.
+
+    // Remote mode, everything but daemon_loop_ is only touched on the UI
+    // thread. Subscriptions are kept to replay if the daemon goes away.
+    std::unique_ptr<Daemon_client> daemon_;
+    bool remote_ = false;
+    std::set<Asset> remote_subscriptions_;
+    std::set<Asset> remote_depth_;
+    ox::Event_loop daemon_loop_;
+
+    Finnhub finnhub_;  // REST only, stats and search for every exchange.
+    Feeds_t feeds_;
+    Routes const routes_{feed_index<Finnhub_stream>,
+                         {{"COINBASE", feed_index<Coinbase>}}};
+
+    static auto constexpr feed_count = std::tuple_size_v<Feeds_t>;
+
+    // Feed i is served by network thread i % net_threads_.
+    std::size_t const net_threads_ = std::clamp(
+        thread_config().role(Thread_role::Network).threads,
+        std::size_t{1}, feed_count);
+    // One per network thread, each holds an epoll instance or a wake pipe.
+    std::vector<std::unique_ptr<Reactor>> const reactors_ =
+        make_reactors(net_threads_);
+    std::array<ox::Event_loop, feed_count> net_loops_;
+
+    std::atomic<bool> drain_pending_{false};
+
+    // Only touched on the UI thread.
+    std::vector<Price> drained_;
+    std::vector<std::pair<Asset, Depth>> drained_depth_;
+    std::vector<std::pair<Asset, Trade_summary>> drained_trades_;
+    Latency_monitor latency_;
+
+    Rest_scheduler rest_;
+    ox::Event_loop rest_loop_;
+
+    static auto constexpr search_chunk_size = std::size_t{8};
+
+    // Bumped by each request_search, older searches are stale.
+    std::atomic<std::uint64_t> search_generation_{0};
+    std::string last_search_;      // Only touched on the UI thread.
+    bool search_running_ = false;  // Only touched on the UI thread.
 
    private:
-    // TODO should take event loop reference so it can exit itself.
-    template <typename Market_t, typename Locking_queue_t>
-    auto generate_loop_fn(Market_t& market,
-                          Locking_queue_t& to_sub,
-                          Locking_queue_t& to_unsub,
-                          ox::Event_loop& loop)
-    {
-        return [this, &market, &to_sub, &to_unsub, &loop](ox::Event_queue& q) {
-            {  // Subscribe
-                auto const lock = to_sub.lock();
-                for (auto const& asset : to_sub)
-                    market.subscribe(asset);
-                to_sub.clear();
-            }
-            {  // Unsubscribe
-                auto const lock = to_unsub.lock();
-                for (auto const& asset : to_unsub)
-                    market.unsubscribe(asset);
-                to_unsub.clear();
-            }
-            if (market.subscription_count() == 0)
-                std::this_thread::sleep_for(std::chrono::milliseconds{100});
+    /// Create one Reactor for each of \p count network threads.
+    [[nodiscard]] static auto make_reactors(std::size_t count)
+        -> std::vector<std::unique_ptr<Reactor>>
+    {
+        auto result = std::vector<std::unique_ptr<Reactor>>{};
+        result.reserve(count);
+        for (auto t = std::size_t{0}; t < count; ++t)
+            result.push_back(std::make_unique<Reactor>());
+        return result;
+    }
+
+    /// Return the Reactor of the network thread that serves feed \p i.
+    [[nodiscard]] auto reactor_of(std::size_t i) -> Reactor&
+    {
+        return *reactors_[i % net_threads_];
+    }
+
+    /// Return the index into feeds_ of the Feed that serves \p exchange.
+    [[nodiscard]] auto route(std::string const& exchange) const -> std::size_t
+    {
+        auto const at = routes_.direct.find(exchange);
+        return at == std::end(routes_.direct) ? routes_.fallback : at->second;
+    }
+
+    /// Post a single event to drain every Feed, unless one is still pending.
+    /** Ticks pushed before the pending event runs are picked up by it, so the
+     *  UI thread is woken once per batch rather than once per message. */
+    void notify_prices(ox::Event_queue& q)
+    {
+        if (drain_pending_.exchange(true, std::memory_order_acq_rel))
+            return;
+        q.append(ox::Custom_event{[this] { this->drain_prices(); }});
+    }
+
+    /// Emit price_update, trades_update and depth_update for every Feed.
+    /** price_update is emitted once with the whole batch, which holds the
+     *  newest Price of each Asset and the range of its trades, see
+     *  Feed::drain(). */
+    void drain_prices()
+    {
+        // Cleared first, Ticks pushed during the drain post a new event.
+        drain_pending_.store(false, std::memory_order_release);
+        drained_.clear();
+        drained_depth_.clear();
+        drained_trades_.clear();
+        detail::for_each(feeds_, [this](auto& feed) {
+            feed.drain(drained_, drained_trades_, latency_);
+            feed.drain_depth(drained_depth_);
+        });
+        if (!drained_.empty())
+            this->price_update(drained_);
+        for (auto const& [asset, summary] : drained_trades_)
+            this->trades_update(asset, summary);
+        for (auto const& [asset, depth] : drained_depth_)
+            this->depth_update(asset, depth);
+    }
+
+    /// Call \p f with the Feed of \p asset if it streams depth, and wake it.
+    template <typename F>
+    void visit_depth(Asset const& asset, F&& f)
+    {
+        auto const i = this->route(asset.exchange);
+        detail::visit_at(feeds_, i, [&](auto& feed) {
+            using Feed_t = std::decay_t<decltype(feed)>;
+            if constexpr (Feed_t::has_depth)
+                f(feed);
             else {
-                try {
-                    auto const prices = market.stream_read();
-                    q.append(ox::Custom_event{[this, prices] {
-                        auto const lock = std::lock_guard{price_update_mtx_};
-                        if constexpr (std::is_same_v<decltype(prices),
-                                                     const Price>)
-                            this->price_update(prices);
-                        else {
-                            for (auto const& p : prices)
-                                this->price_update(p);
-                        }
-                    }});
-                }
-                catch (std::exception const&) {
-                    loop.exit(1);
-                }
+                log_error(std::string{"No order book depth from "} +
+                          feed.name() + " for " + asset.currency.base);
             }
-        };
+        });
+        this->reactor_of(i).wake();
+    }
+
+    /// Launch the network threads, each servicing its share of the Feeds.
+    /** Each wakes on socket readiness, on a wake() of its Reactor from
+     *  subscribe and unsubscribe, or every 100ms so reconnects and stall
+     *  checks run. */
+    void launch_net_loop()
+    {
+        for (auto t = std::size_t{0}; t < net_threads_; ++t) {
+            if (net_loops_[t].is_running())
+                continue;
+            net_loops_[t].run_async([this, t, entered = false](
+                                        ox::Event_queue& q) mutable {
+                if (!entered) {
+                    enter_thread_role(Thread_role::Network,
+                                      "crab-net-" + std::to_string(t));
+                    entered = true;
+                }
+                this->service_feeds(t, q);
+            });
+        }
+    }
+
+    /// Handle one wakeup of network thread \p t.
+    void service_feeds(std::size_t t, ox::Event_queue& q)
+    {
+        auto& reactor = *reactors_[t];
+        auto pushed   = false;
+        for (Readiness const& r :
+             reactor.wait(std::chrono::milliseconds{100})) {
+            this->for_each_feed_on(t, [&](auto& feed) {
+                if (feed.fd() == r.fd)
+                    pushed = feed.ready(r, reactor) || pushed;
+            });
+        }
+        this->for_each_feed_on(t,
+                               [&reactor](auto& feed) { feed.poll(reactor); });
+        if (pushed)
+            this->notify_prices(q);
     }
 
-    void launch_finnhub()
+    /// Call \p f with each Feed served by network thread \p t.
+    template <typename F>
+    void for_each_feed_on(std::size_t t, F&& f)
     {
-        if (finnhub_loop_.is_running())
+        for (auto i = t; i < feed_count; i += net_threads_)
+            detail::visit_at(feeds_, i, f);
+    }
+
+    /// Run \p search and post its results to the UI thread in chunks.
+    /** Abandoned if a newer search is requested before the response arrives.
+     *  Each chunk is its own event so input is handled between them. */
+    void serve_search(Search_request const& search, ox::Event_queue& q)
+    {
+        auto const generation = search.generation;
+        auto const is_stale   = [this, generation] {
+            return search_generation_.load(std::memory_order_relaxed) !=
+                   generation;
+        };
+        if (is_stale())
             return;
-        finnhub_loop_.run_async(
-            this->generate_loop_fn(finnhub_, finnhub_to_subscribe_to_,
-                                   finnhub_to_unsubscribe_to_, finnhub_loop_));
+        auto const results = finnhub_.search(search.query, is_stale);
+        if (is_stale())
+            return;
+        auto at = std::begin(results);
+        do {
+            auto const end =
+                std::next(at, std::min<std::ptrdiff_t>(
+                                  search_chunk_size, std::end(results) - at));
+            auto chunk = std::vector<Search_result>(at, end);
+            auto const last = end == std::end(results);
+            q.append(ox::Custom_event{
+                [this, generation, chunk = std::move(chunk), last] {
+                    this->deliver_search(generation, chunk, last);
+                }});
+            at = end;
+        } while (at != std::end(results));
     }
 
-    void launch_coinbase()
+    /// Emit \p chunk of results, unless \p generation is stale.
+    /** Called on the UI thread. */
+    void deliver_search(std::uint64_t generation,
+                        std::vector<Search_result> const& chunk,
+                        bool last)
     {
-        if (coinbase_loop_.is_running())
+        if (!this->is_current_search(generation))
             return;
-        coinbase_loop_.run_async(this->generate_loop_fn(
-            coinbase_, coinbase_to_subscribe_to_, coinbase_to_unsubscribe_to_,
-            coinbase_loop_));
+        if (!chunk.empty())
+            this->search_results_received.emit(chunk);
+        if (last) {
+            search_running_ = false;
+            this->search_finished.emit();
+        }
+    }
+
+    /// Return true if \p generation is that of the latest request_search().
+    [[nodiscard]] auto is_current_search(std::uint64_t generation) const
+        -> bool
+    {
+        return generation == search_generation_.load(std::memory_order_relaxed);
     }
 
-    void launch_stats_loop()
+    /// Serve stats and search requests over the one Finnhub https socket.
+    /** Requests are taken from rest_ in priority order as its budget allows. */
+    void launch_rest_loop()
     {
-        if (stats_loop_.is_running())
+        if (rest_loop_.is_running())
             return;
-        stats_loop_.run_async([this](ox::Event_queue& q) {
-            {
-                // Make sure to never post events until inside Custom_event
-                auto stats_requested_copy = std::vector<Asset>{};
-                {  // Make a copy, b/c making requests here holds up the lock.
-                    auto const lock = stats_requested_.lock();
-                    for (Asset& a : stats_requested_)
-                        stats_requested_copy.push_back(std::move(a));
-                    stats_requested_.clear();
-                }
-                if (stats_requested_copy.empty())
-                    std::this_thread::sleep_for(std::chrono::milliseconds{300});
-                else {
-                    auto results = std::vector<std::pair<Asset, Stats>>{};
-                    for (Asset const& a : stats_requested_copy)
-                        results.push_back({a, this->stats(a)});
-                    q.append(ox::Custom_event{[results, this] {
-                        for (auto const& [asset, stats] : results)
-                            this->stats_received.emit(asset, stats);
+        rest_loop_.run_async([this, entered = false](
+                                 ox::Event_queue& q) mutable {
+            if (!entered) {
+                enter_thread_role(Thread_role::Rest, "crab-rest");
+                entered = true;
+            }
+            auto const request = rest_.next();
+            if (!request.has_value()) {
+                auto const max_wait = std::chrono::milliseconds{100};
+                std::this_thread::sleep_for(
+                    std::min(rest_.idle_time(), max_wait));
+                return;
+            }
+            // Make sure to never post events until inside Custom_event
+            try {
+                if (auto const* asset = std::get_if<Asset>(&*request)) {
+                    auto const stats = finnhub_.stats(*asset);
+                    q.append(ox::Custom_event{[asset = *asset, stats, this] {
+                        this->stats_received.emit(asset, stats);
                     }});
                 }
+                else
+                    this->serve_search(std::get<1>(*request), q);
+                rest_.finished(*request);
+            }
+            catch (Rate_limited const& e) {
+                auto const pause = rest_.rate_limited(*request);
+                log_error(std::string{e.what()} + ", pausing requests for " +
+                          std::to_string(pause.count()) + "ms");
             }
         });
     }
 
-    void launch_search_loop()
+    /// Read frames from the daemon and emit them on the UI thread.
+    void launch_daemon_loop()
     {
-        if (search_loop_.is_running())
-            return;
-        search_loop_.run_async([this](ox::Event_queue& q) {
-            auto last_request = std::string{};  // Only search the last request.
-            {  // Make a copy, b/c making requests here holds up the lock.
-                auto const lock = search_requested_.lock();
-                if (!search_requested_.empty())
-                    last_request = search_requested_.back();
-                search_requested_.clear();
-            }
-            if (last_request.empty())
-                std::this_thread::sleep_for(std::chrono::milliseconds{300});
-            else {
-                auto results = this->search(last_request);
-                q.append(ox::Custom_event{[results, this] {
-                    this->search_results_received.emit(results);
+        daemon_loop_.run_async([this, frames = std::vector<std::string>{}](
+                                   ox::Event_queue& q) mutable {
+            auto const connected =
+                daemon_->receive(frames, std::chrono::milliseconds{100});
+            if (!frames.empty()) {
+                q.append(ox::Custom_event{[this, frames = std::move(frames)] {
+                    this->dispatch_daemon(frames);
                 }});
+                frames.clear();
+            }
+            if (!connected) {
+                q.append(ox::Custom_event{[this] { this->daemon_lost(); }});
+                daemon_loop_.exit(0);
             }
         });
     }
 
-    [[nodiscard]] auto stats(Asset const& asset) -> Stats
+    /// Emit the signal for each frame from the daemon, on the UI thread.
+    /** Consecutive Price frames are emitted as one batch, in order with the
+     *  other frames. */
+    void dispatch_daemon(std::vector<std::string> const& frames)
     {
-        auto const lock = std::lock_guard{https_socket_mtx_};
-        return finnhub_.stats(asset);
+        drained_.clear();
+        auto const flush_prices = [this] {
+            if (!drained_.empty())
+                this->price_update.emit(drained_);
+            drained_.clear();
+        };
+        for (auto const& frame : frames) {
+            try {
+                auto r = Frame_reader{frame};
+                if (r.kind() != Frame_kind::Price)
+                    flush_prices();
+                switch (r.kind()) {
+                    case Frame_kind::Price: {
+                        auto price     = read_price(r);
+                        price.received = Latency_monitor::now();
+                        latency_.record(price);
+                        drained_.push_back(std::move(price));
+                    } break;
+                    case Frame_kind::Stats: {
+                        auto const [asset, stats] = read_stats(r);
+                        this->stats_received.emit(asset, stats);
+                    } break;
+                    case Frame_kind::Trades: {
+                        auto const [asset, summary] = read_trades(r);
+                        this->trades_update.emit(asset, summary);
+                    } break;
+                    case Frame_kind::Depth: {
+                        auto const [asset, depth] = read_depth(r);
+                        this->depth_update.emit(asset, depth);
+                    } break;
+                    case Frame_kind::Search_results:
+                        if (this->is_current_search(r.u64())) {
+                            this->search_results_received.emit(
+                                read_search_results(r));
+                        }
+                        break;
+                    case Frame_kind::Search_finished:
+                        if (this->is_current_search(r.u64())) {
+                            search_running_ = false;
+                            this->search_finished.emit();
+                        }
+                        break;
+                    default: break;
+                }
+            }
+            catch (Crab_error const& e) {
+                log_error(std::string{"Daemon: "} + e.what());
+            }
+        }
+        flush_prices();
     }
 
-    [[nodiscard]] auto search(std::string const& query)
-        -> std::vector<Search_result>
+    /// Open direct connections for everything that was served remotely.
+    /** Called on the UI thread once the daemon has gone away. */
+    void daemon_lost()
     {
-        auto const lock = std::lock_guard{https_socket_mtx_};
-        return finnhub_.search(query);
+        log_error("Daemon: connection lost, connecting directly");
+        remote_         = false;
+        search_running_ = false;
+        this->launch_streams();
+        auto const& subscribed = remote_subscriptions_;
+        auto const batch =
+            std::vector<Asset>(std::cbegin(subscribed), std::cend(subscribed));
+        if (!batch.empty()) {
+            this->subscribe(batch);
+            this->request_stats(batch, Rest_lane::Background);
+        }
+        for (auto const& asset : remote_depth_)
+            this->subscribe_depth(asset);
+        remote_subscriptions_.clear();
+        remote_depth_.clear();
     }
 };
 
@@ -0,0 +1,144 @@
+#include "order_book.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace {
+
+/// Return the index of the first level of \p prices not before \p price.
+template <typename Compare>
+[[nodiscard]] auto find_level(std::vector<double> const& prices,
+                              double price,
+                              Compare before) -> std::size_t
+{
+    auto const at = std::lower_bound(std::begin(prices), std::end(prices),
+                                     price, before);
+    return static_cast<std::size_t>(std::distance(std::begin(prices), at));
+}
+
+template <typename Ladder_t, typename Compare>
+void set_level(Ladder_t& ladder, double price, double size, Compare before)
+{
+    auto& prices    = ladder.prices;
+    auto& sizes     = ladder.sizes;
+    auto const i    = find_level(prices, price, before);
+    auto const here = i != prices.size() && prices[i] == price;
+    auto const at   = static_cast<std::ptrdiff_t>(i);
+    if (size == 0.) {
+        if (here) {
+            prices.erase(std::next(std::begin(prices), at));
+            sizes.erase(std::next(std::begin(sizes), at));
+        }
+    }
+    else if (here)
+        sizes[i] = size;
+    else {
+        prices.insert(std::next(std::begin(prices), at), price);
+        sizes.insert(std::next(std::begin(sizes), at), size);
+    }
+}
+
+template <typename Ladder_t, typename Compare>
+void assign_levels(Ladder_t& ladder,
+                   std::vector<crab::Book_level> levels,
+                   Compare before)
+{
+    levels.erase(std::remove_if(std::begin(levels), std::end(levels),
+                                [](auto const& l) { return l.size == 0.; }),
+                 std::end(levels));
+    std::sort(std::begin(levels), std::end(levels),
+              [before](auto const& a, auto const& b) {
+                  return before(a.price, b.price);
+              });
+    ladder.prices.clear();
+    ladder.sizes.clear();
+    ladder.prices.reserve(levels.size());
+    ladder.sizes.reserve(levels.size());
+    for (auto const& l : levels) {
+        if (!ladder.prices.empty() && ladder.prices.back() == l.price)
+            ladder.sizes.back() = l.size;  // Duplicate, last one wins.
+        else {
+            ladder.prices.push_back(l.price);
+            ladder.sizes.push_back(l.size);
+        }
+    }
+}
+
+template <typename Ladder_t>
+[[nodiscard]] auto best(Ladder_t const& ladder)
+    -> std::optional<crab::Book_level>
+{
+    if (ladder.prices.empty())
+        return std::nullopt;
+    return crab::Book_level{ladder.prices.back(), ladder.sizes.back()};
+}
+
+/// Copy up to \p out.size() levels from the back of \p ladder, best first.
+template <typename Ladder_t, typename Array_t>
+[[nodiscard]] auto copy_top(Ladder_t const& ladder, Array_t& out)
+    -> std::size_t
+{
+    auto const count = std::min(out.size(), ladder.prices.size());
+    auto const last  = ladder.prices.size() - 1;
+    for (auto i = std::size_t{0}; i < count; ++i)
+        out[i] = {ladder.prices[last - i], ladder.sizes[last - i]};
+    return count;
+}
+
+}  // namespace
+
+namespace crab {
+
+void Order_book::assign(Side side, std::vector<Book_level> levels)
+{
+    if (side == Side::Bid)
+        assign_levels(bids_, std::move(levels), std::less<double>{});
+    else
+        assign_levels(asks_, std::move(levels), std::greater<double>{});
+}
+
+void Order_book::set(Side side, double price, double size)
+{
+    if (side == Side::Bid)
+        set_level(bids_, price, size, std::less<double>{});
+    else
+        set_level(asks_, price, size, std::greater<double>{});
+}
+
+void Order_book::clear()
+{
+    for (auto* ladder : {&bids_, &asks_}) {
+        ladder->prices.clear();
+        ladder->sizes.clear();
+    }
+}
+
+auto Order_book::best_bid() const -> std::optional<Book_level>
+{
+    return best(bids_);
+}
+
+auto Order_book::best_ask() const -> std::optional<Book_level>
+{
+    return best(asks_);
+}
+
+auto Order_book::level_count(Side side) const -> std::size_t
+{
+    return side == Side::Bid ? bids_.prices.size() : asks_.prices.size();
+}
+
+auto Order_book::depth() const -> Depth
+{
+    auto result      = Depth{};
+    result.bid_count = copy_top(bids_, result.bids);
+    result.ask_count = copy_top(asks_, result.asks);
+    return result;
+}
+
+}  // namespace crab
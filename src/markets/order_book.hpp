@@ -0,0 +1,77 @@
+#ifndef CRAB_MARKETS_ORDER_BOOK_HPP
+#define CRAB_MARKETS_ORDER_BOOK_HPP
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+namespace crab {
+
+/// Total size resting at a single price.
+struct Book_level {
+    double price;
+    double size;
+};
+
+/// The best levels of an Order_book, a fixed size copy for display.
+struct Depth {
+    static auto constexpr max_levels = std::size_t{10};
+
+    std::array<Book_level, max_levels> bids;  // Highest price first.
+    std::array<Book_level, max_levels> asks;  // Lowest price first.
+    std::size_t bid_count = 0;
+    std::size_t ask_count = 0;
+
+    /// Return best ask - best bid, std::nullopt if either side is empty.
+    [[nodiscard]] auto spread() const -> std::optional<double>
+    {
+        if (bid_count == 0 || ask_count == 0)
+            return std::nullopt;
+        return asks[0].price - bids[0].price;
+    }
+};
+
+/// Level 2 order book of a single product.
+/** Each side is a flat ladder of two parallel vectors, prices and sizes,
+ *  sorted so the best level is at the back. Lookups binary search a
+ *  contiguous array of prices, and since most updates land near the top of
+ *  the book an insert or erase only shifts the few levels above it. There
+ *  are no per level allocations. Not thread safe. */
+class Order_book {
+   public:
+    enum class Side { Bid, Ask };
+
+   public:
+    /// Replace every level of \p side with \p levels, given in any order.
+    /** Used for snapshots, sorts once rather than inserting level by level.
+     *  Levels with a zero size are left out. */
+    void assign(Side side, std::vector<Book_level> levels);
+
+    /// Set the size at \p price on \p side, removing the level if zero.
+    void set(Side side, double price, double size);
+
+    void clear();
+
+   public:
+    [[nodiscard]] auto best_bid() const -> std::optional<Book_level>;
+
+    [[nodiscard]] auto best_ask() const -> std::optional<Book_level>;
+
+    /// Return the number of price levels on \p side.
+    [[nodiscard]] auto level_count(Side side) const -> std::size_t;
+
+    /// Copy the best Depth::max_levels levels of each side.
+    [[nodiscard]] auto depth() const -> Depth;
+
+   private:
+    struct Ladder {
+        std::vector<double> prices;
+        std::vector<double> sizes;
+    };
+
+    Ladder bids_;  // Ascending price, best at the back.
+    Ladder asks_;  // Descending price, best at the back.
+};
+
+}  // namespace crab
+#endif  // CRAB_MARKETS_ORDER_BOOK_HPP
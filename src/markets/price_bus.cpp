@@ -0,0 +1,231 @@
+#include "price_bus.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "../asset.hpp"
+#include "error.hpp"
+
+namespace {
+
+[[nodiscard]] auto errno_message(std::string const& what) -> std::string
+{
+    return "Price bus: " + what + ": " + std::strerror(errno);
+}
+
+[[nodiscard]] auto region_size(std::size_t slot_count) -> std::size_t
+{
+    return sizeof(crab::Bus_header) + slot_count * sizeof(crab::Bus_slot);
+}
+
+/// Return true if the region \p name is a price bus whose publisher exited.
+/** A region with another layout, or one still being created, is not
+ *  stale. A publisher of 0 is from a build that did not record it, and
+ *  could only have been left behind by a crash. */
+[[nodiscard]] auto is_stale(std::string const& name) -> bool
+{
+    auto const fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd == -1)
+        return errno == ENOENT;
+    struct stat st = {};
+    if (::fstat(fd, &st) == -1 ||
+        static_cast<std::size_t>(st.st_size) < sizeof(crab::Bus_header)) {
+        ::close(fd);
+        return false;
+    }
+    auto* const region = ::mmap(nullptr, sizeof(crab::Bus_header), PROT_READ,
+                                MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (region == MAP_FAILED)
+        return false;
+    auto const& header = *static_cast<crab::Bus_header const*>(region);
+    auto const ours =
+        std::string_view{header.magic, sizeof(header.magic) - 1} ==
+            crab::Bus_header::magic_text &&
+        header.version == crab::Bus_header::current_version;
+    auto const pid = static_cast<::pid_t>(header.publisher);
+    ::munmap(region, sizeof(crab::Bus_header));
+    if (!ours)
+        return false;
+    return pid == 0 || (::kill(pid, 0) == -1 && errno == ESRCH);
+}
+
+/// Copy \p x into \p out, cut off to leave at least one nul, nul padded.
+template <std::size_t N>
+void copy_field(char (&out)[N], std::string_view x)
+{
+    auto const n = std::min(x.size(), N - 1);
+    std::memcpy(out, x.data(), n);
+    std::memset(out + n, '\0', N - n);
+}
+
+}  // namespace
+
+namespace crab {
+
+Price_bus::Price_bus(std::string name, std::size_t slot_count)
+    : name_{std::move(name)},
+      size_{region_size(slot_count)},
+      mask_{slot_count - 1}
+{
+    if (slot_count == 0 || (slot_count & (slot_count - 1)) != 0)
+        throw Crab_error{"Price bus: slot count must be a power of two."};
+
+    auto fd = ::shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd == -1 && errno == EEXIST) {
+        // Left behind by a crash, readers of it would never see new ticks.
+        if (!is_stale(name_)) {
+            throw Crab_error{"Price bus: " + name_ +
+                             " is in use by another publisher."};
+        }
+        ::shm_unlink(name_.c_str());
+        fd = ::shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    }
+    if (fd == -1)
+        throw Crab_error{errno_message("shm_open " + name_)};
+    if (::ftruncate(fd, static_cast<off_t>(size_)) == -1) {
+        auto const message = errno_message("ftruncate " + name_);
+        ::close(fd);
+        ::shm_unlink(name_.c_str());
+        throw Crab_error{message};
+    }
+    auto* const region =
+        ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (region == MAP_FAILED) {
+        auto const message = errno_message("mmap " + name_);
+        ::shm_unlink(name_.c_str());
+        throw Crab_error{message};
+    }
+
+    // The region starts zeroed, so every slot's sequence is 0, not a tick.
+    // The magic is written last, until then is_stale() leaves it alone.
+    header_ = new (region) Bus_header{};
+    slots_  = reinterpret_cast<Bus_slot*>(static_cast<char*>(region) +
+                                         sizeof(Bus_header));
+    header_->version    = Bus_header::current_version;
+    header_->slot_size  = sizeof(Bus_slot);
+    header_->slot_count = slot_count;
+    header_->publisher  = static_cast<std::int32_t>(::getpid());
+    header_->head.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    copy_field(header_->magic, Bus_header::magic_text);
+}
+
+Price_bus::~Price_bus()
+{
+    ::munmap(header_, size_);
+    ::shm_unlink(name_.c_str());
+}
+
+void Price_bus::publish(Asset const& asset,
+                        std::string_view text,
+                        double price,
+                        double volume,
+                        std::int64_t time)
+{
+    auto tick   = Bus_tick{};
+    tick.time   = time;
+    tick.price  = price;
+    tick.volume = volume;
+    copy_field(tick.exchange, asset.exchange);
+    copy_field(tick.base, asset.currency.base);
+    copy_field(tick.quote, asset.currency.quote);
+    copy_field(tick.text, text);
+    std::uint64_t words[Bus_slot::payload_words];
+    std::memcpy(words, &tick, sizeof(tick));
+
+    auto const n = header_->head.fetch_add(1, std::memory_order_relaxed);
+    auto& slot   = slots_[n & mask_];
+    slot.sequence.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (auto i = std::size_t{0}; i < Bus_slot::payload_words; ++i)
+        slot.payload[i].store(words[i], std::memory_order_relaxed);
+    slot.sequence.store(2 * n + 2, std::memory_order_release);
+}
+
+Price_bus_reader::Price_bus_reader(std::string const& name)
+{
+    auto const fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd == -1)
+        throw Crab_error{errno_message("shm_open " + name)};
+    struct stat st = {};
+    if (::fstat(fd, &st) == -1 ||
+        static_cast<std::size_t>(st.st_size) < sizeof(Bus_header)) {
+        ::close(fd);
+        throw Crab_error{"Price bus: " + name + " is not a price bus."};
+    }
+    size_              = static_cast<std::size_t>(st.st_size);
+    auto* const region = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (region == MAP_FAILED)
+        throw Crab_error{errno_message("mmap " + name)};
+
+    header_ = static_cast<Bus_header const*>(region);
+    slots_  = reinterpret_cast<Bus_slot const*>(
+        static_cast<char const*>(region) + sizeof(Bus_header));
+    auto const count = header_->slot_count;
+    if (std::string_view{header_->magic} != Bus_header::magic_text ||
+        header_->version != Bus_header::current_version ||
+        header_->slot_size != sizeof(Bus_slot) || count == 0 ||
+        (count & (count - 1)) != 0 || size_ < region_size(count)) {
+        ::munmap(region, size_);
+        throw Crab_error{"Price bus: " + name + " has an unknown layout."};
+    }
+    mask_   = count - 1;
+    cursor_ = header_->head.load(std::memory_order_acquire);
+}
+
+Price_bus_reader::~Price_bus_reader()
+{
+    ::munmap(const_cast<Bus_header*>(header_), size_);
+}
+
+auto Price_bus_reader::next(Bus_tick& out) -> bool
+{
+    auto const count = mask_ + 1;
+    while (true) {
+        auto const head = header_->head.load(std::memory_order_acquire);
+        if (cursor_ == head)
+            return false;
+        if (head - cursor_ > count) {
+            lost_ += head - cursor_ - count;
+            cursor_ = head - count;
+        }
+        auto const& slot    = slots_[cursor_ & mask_];
+        auto const expected = 2 * cursor_ + 2;
+        auto const before   = slot.sequence.load(std::memory_order_acquire);
+        if (before < expected)
+            return false;  // Claimed but not yet written.
+        if (before == expected) {
+            std::uint64_t words[Bus_slot::payload_words];
+            for (auto i = std::size_t{0}; i < Bus_slot::payload_words; ++i)
+                words[i] = slot.payload[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == expected) {
+                std::memcpy(&out, words, sizeof(out));
+                ++cursor_;
+                return true;
+            }
+        }
+        ++lost_;  // Overwritten by a newer tick.
+        ++cursor_;
+    }
+}
+
+}  // namespace crab
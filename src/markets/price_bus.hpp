@@ -0,0 +1,135 @@
+#ifndef CRAB_MARKETS_PRICE_BUS_HPP
+#define CRAB_MARKETS_PRICE_BUS_HPP
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "../asset.hpp"
+
+namespace crab {
+
+// Shared memory layout, version 1. See docs/price_bus.md before changing it,
+// readers in other processes depend on every offset.
+
+/// First 128 bytes of the region, followed by slot_count Bus_slots.
+struct Bus_header {
+    static auto constexpr magic_text      = std::string_view{"CRABBUS"};
+    static auto constexpr current_version = std::uint32_t{1};
+
+    char magic[8];             // "CRABBUS\0"
+    std::uint32_t version;     // current_version.
+    std::uint32_t slot_size;   // sizeof(Bus_slot).
+    std::uint64_t slot_count;  // A power of two.
+    std::int32_t publisher;    // Process id of the Price_bus, 0 if unknown.
+
+    // Number of ticks ever claimed, tick n lives in slot n % slot_count.
+    alignas(64) std::atomic<std::uint64_t> head;
+};
+
+/// The fields of one tick, as published and as read by a Price_bus_reader.
+/** Text fields are nul padded and cut off to fit. */
+struct Bus_tick {
+    std::int64_t time;  // Of the trade, ms since epoch.
+    double price;
+    double volume;      // 0 if the market does not report it.
+    char exchange[16];  // Empty for stocks.
+    char base[16];
+    char quote[16];
+    char text[32];      // Price as received.
+};
+
+/// One published tick, guarded by its own sequence number.
+/** sequence is 2n + 1 while tick n is being written and 2n + 2 once it is
+ *  complete. payload holds the bytes of a Bus_tick. It is written and read
+ *  a word at a time with relaxed atomics, so a reader racing a writer gets a
+ *  torn copy that the sequence check throws away, rather than a data race.
+ */
+struct alignas(64) Bus_slot {
+    static auto constexpr payload_words =
+        sizeof(Bus_tick) / sizeof(std::uint64_t);
+
+    std::atomic<std::uint64_t> sequence;
+    std::atomic<std::uint64_t> payload[payload_words];
+};
+
+static_assert(sizeof(Bus_header) == 128);
+static_assert(sizeof(Bus_tick) == 104);
+static_assert(sizeof(Bus_slot) == 128);
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "Price bus: atomics in shared memory must be lock free.");
+
+/// Publishes normalized ticks into a POSIX shared memory ring.
+/** Any number of processes on the host can read the ring with a
+ *  Price_bus_reader, without syscalls and without the publisher waiting on
+ *  them. A reader that falls a whole ring behind loses the ticks overwritten
+ *  and is told so. Many threads may publish at once. */
+class Price_bus {
+   public:
+    static auto constexpr default_name       = "/crabwise-prices";
+    static auto constexpr default_slot_count = std::size_t{65'536};
+
+   public:
+    /// Create the region \p name with \p slot_count slots, a power of two.
+    /** A region left behind with the same name is replaced only if the
+     *  process that published to it has exited. Throws Crab_error if the
+     *  region can't be created, or if another publisher still owns it. */
+    Price_bus(std::string name, std::size_t slot_count);
+
+    Price_bus(Price_bus const&) = delete;
+    Price_bus& operator=(Price_bus const&) = delete;
+
+    /// Unmap and remove the region, attached readers keep their mapping.
+    ~Price_bus();
+
+   public:
+    /// Write one tick to the next slot. Wait free, never allocates.
+    void publish(Asset const& asset,
+                 std::string_view text,
+                 double price,
+                 double volume,
+                 std::int64_t time);
+
+    [[nodiscard]] auto name() const -> std::string const& { return name_; }
+
+   private:
+    std::string name_;
+    std::size_t size_;
+    std::uint64_t mask_;
+    Bus_header* header_;
+    Bus_slot* slots_;
+};
+
+/// Reads ticks from a Price_bus, possibly in another process.
+/** Starts at the newest tick, each reader keeps its own position. */
+class Price_bus_reader {
+   public:
+    /// Attach read only to the region \p name.
+    /** Throws Crab_error if it does not exist or has a different layout. */
+    explicit Price_bus_reader(
+        std::string const& name = Price_bus::default_name);
+
+    Price_bus_reader(Price_bus_reader const&) = delete;
+    Price_bus_reader& operator=(Price_bus_reader const&) = delete;
+
+    ~Price_bus_reader();
+
+   public:
+    /// Copy the next tick into \p out, returns false if none is ready.
+    auto next(Bus_tick& out) -> bool;
+
+    /// Return the number of ticks overwritten before they could be read.
+    [[nodiscard]] auto lost() const -> std::uint64_t { return lost_; }
+
+   private:
+    std::size_t size_;
+    std::uint64_t mask_;
+    Bus_header const* header_;
+    Bus_slot const* slots_;
+    std::uint64_t cursor_;
+    std::uint64_t lost_ = 0;
+};
+
+}  // namespace crab
+#endif  // CRAB_MARKETS_PRICE_BUS_HPP
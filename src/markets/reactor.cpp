@@ -0,0 +1,203 @@
+#include "reactor.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#    include <sys/epoll.h>
+#    include <sys/eventfd.h>
+#else
+#    include <poll.h>
+#endif
+
+#include "error.hpp"
+
+namespace {
+
+[[nodiscard]] auto errno_message(std::string const& what) -> std::string
+{
+    return "Reactor: " + what + ": " + std::strerror(errno);
+}
+
+#if defined(__linux__)
+[[nodiscard]] auto to_events(bool want_write) -> std::uint32_t
+{
+    return EPOLLIN | (want_write ? EPOLLOUT : 0u);
+}
+#endif
+
+}  // namespace
+
+namespace crab {
+
+#if defined(__linux__)
+
+Reactor::Reactor()
+{
+    epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ == -1)
+        throw Crab_error{errno_message("epoll_create1")};
+    wake_read_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_read_fd_ == -1) {
+        ::close(epoll_fd_);
+        throw Crab_error{errno_message("eventfd")};
+    }
+    wake_write_fd_ = wake_read_fd_;
+    this->add(wake_read_fd_, false);
+}
+
+Reactor::~Reactor()
+{
+    ::close(wake_read_fd_);
+    ::close(epoll_fd_);
+}
+
+void Reactor::add(int fd, bool want_write)
+{
+    auto ev    = ::epoll_event{};
+    ev.events  = to_events(want_write);
+    ev.data.fd = fd;
+    if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) == -1)
+        throw Crab_error{errno_message("epoll_ctl add")};
+}
+
+void Reactor::modify(int fd, bool want_write)
+{
+    auto ev    = ::epoll_event{};
+    ev.events  = to_events(want_write);
+    ev.data.fd = fd;
+    if (::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) == -1)
+        throw Crab_error{errno_message("epoll_ctl mod")};
+}
+
+void Reactor::remove(int fd)
+{
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+void Reactor::wake()
+{
+    auto const one                = std::uint64_t{1};
+    [[maybe_unused]] auto const n = ::write(wake_write_fd_, &one, sizeof(one));
+}
+
+auto Reactor::wait(Duration_t timeout) -> std::vector<Readiness> const&
+{
+    auto constexpr max_events = 32;
+    ::epoll_event events[max_events];
+    ready_.clear();
+    auto const count = ::epoll_wait(epoll_fd_, events, max_events,
+                                    static_cast<int>(timeout.count()));
+    if (count == -1) {
+        if (errno == EINTR)
+            return ready_;
+        throw Crab_error{errno_message("epoll_wait")};
+    }
+    for (auto i = 0; i < count; ++i) {
+        auto const& ev = events[i];
+        if (ev.data.fd == wake_read_fd_) {
+            this->drain_wake();
+            continue;
+        }
+        auto const failed = (ev.events & (EPOLLERR | EPOLLHUP)) != 0;
+        ready_.push_back({ev.data.fd, failed || (ev.events & EPOLLIN) != 0,
+                          failed || (ev.events & EPOLLOUT) != 0});
+    }
+    return ready_;
+}
+
+#else
+
+Reactor::Reactor()
+{
+    int fds[2];
+    if (::pipe(fds) == -1)
+        throw Crab_error{errno_message("pipe")};
+    for (int fd : fds) {
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    wake_read_fd_  = fds[0];
+    wake_write_fd_ = fds[1];
+    this->add(wake_read_fd_, false);
+}
+
+Reactor::~Reactor()
+{
+    ::close(wake_read_fd_);
+    ::close(wake_write_fd_);
+}
+
+void Reactor::add(int fd, bool want_write)
+{
+    interests_.push_back({fd, want_write});
+}
+
+void Reactor::modify(int fd, bool want_write)
+{
+    for (auto& interest : interests_) {
+        if (interest.fd == fd)
+            interest.want_write = want_write;
+    }
+}
+
+void Reactor::remove(int fd)
+{
+    interests_.erase(
+        std::remove_if(std::begin(interests_), std::end(interests_),
+                       [fd](Interest const& x) { return x.fd == fd; }),
+        std::end(interests_));
+}
+
+void Reactor::wake()
+{
+    auto const one                = char{1};
+    [[maybe_unused]] auto const n = ::write(wake_write_fd_, &one, 1);
+}
+
+auto Reactor::wait(Duration_t timeout) -> std::vector<Readiness> const&
+{
+    auto fds = std::vector<::pollfd>{};
+    fds.reserve(interests_.size());
+    for (auto const& interest : interests_) {
+        auto const events = POLLIN | (interest.want_write ? POLLOUT : 0);
+        fds.push_back({interest.fd, static_cast<short>(events), 0});
+    }
+    ready_.clear();
+    auto const count =
+        ::poll(fds.data(), fds.size(), static_cast<int>(timeout.count()));
+    if (count == -1) {
+        if (errno == EINTR)
+            return ready_;
+        throw Crab_error{errno_message("poll")};
+    }
+    for (auto const& pfd : fds) {
+        if (pfd.revents == 0)
+            continue;
+        if (pfd.fd == wake_read_fd_) {
+            this->drain_wake();
+            continue;
+        }
+        auto const failed = (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) != 0;
+        ready_.push_back({pfd.fd, failed || (pfd.revents & POLLIN) != 0,
+                          failed || (pfd.revents & POLLOUT) != 0});
+    }
+    return ready_;
+}
+
+#endif
+
+void Reactor::drain_wake()
+{
+    char buffer[64];
+    while (::read(wake_read_fd_, buffer, sizeof(buffer)) > 0) {}
+}
+
+}  // namespace crab
@@ -0,0 +1,72 @@
+#ifndef CRAB_MARKETS_REACTOR_HPP
+#define CRAB_MARKETS_REACTOR_HPP
+#include <chrono>
+#include <vector>
+
+namespace crab {
+
+/// Readiness of a single file descriptor, reported by Reactor::wait().
+struct Readiness {
+    int fd;
+    bool readable;
+    bool writable;
+};
+
+/// Readiness notification for any number of non-blocking sockets.
+/** Backed by epoll on Linux and poll(2) elsewhere. All members except wake()
+ *  must be called from the thread that calls wait(). */
+class Reactor {
+   public:
+    using Duration_t = std::chrono::milliseconds;
+
+   public:
+    /// Throws Crab_error if the underlying handles can't be created.
+    Reactor();
+
+    Reactor(Reactor const&) = delete;
+    Reactor& operator=(Reactor const&) = delete;
+
+    ~Reactor();
+
+   public:
+    /// Start watching \p fd for reads, and for writes if \p want_write.
+    void add(int fd, bool want_write);
+
+    /// Change the write interest of an already added \p fd.
+    void modify(int fd, bool want_write);
+
+    /// Stop watching \p fd, does not close it.
+    void remove(int fd);
+
+    /// Interrupt a wait() in progress from any thread.
+    void wake();
+
+    /// Block for up to \p timeout or until a watched fd is ready or woken.
+    /** Returned reference is valid until the next call. Errors and hangups
+     *  are reported as readable and writable so the owner finds out on its
+     *  next read or write. */
+    [[nodiscard]] auto wait(Duration_t timeout)
+        -> std::vector<Readiness> const&;
+
+   private:
+    int wake_read_fd_  = -1;
+    int wake_write_fd_ = -1;  // Same as wake_read_fd_ for an eventfd.
+    std::vector<Readiness> ready_;
+
+#if defined(__linux__)
+    int epoll_fd_ = -1;
+#else
+    struct Interest {
+        int fd;
+        bool want_write;
+    };
+    std::vector<Interest> interests_;
+#endif
+
+   private:
+    /// Read everything written by wake() so the wake fd is quiet again.
+    void drain_wake();
+};
+
+}  // namespace crab
+#endif  // CRAB_MARKETS_REACTOR_HPP
@@ -0,0 +1,258 @@
+#ifndef CRAB_MARKETS_REST_SCHEDULER_HPP
+#define CRAB_MARKETS_REST_SCHEDULER_HPP
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <utility>
+#include <variant>
+
+#include "../asset.hpp"
+
+namespace crab {
+
+/// Queue a REST request waits in, highest priority first.
+enum class Rest_lane {
+    Search,     // Interactive, the user is waiting on it.
+    Visible,    // Stats for rows on screen.
+    Background  // Stats for hidden rows and periodic refreshes.
+};
+
+/// Search for \p query, tagged with the generation it was requested in.
+struct Search_request {
+    std::string query;
+    std::uint64_t generation;
+};
+
+/// Request budget, refilled continuously up to its capacity. Not thread safe.
+class Token_bucket {
+   public:
+    using Clock_t = std::chrono::steady_clock;
+
+   public:
+    /// Hold at most \p capacity tokens, adding \p per_minute every minute.
+    Token_bucket(double capacity, double per_minute)
+        : capacity_{capacity},
+          per_second_{per_minute / 60.},
+          tokens_{capacity},
+          last_{Clock_t::now()}
+    {}
+
+   public:
+    /// Take a token if more than \p reserve tokens would be left over.
+    auto try_take(Clock_t::time_point now, double reserve = 0.) -> bool
+    {
+        this->refill(now);
+        if (tokens_ < 1. + reserve)
+            return false;
+        tokens_ -= 1.;
+        return true;
+    }
+
+    /// Return how long until try_take with \p reserve can succeed.
+    [[nodiscard]] auto wait_time(Clock_t::time_point now, double reserve = 0.)
+        -> Clock_t::duration
+    {
+        this->refill(now);
+        auto const missing = 1. + reserve - tokens_;
+        auto const paused  = last_ > now ? last_ - now : Clock_t::duration{};
+        if (missing <= 0.)
+            return paused;
+        return paused + std::chrono::duration_cast<Clock_t::duration>(
+                            std::chrono::duration<double>{missing /
+                                                          per_second_});
+    }
+
+    /// Empty the bucket and hold off refilling until \p until.
+    void pause_until(Clock_t::time_point until)
+    {
+        tokens_ = 0.;
+        last_   = std::max(last_, until);
+    }
+
+   private:
+    double const capacity_;
+    double const per_second_;
+    double tokens_;
+    Clock_t::time_point last_;  // Time of last refill, later while paused.
+
+   private:
+    void refill(Clock_t::time_point now)
+    {
+        if (now <= last_)
+            return;
+        auto const elapsed = std::chrono::duration<double>{now - last_};
+        tokens_ = std::min(capacity_, tokens_ + elapsed.count() * per_second_);
+        last_   = now;
+    }
+};
+
+/// Orders REST requests by lane and paces them to stay within a rate limit.
+/** Stats requests are deduplicated by Asset while queued or in flight, a
+ *  repeat in a higher lane promotes the queued request. Only the newest queued
+ *  search is kept. Lower lanes leave tokens in reserve so a search never waits
+ *  on a burst of stats. A rate limited request goes back to the front of its
+ *  lane and the budget is paused with exponential backoff. Thread safe. */
+class Rest_scheduler {
+   public:
+    using Clock_t    = Token_bucket::Clock_t;
+    using Request_t  = std::variant<Asset, Search_request>;
+    using Duration_t = std::chrono::milliseconds;
+
+   public:
+    /// Defaults fit Finnhub's free tier of 60 calls a minute, a full bucket
+    /// plus one minute of refill never exceeds it.
+    explicit Rest_scheduler(Token_bucket budget = Token_bucket{10., 50.})
+        : budget_{std::move(budget)}
+    {}
+
+   public:
+    /// Queue a stats request for \p asset.
+    void request_stats(Asset const& asset, Rest_lane lane)
+    {
+        auto const lock = std::lock_guard{mtx_};
+        known_.insert(asset);
+        this->enqueue(asset, lane);
+    }
+
+    /// Queue \p search, replacing any search not yet started.
+    void request_search(Search_request search)
+    {
+        auto const lock = std::lock_guard{mtx_};
+        search_         = std::move(search);
+    }
+
+    /// Queue a stats request in \p lane for every Asset not forgotten.
+    void refresh_all(Rest_lane lane = Rest_lane::Background)
+    {
+        auto const lock = std::lock_guard{mtx_};
+        for (auto const& asset : known_)
+            this->enqueue(asset, lane);
+    }
+
+    /// Stop refreshing \p asset and drop it if still queued.
+    void forget(Asset const& asset)
+    {
+        auto const lock = std::lock_guard{mtx_};
+        known_.erase(asset);
+        auto const at = pending_.find(asset);
+        if (at == std::end(pending_) || at->second == in_flight)
+            return;
+        auto& lane = lanes_[at->second];
+        lane.erase(std::find(std::begin(lane), std::end(lane), asset));
+        pending_.erase(at);
+    }
+
+    /// Return the next request the budget allows, if any.
+    /** The request is in flight until passed to finished or rate_limited. */
+    [[nodiscard]] auto next() -> std::optional<Request_t>
+    {
+        auto const lock = std::lock_guard{mtx_};
+        auto const now  = Clock_t::now();
+        if (search_.has_value() && budget_.try_take(now)) {
+            auto search = std::move(*search_);
+            search_.reset();
+            return search;
+        }
+        for (auto i = std::size_t{1}; i < lanes_.size(); ++i) {
+            auto& lane = lanes_[i];
+            if (lane.empty())
+                continue;
+            if (!budget_.try_take(now, reserve[i]))
+                return std::nullopt;
+            auto asset = std::move(lane.front());
+            lane.pop_front();
+            pending_[asset] = in_flight;
+            return asset;
+        }
+        return std::nullopt;
+    }
+
+    /// Return how long to wait before next() may return a request.
+    [[nodiscard]] auto idle_time() -> Duration_t
+    {
+        auto const lock = std::lock_guard{mtx_};
+        auto const now  = Clock_t::now();
+        auto const ceil = [](auto d) {
+            return std::chrono::ceil<Duration_t>(d);
+        };
+        if (search_.has_value())
+            return ceil(budget_.wait_time(now));
+        for (auto i = std::size_t{1}; i < lanes_.size(); ++i) {
+            if (!lanes_[i].empty())
+                return ceil(budget_.wait_time(now, reserve[i]));
+        }
+        return Duration_t::max();
+    }
+
+    /// Mark \p request as served.
+    void finished(Request_t const& request)
+    {
+        auto const lock = std::lock_guard{mtx_};
+        backoff_        = Duration_t::zero();
+        if (auto const* asset = std::get_if<Asset>(&request))
+            pending_.erase(*asset);
+    }
+
+    /// Put \p request back at the front of its lane and pause the budget.
+    /** Returns the pause, which doubles on each rate limit in a row. */
+    auto rate_limited(Request_t const& request) -> Duration_t
+    {
+        auto const lock = std::lock_guard{mtx_};
+        backoff_        = std::clamp(backoff_ * 2, min_backoff, max_backoff);
+        budget_.pause_until(Clock_t::now() + backoff_);
+        if (auto const* asset = std::get_if<Asset>(&request)) {
+            // Back in the Visible lane, it was waited on long enough.
+            pending_[*asset] = visible;
+            lanes_[visible].push_front(*asset);
+        }
+        else if (!search_.has_value())
+            search_ = std::get<Search_request>(request);
+        return backoff_;
+    }
+
+   private:
+    static auto constexpr visible   = std::size_t{1};
+    static auto constexpr in_flight = std::size_t{3};  // Not a lane index.
+
+    // Tokens each lane must leave behind, by lane.
+    static constexpr auto reserve = std::array{0., 1., 5.};
+
+    static auto constexpr min_backoff = Duration_t{1'000};
+    static auto constexpr max_backoff = Duration_t{60'000};
+
+    std::mutex mtx_;
+    Token_bucket budget_;
+    std::array<std::deque<Asset>, 3> lanes_;  // Index 0, Search, is unused.
+    std::map<Asset, std::size_t> pending_;    // Lane index or in_flight.
+    std::set<Asset> known_;                   // Refreshed by refresh_all.
+    std::optional<Search_request> search_;
+    Duration_t backoff_ = Duration_t::zero();
+
+   private:
+    /// Queue \p asset in \p lane, or promote it if queued in a lower lane.
+    void enqueue(Asset const& asset, Rest_lane lane)
+    {
+        auto const index = std::max(static_cast<std::size_t>(lane), visible);
+        auto const at    = pending_.find(asset);
+        if (at != std::end(pending_)) {
+            if (at->second == in_flight || at->second <= index)
+                return;
+            auto& lower = lanes_[at->second];
+            lower.erase(std::find(std::begin(lower), std::end(lower), asset));
+        }
+        pending_[asset] = index;
+        lanes_[index].push_back(asset);
+    }
+};
+
+}  // namespace crab
+#endif  // CRAB_MARKETS_REST_SCHEDULER_HPP
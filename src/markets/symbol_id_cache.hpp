@@ -1,5 +1,6 @@
 #ifndef CRAB_MARKETS_SYMBOL_ID_CACHE_HPP
 #define CRAB_MARKETS_SYMBOL_ID_CACHE_HPP
+#include <iterator>
 #include <map>
 #include <string>
 #include <utility>
@@ -21,23 +22,25 @@ class Symbol_ID_cache {
 
    public:
     /// Return the Finnhub 'symbol_id' cooresponding to the given Asset.
-    [[nodiscard]] auto find_symbol_id(Asset const& asset) -> std::string
+    [[nodiscard]] auto find_symbol_id(Asset const& asset) const -> std::string
     {
         // Stocks are not in map.
-        if (get_id_map_.count(asset) == 0)
+        auto const at = get_id_map_.find(asset);
+        if (at == std::end(get_id_map_))
             return asset.currency.base;
         else
-            return get_id_map_[asset];
+            return at->second;
     }
 
     /// Return the Asset cooresponding to the given Finnhub 'symbol_id'.
-    [[nodiscard]] auto find_asset(std::string const& symbol_id) -> Asset
+    [[nodiscard]] auto find_asset(std::string const& symbol_id) const -> Asset
     {
         // Stocks are not in map.
-        if (get_asset_map_.count(symbol_id) == 0)
+        auto const at = get_asset_map_.find(symbol_id);
+        if (at == std::end(get_asset_map_))
             return {"", {symbol_id, "USD"}};
         else
-            return get_asset_map_[symbol_id];
+            return at->second;
     }
 
     /// Return whether or not the symbol_id is cached.
@@ -0,0 +1,113 @@
+#ifndef CRAB_MARKETS_TICK_RING_HPP
+#define CRAB_MARKETS_TICK_RING_HPP
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace crab {
+
+/// Fixed size trade, the Asset is referred to by a per-Feed id.
+/** Price is kept as text so no precision is lost on the way to the display,
+ *  anything past the first 27 characters is cut off. The parsed price,
+ *  volume and times are carried alongside for trade and latency statistics.
+ *  64 bytes, a single cache line.
+ */
+struct Tick {
+    static auto constexpr capacity = std::size_t{27};
+
+    std::uint32_t asset_id;
+    std::uint8_t size;
+    char value[capacity];
+    double price;
+    double volume;
+    std::int64_t time;      // Of the trade, ms since epoch, 0 if unknown.
+    std::int64_t received;  // By this process, ms since epoch.
+
+    /// Create a Tick from the \p asset_id and the price text \p value.
+    [[nodiscard]] static auto make(std::uint32_t asset_id,
+                                   std::string const& value,
+                                   double price,
+                                   double volume,
+                                   std::int64_t time,
+                                   std::int64_t received) -> Tick
+    {
+        auto result     = Tick{};
+        result.asset_id = asset_id;
+        result.size =
+            static_cast<std::uint8_t>(std::min(value.size(), capacity));
+        std::copy_n(value.data(), result.size, result.value);
+        result.price    = price;
+        result.volume   = volume;
+        result.time     = time;
+        result.received = received;
+        return result;
+    }
+
+    [[nodiscard]] auto text() const -> std::string
+    {
+        return std::string(value, size);
+    }
+
+    /// Return the time of the trade, or when it was received if unknown.
+    [[nodiscard]] auto trade_time() const -> std::int64_t
+    {
+        return time != 0 ? time : received;
+    }
+};
+
+static_assert(sizeof(Tick) == 64, "Tick: Expected to fill one cache line.");
+
+/// Lock-free single producer, single consumer ring of preallocated slots.
+/** Capacity must be a power of two. Each index is only written by one side,
+ *  and they are kept on separate cache lines so the producer and consumer
+ *  don't contend. */
+template <typename T, std::size_t Capacity>
+class Spsc_ring {
+    static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0,
+                  "Spsc_ring: Capacity must be a power of two.");
+
+   public:
+    /// Append \p value, returns false if the ring is full. Producer only.
+    auto push(T const& value) -> bool
+    {
+        auto const head = head_.load(std::memory_order_relaxed);
+        if (head - tail_cache_ == Capacity) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head - tail_cache_ == Capacity)
+                return false;
+        }
+        slots_[head & mask] = value;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Move every available element to the end of \p out. Consumer only.
+    /** Returns the number of elements appended. */
+    auto pop_all(std::vector<T>& out) -> std::size_t
+    {
+        auto const tail = tail_.load(std::memory_order_relaxed);
+        auto const head = head_.load(std::memory_order_acquire);
+        for (auto i = tail; i != head; ++i)
+            out.push_back(slots_[i & mask]);
+        tail_.store(head, std::memory_order_release);
+        return static_cast<std::size_t>(head - tail);
+    }
+
+   private:
+    static auto constexpr mask = Capacity - 1;
+    static auto constexpr cache_line = std::size_t{64};
+
+    alignas(cache_line) std::atomic<std::uint64_t> head_{0};
+    std::uint64_t tail_cache_ = 0;  // Producer's last view of tail_.
+
+    alignas(cache_line) std::atomic<std::uint64_t> tail_{0};
+
+    alignas(cache_line) std::array<T, Capacity> slots_;
+};
+
+}  // namespace crab
+#endif  // CRAB_MARKETS_TICK_RING_HPP
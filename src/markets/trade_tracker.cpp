@@ -0,0 +1,104 @@
+#include "trade_tracker.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace {
+
+auto constexpr day_ms = std::int64_t{86'400'000};
+
+/// Return the length of one bucket of \p window, at least 1ms.
+[[nodiscard]] auto bucket_length(crab::Trade_tracker::Window_t window)
+    -> std::int64_t
+{
+    auto const count = static_cast<std::int64_t>(
+        crab::Trade_tracker::bucket_count);
+    return std::max(std::int64_t{1}, (window.count() + count - 1) / count);
+}
+
+}  // namespace
+
+namespace crab {
+
+Trade_tracker::Trade_tracker(Window_t window)
+    : window_{window}, bucket_ms_{bucket_length(window)}
+{}
+
+void Trade_tracker::set_window(Window_t window)
+{
+    window_    = window;
+    bucket_ms_ = bucket_length(window);
+    assets_.clear();
+}
+
+void Trade_tracker::add(std::uint32_t asset_id,
+                        double price,
+                        double volume,
+                        std::int64_t time)
+{
+    if (asset_id >= assets_.size())
+        assets_.resize(asset_id + 1);
+    auto& r = assets_[asset_id];
+
+    auto const day = time / day_ms;
+    if (day > r.session_day) {
+        r.session_day    = day;
+        r.session_volume = 0.;
+    }
+    if (day == r.session_day)
+        r.session_volume += volume;
+
+    auto const index = time / bucket_ms_;
+    auto const count = static_cast<std::int64_t>(bucket_count);
+    if (index <= r.newest - count)
+        return;  // Older than the window.
+    this->advance(r, index);
+    auto& bucket = r.buckets[static_cast<std::size_t>(index % count)];
+    bucket.volume += volume;
+    bucket.notional += price * volume;
+    ++bucket.count;
+    r.volume += volume;
+    r.notional += price * volume;
+    ++r.count;
+}
+
+auto Trade_tracker::summary(std::uint32_t asset_id) const -> Trade_summary
+{
+    if (asset_id >= assets_.size())
+        return {};
+    auto const& r = assets_[asset_id];
+    auto result   = Trade_summary{};
+    result.session_volume = r.session_volume;
+    result.window_volume  = r.volume;
+    result.vwap           = r.volume > 0. ? r.notional / r.volume : 0.;
+    result.window_trades  = r.count;
+    return result;
+}
+
+void Trade_tracker::advance(Rolling& r, std::int64_t index) const
+{
+    if (index <= r.newest)
+        return;
+    auto const count = static_cast<std::int64_t>(bucket_count);
+    auto const first = std::max(r.newest + 1, index - count + 1);
+    for (auto i = first; i <= index; ++i) {
+        auto& bucket = r.buckets[static_cast<std::size_t>(i % count)];
+        if (bucket.index != -1) {
+            r.volume -= bucket.volume;
+            r.notional -= bucket.notional;
+            r.count -= bucket.count;
+        }
+        bucket = Bucket{i};
+    }
+    if (first != r.newest + 1) {
+        // Every bucket was replaced, drop rounding error in the totals.
+        r.volume   = 0.;
+        r.notional = 0.;
+        r.count    = 0;
+    }
+    r.newest = index;
+}
+
+}  // namespace crab
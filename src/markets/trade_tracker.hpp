@@ -0,0 +1,79 @@
+#ifndef CRAB_MARKETS_TRADE_TRACKER_HPP
+#define CRAB_MARKETS_TRADE_TRACKER_HPP
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace crab {
+
+/// Volume, VWAP and trade count of one Asset, as of its latest trade.
+struct Trade_summary {
+    double session_volume       = 0.;  // Since 00:00 UTC of the latest trade.
+    double window_volume        = 0.;
+    double vwap                 = 0.;  // Over the window, 0 without volume.
+    std::uint64_t window_trades = 0;
+};
+
+/// Rolling trade statistics of every Asset of a Feed, by asset id.
+/** Each window is split into a fixed ring of buckets. A trade is added to the
+ *  bucket of its time and running totals, whole buckets are subtracted as
+ *  they expire, so adding a trade is O(1) and never allocates. Memory only
+ *  grows when a new asset id is seen. Windows are accurate to one bucket,
+ *  1/bucket_count of their length. Not thread safe. */
+class Trade_tracker {
+   public:
+    using Window_t = std::chrono::milliseconds;
+
+    static auto constexpr bucket_count = std::size_t{60};
+
+   public:
+    explicit Trade_tracker(Window_t window = std::chrono::minutes{5});
+
+   public:
+    /// Change the window length, every statistic is cleared.
+    /** \p window is rounded up to a whole number of milliseconds per bucket. */
+    void set_window(Window_t window);
+
+    [[nodiscard]] auto window() const -> Window_t { return window_; }
+
+    /// Record a trade of \p volume at \p price, \p time in ms since epoch.
+    /** Trades older than the window only count towards session volume. */
+    void add(std::uint32_t asset_id,
+             double price,
+             double volume,
+             std::int64_t time);
+
+    /// Return the statistics of \p asset_id, all zero if it has no trades.
+    [[nodiscard]] auto summary(std::uint32_t asset_id) const -> Trade_summary;
+
+   private:
+    struct Bucket {
+        std::int64_t index  = -1;  // time / bucket_ms_, -1 if unused.
+        double volume       = 0.;
+        double notional     = 0.;  // Sum of price * volume.
+        std::uint64_t count = 0;
+    };
+
+    struct Rolling {
+        std::array<Bucket, bucket_count> buckets;
+        std::int64_t newest      = -1;  // Index of the newest bucket used.
+        double volume            = 0.;
+        double notional          = 0.;
+        std::uint64_t count      = 0;
+        std::int64_t session_day = -1;  // Days since epoch, UTC.
+        double session_volume    = 0.;
+    };
+
+    Window_t window_;
+    std::int64_t bucket_ms_;
+    std::vector<Rolling> assets_;
+
+   private:
+    /// Expire the buckets of \p r older than the window ending at \p index.
+    void advance(Rolling& r, std::int64_t index) const;
+};
+
+}  // namespace crab
+#endif  // CRAB_MARKETS_TRADE_TRACKER_HPP
@@ -0,0 +1,476 @@
+#include "websocket_client.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iterator>
+#include <string>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+
+#include "error.hpp"
+
+namespace {
+
+enum Opcode : std::uint8_t {
+    Continuation = 0x0,
+    Text         = 0x1,
+    Binary       = 0x2,
+    Close        = 0x8,
+    Ping         = 0x9,
+    Pong         = 0xA
+};
+
+/// TLS context shared by every client, verifies peers with system CAs.
+[[nodiscard]] auto tls_context() -> SSL_CTX*
+{
+    static auto* const context = [] {
+        // Writes to a socket the peer closed would otherwise kill the app.
+        std::signal(SIGPIPE, SIG_IGN);
+        auto* const ctx = ::SSL_CTX_new(::TLS_client_method());
+        if (ctx == nullptr)
+            throw crab::Crab_error{"Websocket: Could not create TLS context."};
+        ::SSL_CTX_set_default_verify_paths(ctx);
+        ::SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, nullptr);
+        ::SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+        ::SSL_CTX_set_mode(ctx, SSL_MODE_ENABLE_PARTIAL_WRITE |
+                                    SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+        return ctx;
+    }();
+    return context;
+}
+
+[[nodiscard]] auto base64(unsigned char const* data, std::size_t size)
+    -> std::string
+{
+    auto result = std::string(4 * ((size + 2) / 3), '\0');
+    auto const n =
+        ::EVP_EncodeBlock(reinterpret_cast<unsigned char*>(result.data()),
+                          data, static_cast<int>(size));
+    result.resize(n);
+    return result;
+}
+
+/// The Sec-WebSocket-Accept value a server must reply with for \p key.
+[[nodiscard]] auto expected_accept(std::string const& key) -> std::string
+{
+    auto const input = key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    unsigned char digest[SHA_DIGEST_LENGTH];
+    ::SHA1(reinterpret_cast<unsigned char const*>(input.data()), input.size(),
+           digest);
+    return base64(digest, SHA_DIGEST_LENGTH);
+}
+
+[[nodiscard]] auto to_lower(std::string x) -> std::string
+{
+    for (char& c : x)
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return x;
+}
+
+/// Return the trimmed value of \p name in the HTTP \p header, or empty.
+[[nodiscard]] auto header_value(std::string const& header,
+                                std::string const& name) -> std::string
+{
+    auto const lower = to_lower(header);
+    auto const at    = lower.find("\r\n" + to_lower(name) + ':');
+    if (at == std::string::npos)
+        return {};
+    auto begin     = at + name.size() + 3;
+    auto const end = header.find("\r\n", begin);
+    while (begin < end && header[begin] == ' ')
+        ++begin;
+    return header.substr(begin, end - begin);
+}
+
+/// XOR \p x from \p from onwards with the 4 byte \p mask, if not null.
+void unmask(std::string& x, std::size_t from, unsigned char const* mask)
+{
+    if (mask == nullptr)
+        return;
+    for (auto i = std::size_t{0}; from + i < x.size(); ++i)
+        x[from + i] = static_cast<char>(x[from + i] ^ mask[i % 4]);
+}
+
+}  // namespace
+
+namespace crab {
+
+void Websocket_client::open(std::string const& host,
+                            std::string const& resource)
+{
+    this->close();
+    host_     = host;
+    resource_ = resource;
+
+    auto hints        = ::addrinfo{};
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (auto const rc = ::getaddrinfo(host.c_str(), "443", &hints, &addresses_);
+        rc != 0) {
+        addresses_ = nullptr;
+        throw Crab_error{"Websocket: Could not resolve " + host + ": " +
+                         ::gai_strerror(rc)};
+    }
+    next_      = addresses_;
+    auto error = std::string{"no addresses"};
+    if (!this->connect_next(error)) {
+        this->close();
+        throw Crab_error{"Websocket: Could not connect to " + host + ": " +
+                         error};
+    }
+    state_ = State::Connecting;
+}
+
+void Websocket_client::close()
+{
+    if (ssl_ != nullptr) {
+        ::SSL_free(ssl_);
+        ssl_ = nullptr;
+    }
+    if (fd_ != -1) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    if (addresses_ != nullptr) {
+        ::freeaddrinfo(addresses_);
+        addresses_ = nullptr;
+        next_      = nullptr;
+    }
+    state_ = State::Closed;
+    out_.clear();
+    in_.clear();
+    in_offset_ = 0;
+    fragments_.clear();
+    read_error_.clear();
+    ssl_wants_write_ = false;
+}
+
+void Websocket_client::progress(bool readable, bool writable)
+{
+    if (state_ == State::Connecting) {
+        if (!writable && !readable)
+            return;
+        this->finish_connect();
+    }
+    if (state_ == State::Tls_handshake)
+        this->tls_handshake();
+    if (state_ == State::Upgrading || state_ == State::Open) {
+        this->flush();
+        if (read_error_.empty())
+            this->fill();
+    }
+    if (state_ == State::Upgrading) {
+        this->finish_upgrade();
+        if (state_ == State::Upgrading && !read_error_.empty())
+            throw Crab_error{read_error_};
+    }
+}
+
+auto Websocket_client::next_message(std::string& message) -> bool
+{
+    while (state_ == State::Open) {
+        auto const* const data =
+            reinterpret_cast<unsigned char const*>(in_.data()) + in_offset_;
+        auto const available = in_.size() - in_offset_;
+        if (available < 2)
+            break;
+        auto const fin    = (data[0] & 0x80) != 0;
+        auto const opcode = static_cast<std::uint8_t>(data[0] & 0x0F);
+        auto const masked = (data[1] & 0x80) != 0;
+        auto length       = std::uint64_t{data[1] & 0x7Fu};
+        auto header       = std::size_t{2};
+        if (length == 126) {
+            header = 4;
+            if (available < header)
+                break;
+            length = (std::uint64_t{data[2]} << 8) | data[3];
+        }
+        else if (length == 127) {
+            header = 10;
+            if (available < header)
+                break;
+            length = 0;
+            for (auto i = 2; i < 10; ++i)
+                length = (length << 8) | data[i];
+        }
+        if (masked)
+            header += 4;
+        if (available < header || available - header < length)
+            break;
+
+        auto const* const payload =
+            reinterpret_cast<char const*>(data) + header;
+        auto const size        = static_cast<std::size_t>(length);
+        auto const* const mask = masked ? data + header - 4 : nullptr;
+        in_offset_ += header + size;
+
+        switch (opcode) {
+            case Ping: {
+                auto pong = std::string{payload, size};
+                unmask(pong, 0, mask);
+                this->queue_frame(Pong, pong.data(), pong.size());
+                continue;
+            }
+            case Pong: continue;
+            case Close:
+                throw Crab_error{"Websocket: Closed by " + host_ + '.'};
+            case Text:
+            case Binary:
+                if (fin) {
+                    message.assign(payload, size);
+                    unmask(message, 0, mask);
+                    return true;
+                }
+                fragments_.assign(payload, size);
+                unmask(fragments_, 0, mask);
+                continue;
+            case Continuation: {
+                auto const from = fragments_.size();
+                fragments_.append(payload, size);
+                unmask(fragments_, from, mask);
+                if (fin) {
+                    message.swap(fragments_);
+                    fragments_.clear();
+                    return true;
+                }
+                continue;
+            }
+            default:
+                throw Crab_error{"Websocket: Unknown opcode from " + host_};
+        }
+    }
+    if (!read_error_.empty())
+        throw Crab_error{read_error_};
+    // Compact once everything buffered has been consumed.
+    if (in_offset_ == in_.size()) {
+        in_.clear();
+        in_offset_ = 0;
+    }
+    return false;
+}
+
+void Websocket_client::send_text(std::string const& message)
+{
+    this->queue_frame(Text, message.data(), message.size());
+}
+
+auto Websocket_client::wants_write() const -> bool
+{
+    switch (state_) {
+        case State::Closed: return false;
+        case State::Connecting: return true;
+        case State::Tls_handshake: return ssl_wants_write_;
+        case State::Upgrading:
+        case State::Open: return ssl_wants_write_ || !out_.empty();
+    }
+    return false;
+}
+
+auto Websocket_client::connect_next(std::string& error) -> bool
+{
+    for (; next_ != nullptr; next_ = next_->ai_next) {
+        auto const* const a = next_;
+        auto const fd = ::socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd == -1) {
+            error = std::strerror(errno);
+            continue;
+        }
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+        auto const one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#if defined(SO_NOSIGPIPE)
+        ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+        if (::connect(fd, a->ai_addr, a->ai_addrlen) == 0 ||
+            errno == EINPROGRESS) {
+            if (fd_ != -1)
+                ::close(fd_);
+            fd_   = fd;
+            next_ = a->ai_next;
+            return true;
+        }
+        error = std::strerror(errno);
+        ::close(fd);
+    }
+    return false;
+}
+
+void Websocket_client::finish_connect()
+{
+    auto error = 0;
+    auto size  = ::socklen_t{sizeof(error)};
+    ::getsockopt(fd_, SOL_SOCKET, SO_ERROR, &error, &size);
+    if (error != 0) {
+        auto reason = std::string{std::strerror(error)};
+        if (this->connect_next(reason))
+            return;  // Still connecting, on a new fd().
+        throw Crab_error{"Websocket: Could not connect to " + host_ + ": " +
+                         reason};
+    }
+    ::freeaddrinfo(addresses_);  // Connected, no other address is needed.
+    addresses_ = nullptr;
+    next_      = nullptr;
+    ssl_ = ::SSL_new(tls_context());
+    if (ssl_ == nullptr)
+        throw Crab_error{"Websocket: Could not create TLS session."};
+    ::SSL_set_fd(ssl_, fd_);
+    ::SSL_set_tlsext_host_name(ssl_, host_.c_str());
+    ::SSL_set1_host(ssl_, host_.c_str());
+    state_ = State::Tls_handshake;
+}
+
+void Websocket_client::tls_handshake()
+{
+    auto const rc = ::SSL_connect(ssl_);
+    if (rc != 1) {
+        auto const error = ::SSL_get_error(ssl_, rc);
+        if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) {
+            ssl_wants_write_ = (error == SSL_ERROR_WANT_WRITE);
+            return;
+        }
+        this->throw_ssl_error("TLS handshake with " + host_ + " failed", rc);
+    }
+    ssl_wants_write_ = false;
+
+    unsigned char nonce[16];
+    for (auto& byte : nonce)
+        byte = static_cast<unsigned char>(rng_());
+    key_ = base64(nonce, sizeof(nonce));
+    out_ = "GET " + resource_ + " HTTP/1.1\r\nHost: " + host_ +
+           "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+           "Sec-WebSocket-Key: " +
+           key_ + "\r\nSec-WebSocket-Version: 13\r\n\r\n";
+    state_ = State::Upgrading;
+}
+
+void Websocket_client::flush()
+{
+    ssl_wants_write_ = false;
+    while (!out_.empty()) {
+        auto const rc =
+            ::SSL_write(ssl_, out_.data(), static_cast<int>(out_.size()));
+        if (rc > 0) {
+            out_.erase(0, static_cast<std::size_t>(rc));
+            continue;
+        }
+        auto const error = ::SSL_get_error(ssl_, rc);
+        if (error == SSL_ERROR_WANT_WRITE) {
+            ssl_wants_write_ = true;
+            return;
+        }
+        if (error == SSL_ERROR_WANT_READ)
+            return;
+        this->throw_ssl_error("Write to " + host_ + " failed", rc);
+    }
+}
+
+void Websocket_client::fill()
+{
+    char buffer[16'384];
+    while (true) {
+        auto const rc = ::SSL_read(ssl_, buffer, sizeof(buffer));
+        if (rc > 0) {
+            in_.append(buffer, static_cast<std::size_t>(rc));
+            continue;
+        }
+        auto const error = ::SSL_get_error(ssl_, rc);
+        if (error == SSL_ERROR_WANT_READ)
+            return;
+        if (error == SSL_ERROR_WANT_WRITE) {
+            ssl_wants_write_ = true;
+            return;
+        }
+        // Messages already buffered are handed out before this is thrown.
+        if (error == SSL_ERROR_ZERO_RETURN)
+            read_error_ = "Websocket: Connection closed by " + host_ + '.';
+        else
+            read_error_ = this->ssl_error("Read from " + host_ + " failed", rc);
+        return;
+    }
+}
+
+void Websocket_client::finish_upgrade()
+{
+    auto const end = in_.find("\r\n\r\n");
+    if (end == std::string::npos) {
+        if (in_.size() > 16'384)
+            throw Crab_error{"Websocket: Oversized upgrade response."};
+        return;
+    }
+    auto const header = in_.substr(0, end + 2);
+    if (header.compare(0, 12, "HTTP/1.1 101") != 0) {
+        throw Crab_error{"Websocket: Upgrade refused by " + host_ + ": " +
+                         header.substr(0, header.find("\r\n"))};
+    }
+    if (header_value(header, "Sec-WebSocket-Accept") != expected_accept(key_))
+        throw Crab_error{"Websocket: Bad Sec-WebSocket-Accept from " + host_};
+    in_.erase(0, end + 4);
+    in_offset_ = 0;
+    state_     = State::Open;
+}
+
+void Websocket_client::queue_frame(std::uint8_t opcode,
+                                   char const* data,
+                                   std::size_t size)
+{
+    out_.push_back(static_cast<char>(0x80 | opcode));
+    if (size < 126)
+        out_.push_back(static_cast<char>(0x80 | size));
+    else if (size <= 0xFFFF) {
+        out_.push_back(static_cast<char>(0x80 | 126));
+        out_.push_back(static_cast<char>((size >> 8) & 0xFF));
+        out_.push_back(static_cast<char>(size & 0xFF));
+    }
+    else {
+        out_.push_back(static_cast<char>(0x80 | 127));
+        for (auto shift = 56; shift >= 0; shift -= 8)
+            out_.push_back(static_cast<char>((std::uint64_t{size} >> shift) &
+                                             0xFF));
+    }
+    char mask[4];
+    for (auto& byte : mask)
+        byte = static_cast<char>(rng_());
+    out_.append(mask, 4);
+    for (auto i = std::size_t{0}; i < size; ++i)
+        out_.push_back(static_cast<char>(data[i] ^ mask[i % 4]));
+}
+
+void Websocket_client::throw_ssl_error(std::string const& what, int rc)
+{
+    throw Crab_error{this->ssl_error(what, rc)};
+}
+
+auto Websocket_client::ssl_error(std::string const& what, int rc)
+    -> std::string
+{
+    auto const code = ::ERR_get_error();
+    ::ERR_clear_error();
+    auto detail = std::string{};
+    if (code != 0) {
+        char buffer[256];
+        ::ERR_error_string_n(code, buffer, sizeof(buffer));
+        detail = buffer;
+    }
+    else if (rc == 0)
+        detail = "unexpected EOF";
+    else
+        detail = std::strerror(errno);
+    return "Websocket: " + what + ": " + detail;
+}
+
+}  // namespace crab
@@ -0,0 +1,121 @@
+#ifndef CRAB_MARKETS_WEBSOCKET_CLIENT_HPP
+#define CRAB_MARKETS_WEBSOCKET_CLIENT_HPP
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+
+// OpenSSL forward declarations.
+typedef struct ssl_st SSL;
+
+struct addrinfo;
+
+namespace crab {
+
+/// Non-blocking secure websocket client, driven by socket readiness.
+/** Owner registers fd() with a Reactor after open() and calls progress()
+ *  whenever the socket is ready, then pulls complete messages out with
+ *  next_message(). While connecting, progress() may move on to the next
+ *  address of the host, fd() then changes and must be registered again.
+ *  Pings are answered automatically. Any failure throws Crab_error, after
+ *  which the client must be closed and opened again. */
+class Websocket_client {
+   public:
+    enum class State { Closed, Connecting, Tls_handshake, Upgrading, Open };
+
+   public:
+    Websocket_client() = default;
+
+    Websocket_client(Websocket_client const&) = delete;
+    Websocket_client& operator=(Websocket_client const&) = delete;
+
+    ~Websocket_client() { this->close(); }
+
+   public:
+    /// Begin connecting to wss://\p host\p resource on port 443.
+    /** Returns once the TCP connect is in flight, host name resolution is
+     *  the only blocking step. */
+    void open(std::string const& host, std::string const& resource);
+
+    /// Close the socket immediately, without a closing handshake.
+    void close();
+
+    /// Advance the connection after the socket reported readiness.
+    /** Flushes queued writes and reads everything available. */
+    void progress(bool readable, bool writable);
+
+    /// Extract the next complete text or binary message into \p message.
+    /** Returns false if no complete message is buffered. \p message is
+     *  overwritten, so its capacity is reused across calls. Throws once all
+     *  buffered messages are taken if the connection has been closed. */
+    [[nodiscard]] auto next_message(std::string& message) -> bool;
+
+    /// Queue a text message, sent as the socket becomes writable.
+    void send_text(std::string const& message);
+
+    /// Return true if the connection is waiting on the socket to be writable.
+    [[nodiscard]] auto wants_write() const -> bool;
+
+    [[nodiscard]] auto fd() const -> int { return fd_; }
+
+    [[nodiscard]] auto state() const -> State { return state_; }
+
+    [[nodiscard]] auto is_open() const -> bool { return state_ == State::Open; }
+
+   private:
+    int fd_      = -1;
+    SSL* ssl_    = nullptr;
+    State state_ = State::Closed;
+
+    // Every address the host resolved to, next_ is the next one to try.
+    ::addrinfo* addresses_ = nullptr;
+    ::addrinfo* next_      = nullptr;
+
+    std::string host_;
+    std::string resource_;
+    std::string key_;  // Sec-WebSocket-Key sent with the upgrade request.
+
+    std::string out_;  // Bytes waiting to be written.
+    std::string in_;   // Bytes read but not yet parsed into messages.
+    std::size_t in_offset_ = 0;
+    std::string fragments_;  // Payload of an unfinished fragmented message.
+    std::string read_error_;  // Set once the read side has failed.
+    bool ssl_wants_write_ = false;
+
+    std::mt19937 rng_{std::random_device{}()};
+
+   private:
+    /// Start a non-blocking connect to the first of next_ that accepts one.
+    /** The previous socket, if any, is closed only once the new one exists,
+     *  so fd() always changes. Returns false with the last failure in
+     *  \p error if no address is left. */
+    auto connect_next(std::string& error) -> bool;
+
+    /// Check the result of the non-blocking connect and start TLS.
+    /** Moves on to the next address if this one failed. */
+    void finish_connect();
+
+    void tls_handshake();
+
+    /// Write as much of out_ as the socket will take.
+    void flush();
+
+    /// Read everything available from the socket into in_.
+    void fill();
+
+    /// Parse the HTTP upgrade response once it is fully buffered.
+    void finish_upgrade();
+
+    /// Queue a single masked frame with the given \p opcode.
+    void queue_frame(std::uint8_t opcode, char const* data, std::size_t size);
+
+    /// Throw a Crab_error built from \p what and the OpenSSL error for \p rc.
+    [[noreturn]] void throw_ssl_error(std::string const& what, int rc);
+
+    /// Return an error message from \p what and the OpenSSL error for \p rc.
+    [[nodiscard]] auto ssl_error(std::string const& what, int rc)
+        -> std::string;
+};
+
+}  // namespace crab
+#endif  // CRAB_MARKETS_WEBSOCKET_CLIENT_HPP
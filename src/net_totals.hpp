@@ -39,31 +39,27 @@ class Net_totals : public ox::HTuple<ox::HLabel,
     ox::Widget& buffer_end          = this->get<6>();
 
    public:
-    Net_totals(std::string const& quote_currency)
+    /// A \p consolidated page sums every quote currency in \p quote_currency.
+    Net_totals(std::string const& quote_currency, bool consolidated = false)
+        : consolidated_{consolidated}
     {
         using namespace ox::pipe;
         *this | fixed_height(1) | descendants() | bg(crab::Almost_bg);
 
         // TODO use pipe::text
-        title.set_text(U" Totals" | ox::Trait::Bold);
+        this->set_complete(true);
         title | fixed_width(21);
         buffer_1 | fixed_width(56);
 
-        value.amount.round_to_hundredths(true);
-        value.amount.set_offset(8);
-        value.currency.set(quote_currency);
+        value.set_currency(quote_currency);
         value | fixed_width(14);
 
         buffer_2 | fixed_width(14);
 
-        open_pl.amount.round_to_hundredths(true);
-        open_pl.amount.set_offset(8);
-        open_pl.currency.set(quote_currency);
+        open_pl.set_currency(quote_currency);
         open_pl | fixed_width(14);
 
-        daily_pl.amount.round_to_hundredths(true);
-        daily_pl.amount.set_offset(8);
-        daily_pl.currency.set(quote_currency);
+        daily_pl.set_currency(quote_currency);
         daily_pl | fixed_width(14);
     }
 
@@ -73,6 +69,22 @@ class Net_totals : public ox::HTuple<ox::HLabel,
     {
         return value.currency.currency();
     }
+
+    [[nodiscard]] auto is_consolidated() const -> bool { return consolidated_; }
+
+    /// Mark a consolidated page that leaves out unconvertible quotes with *.
+    void set_complete(bool complete)
+    {
+        if (!consolidated_)
+            title.set_text(U" Totals" | ox::Trait::Bold);
+        else if (complete)
+            title.set_text(U" Net Worth" | ox::Trait::Bold);
+        else
+            title.set_text(U" Net Worth*" | ox::Trait::Bold);
+    }
+
+   private:
+    bool consolidated_;
 };
 
 // Page one is blank until first totals are added.
@@ -87,12 +99,13 @@ class Net_totals_container : public ox::layout::Stack<Net_totals> {
 
    public:
     /// Add a new child Widget associated with \p quote currency.
-    auto append_net_totals(std::string const& quote) -> Net_totals&
+    auto append_net_totals(std::string const& quote, bool consolidated = false)
+        -> Net_totals&
     {
         if (!child_added_)
             this->remove_and_delete_child_at(0);
         child_added_ = true;
-        auto& child  = this->make_page(quote);
+        auto& child  = this->make_page(quote, consolidated);
         if (this->child_count() == 1)
             this->set_active_page(0);
         return child;
@@ -123,8 +136,9 @@ class Net_totals_container : public ox::layout::Stack<Net_totals> {
     /// Return nullptr if not found, searches by quote currency.
     [[nodiscard]] auto find_child(std::string const& quote) -> Net_totals*
     {
-        return this->find_child_if(
-            [&quote](Net_totals& child) { return child.quote() == quote; });
+        return this->find_child_if([&quote](Net_totals& child) {
+            return !child.is_consolidated() && child.quote() == quote;
+        });
     }
 
    private:
@@ -154,6 +168,26 @@ class Net_totals_manager : public Net_totals_container {
         child.daily_pl.amount.set(sum);
     }
 
+    /// Show every quote currency converted into \p reporting currency.
+    /** The page is added and shown the first time this is called. */
+    void update_consolidated(std::string const& reporting,
+                             double value,
+                             double open_pl,
+                             double daily_pl,
+                             bool complete)
+    {
+        auto* at = this->find_child_if(
+            [](Net_totals& child) { return child.is_consolidated(); });
+        if (at == nullptr) {
+            at = &this->append_net_totals(reporting, true);
+            this->set_active_page(this->child_count() - 1);
+        }
+        at->value.amount.set(value);
+        at->open_pl.amount.set(open_pl);
+        at->daily_pl.amount.set(daily_pl);
+        at->set_complete(complete);
+    }
+
     void flip_forward()
     {
         auto const child_count = this->child_count();
@@ -0,0 +1,70 @@
+#include "parse_number.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <locale>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace {
+
+/// Return true if \p x is a decimal number that std::strtod would accept.
+/** Digits with an optional point and exponent, no sign, hex, inf or nan. */
+[[nodiscard]] auto is_decimal(std::string_view x) -> bool
+{
+    auto i            = std::size_t{0};
+    auto const digits = [&] {
+        auto const begin = i;
+        while (i < x.size() && x[i] >= '0' && x[i] <= '9')
+            ++i;
+        return i - begin;
+    };
+    auto mantissa = digits();
+    if (i < x.size() && x[i] == '.') {
+        ++i;
+        mantissa += digits();
+    }
+    if (mantissa == 0)
+        return false;
+    if (i < x.size() && (x[i] == 'e' || x[i] == 'E')) {
+        ++i;
+        if (i < x.size() && (x[i] == '+' || x[i] == '-'))
+            ++i;
+        if (digits() == 0)
+            return false;
+    }
+    return i == x.size();
+}
+
+}  // namespace
+
+namespace crab {
+
+auto parse_double(std::string_view x) -> std::optional<double>
+{
+    auto const negative = !x.empty() && x.front() == '-';
+    if (!x.empty() && (negative || x.front() == '+'))
+        x.remove_prefix(1);
+    if (!is_decimal(x))
+        return std::nullopt;
+    auto result = 0.;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    auto const last         = x.data() + x.size();
+    auto const [end, error] = std::from_chars(x.data(), last, result);
+    if (error != std::errc{} || end != last)
+        return std::nullopt;
+#else
+    // No floating point from_chars, a stream in the classic locale is exact.
+    auto ss = std::istringstream{std::string{x}};
+    ss.imbue(std::locale::classic());
+    if (!(ss >> result) || !std::isfinite(result))
+        return std::nullopt;
+#endif
+    return negative ? -result : result;
+}
+
+}  // namespace crab
@@ -0,0 +1,38 @@
+#ifndef CRAB_PARSE_NUMBER_HPP
+#define CRAB_PARSE_NUMBER_HPP
+#include <charconv>
+#include <optional>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+namespace crab {
+
+// Every number read from a feed, a file or the keyboard goes through these.
+// They never throw and never look at the locale, '.' is always the decimal
+// point whatever LC_NUMERIC the terminal sets.
+
+/// Parse all of \p x as a finite decimal number, such as "-12.5" or "1e-8".
+/** A leading '+' is allowed, whitespace and thousands separators are not.
+ *  Returns std::nullopt if \p x is empty, malformed or out of range. */
+[[nodiscard]] auto parse_double(std::string_view x) -> std::optional<double>;
+
+/// Parse all of \p x as a decimal integer of type \p Int.
+/** A leading '+' is allowed, '-' only if \p Int is signed. Returns
+ *  std::nullopt if \p x is empty, malformed or out of range for \p Int. */
+template <typename Int>
+[[nodiscard]] auto parse_integer(std::string_view x) -> std::optional<Int>
+{
+    static_assert(std::is_integral_v<Int>);
+    if (x.size() > 1 && x.front() == '+' && x[1] != '-')
+        x.remove_prefix(1);
+    auto result             = Int{0};
+    auto const last         = x.data() + x.size();
+    auto const [end, error] = std::from_chars(x.data(), last, result);
+    if (error != std::errc{} || end != last)
+        return std::nullopt;
+    return result;
+}
+
+}  // namespace crab
+#endif  // CRAB_PARSE_NUMBER_HPP
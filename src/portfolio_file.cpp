@@ -0,0 +1,209 @@
+#include "portfolio_file.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "asset.hpp"
+#include "filesystem.hpp"
+#include "markets/error.hpp"
+
+namespace {
+
+auto constexpr magic      = "CRABPF\0\0";
+auto constexpr magic_size = std::size_t{8};
+auto constexpr byte_order = std::uint32_t{0x01020304};
+auto constexpr version    = std::uint32_t{1};
+
+struct Header {
+    char magic[magic_size];
+    std::uint32_t byte_order;
+    std::uint32_t version;
+    std::uint32_t count;
+    std::uint32_t strings_size;
+};
+
+struct Record {
+    std::uint32_t exchange;
+    std::uint32_t base;
+    std::uint32_t quote;
+    std::uint32_t reserved;
+    double quantity;
+    double cost_basis;
+};
+
+static_assert(sizeof(Header) == 24);
+static_assert(sizeof(Record) == 32);
+
+/// Builds the string table, storing each distinct string once.
+class String_table {
+   public:
+    /// Return the offset of \p x, appending it if not already stored.
+    [[nodiscard]] auto offset(std::string const& x) -> std::uint32_t
+    {
+        auto const at = offsets_.find(x);
+        if (at != std::end(offsets_))
+            return at->second;
+        auto const result = static_cast<std::uint32_t>(data_.size());
+        data_.append(x).append(1, '\0');
+        offsets_.emplace(x, result);
+        return result;
+    }
+
+    [[nodiscard]] auto data() const -> std::string const& { return data_; }
+
+   private:
+    std::string data_;
+    std::unordered_map<std::string, std::uint32_t> offsets_;
+};
+
+/// Read-only memory map of an entire file, unmapped on destruction.
+class File_map {
+   public:
+    explicit File_map(crab::fs::path const& filepath)
+    {
+        auto const fd = ::open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+            throw crab::Crab_error{"Can't open " + filepath.string() + ": " +
+                                   std::strerror(errno)};
+        struct ::stat info {};
+        if (::fstat(fd, &info) == -1) {
+            ::close(fd);
+            throw crab::Crab_error{"Can't stat " + filepath.string()};
+        }
+        size_ = static_cast<std::size_t>(info.st_size);
+        if (size_ != 0) {
+            data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data_ == MAP_FAILED)
+                data_ = nullptr;
+        }
+        ::close(fd);
+        if (size_ != 0 && data_ == nullptr)
+            throw crab::Crab_error{"Can't map " + filepath.string()};
+    }
+
+    File_map(File_map const&) = delete;
+    File_map& operator=(File_map const&) = delete;
+
+    ~File_map()
+    {
+        if (data_ != nullptr)
+            ::munmap(data_, size_);
+    }
+
+   public:
+    [[nodiscard]] auto data() const -> char const*
+    {
+        return static_cast<char const*>(data_);
+    }
+
+    [[nodiscard]] auto size() const -> std::size_t { return size_; }
+
+   private:
+    void* data_       = nullptr;
+    std::size_t size_ = 0;
+};
+
+/// Return the NUL terminated string at \p offset, checking it is in bounds.
+[[nodiscard]] auto string_at(char const* strings,
+                             std::uint32_t size,
+                             std::uint32_t offset) -> std::string
+{
+    if (offset >= size)
+        throw crab::Crab_error{"assets.crab: String offset out of range."};
+    auto const* const begin = strings + offset;
+    auto const* const end =
+        static_cast<char const*>(std::memchr(begin, '\0', size - offset));
+    if (end == nullptr)
+        throw crab::Crab_error{"assets.crab: Unterminated string."};
+    return std::string(begin, end);
+}
+
+}  // namespace
+
+namespace crab {
+
+auto render_portfolio(std::vector<Holding> const& holdings) -> std::string
+{
+    auto strings = String_table{};
+    auto records = std::vector<Record>{};
+    records.reserve(holdings.size());
+    for (auto const& h : holdings) {
+        records.push_back({strings.offset(h.asset.exchange),
+                           strings.offset(h.asset.currency.base),
+                           strings.offset(h.asset.currency.quote), 0,
+                           h.quantity, h.cost_basis});
+    }
+
+    auto header = Header{};
+    std::memcpy(header.magic, magic, magic_size);
+    header.byte_order   = byte_order;
+    header.version      = version;
+    header.count        = static_cast<std::uint32_t>(records.size());
+    header.strings_size = static_cast<std::uint32_t>(strings.data().size());
+
+    auto result = std::string{};
+    result.reserve(sizeof(Header) + records.size() * sizeof(Record) +
+                   strings.data().size());
+    result.append(reinterpret_cast<char const*>(&header), sizeof(header));
+    result.append(reinterpret_cast<char const*>(records.data()),
+                  records.size() * sizeof(Record));
+    result.append(strings.data());
+    return result;
+}
+
+auto read_portfolio(fs::path const& filepath) -> std::vector<Holding>
+{
+    auto const file = File_map{filepath};
+    if (file.size() < sizeof(Header))
+        throw Crab_error{"assets.crab: File too small."};
+
+    auto header = Header{};
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, magic, magic_size) != 0)
+        throw Crab_error{"assets.crab: Not a portfolio file."};
+    if (header.byte_order != byte_order)
+        throw Crab_error{"assets.crab: Written on a host of other byte order."};
+    if (header.version != version)
+        throw Crab_error{"assets.crab: Unsupported version " +
+                         std::to_string(header.version)};
+    auto const records_size = std::uint64_t{header.count} * sizeof(Record);
+    if (sizeof(Header) + records_size + header.strings_size != file.size())
+        throw Crab_error{"assets.crab: Size does not match header."};
+
+    auto const* const records_begin = file.data() + sizeof(Header);
+    auto const* const strings       = records_begin + records_size;
+
+    // Exchange and quote names repeat on most rows, convert each once.
+    auto cache     = std::unordered_map<std::uint32_t, std::string>{};
+    auto const str = [&](std::uint32_t offset) -> std::string const& {
+        auto at = cache.find(offset);
+        if (at == std::end(cache)) {
+            at = cache.emplace(offset,
+                               string_at(strings, header.strings_size, offset))
+                     .first;
+        }
+        return at->second;
+    };
+
+    auto result = std::vector<Holding>{};
+    result.reserve(header.count);
+    for (auto i = std::uint32_t{0}; i < header.count; ++i) {
+        auto r = Record{};
+        std::memcpy(&r, records_begin + i * sizeof(Record), sizeof(r));
+        result.push_back(
+            {{str(r.exchange), {str(r.base), str(r.quote)}}, r.quantity,
+             r.cost_basis});
+    }
+    return result;
+}
+
+}  // namespace crab
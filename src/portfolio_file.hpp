@@ -0,0 +1,55 @@
+#ifndef CRAB_PORTFOLIO_FILE_HPP
+#define CRAB_PORTFOLIO_FILE_HPP
+#include <string>
+#include <vector>
+
+#include "asset.hpp"
+#include "filesystem.hpp"
+
+namespace crab {
+
+/// Single row of a portfolio, as saved to and loaded from disk.
+struct Holding {
+    Asset asset;
+    double quantity;
+    double cost_basis;
+};
+
+/* Binary Portfolio Format - assets.crab
+ * -------------------------------------
+ * Compact alternative to assets.txt for large portfolios, read through a
+ * read-only memory map without any per-line parsing. All integers and doubles
+ * are in host byte order, the byte order mark rejects files from hosts that
+ * differ.
+ *
+ *   Header, 24 bytes:
+ *     char[8]  magic          "CRABPF\0\0"
+ *     u32      byte order     0x01020304
+ *     u32      version        1
+ *     u32      record count
+ *     u32      string table size in bytes
+ *
+ *   Records, 32 bytes each, in display order:
+ *     u32      exchange       offset into string table
+ *     u32      base           offset into string table
+ *     u32      quote          offset into string table
+ *     u32      reserved       zero
+ *     f64      quantity
+ *     f64      cost basis
+ *
+ *   String table:
+ *     NUL terminated strings, each distinct string is stored once. Stocks
+ *     have an empty exchange.
+ */
+
+/// Format \p holdings as the contents of an assets.crab file.
+[[nodiscard]] auto render_portfolio(std::vector<Holding> const& holdings)
+    -> std::string;
+
+/// Read every Holding from the assets.crab file at \p filepath.
+/** Throws Crab_error if the file can't be mapped or is malformed. */
+[[nodiscard]] auto read_portfolio(fs::path const& filepath)
+    -> std::vector<Holding>;
+
+}  // namespace crab
+#endif  // CRAB_PORTFOLIO_FILE_HPP
@@ -0,0 +1,110 @@
+#include "position_book.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+/// Compute the derived columns of \p n rows from their inputs.
+/** One loop per derived column, each reads at most three columns, so the
+ *  compiler can check them for overlap and vectorize every loop. The percent
+ *  change is branch free, a zero close is masked out rather than tested. */
+void pl_kernel(std::size_t n,
+               double const* quantity,
+               double const* cost_basis,
+               double const* last_price,
+               double const* last_close,
+               double* value,
+               double* open_pl,
+               double* daily_pl,
+               double* percent_change)
+{
+    for (auto i = std::size_t{0}; i < n; ++i)
+        value[i] = quantity[i] * last_price[i];
+    for (auto i = std::size_t{0}; i < n; ++i)
+        open_pl[i] = value[i] - quantity[i] * cost_basis[i];
+    for (auto i = std::size_t{0}; i < n; ++i)
+        daily_pl[i] = quantity[i] * (last_price[i] - last_close[i]);
+    for (auto i = std::size_t{0}; i < n; ++i) {
+        auto const close = last_close[i];
+        auto const has   = static_cast<double>(close != 0.);
+        percent_change[i] =
+            100. * ((last_price[i] - close) * has / (close + (1. - has)));
+    }
+}
+
+}  // namespace
+
+namespace crab {
+
+auto Position_book::add(Position const& p) -> Position_id
+{
+    auto id = Position_id{};
+    if (free_ids_.empty()) {
+        id = static_cast<Position_id>(rows_.size());
+        rows_.push_back(0);
+    }
+    else {
+        id = free_ids_.back();
+        free_ids_.pop_back();
+    }
+    auto const row = ids_.size();
+    rows_[id]      = static_cast<std::uint32_t>(row);
+    ids_.push_back(id);
+    quantity_.push_back(p.quantity);
+    cost_basis_.push_back(p.cost_basis);
+    last_price_.push_back(p.last_price);
+    last_close_.push_back(p.last_close);
+    value_.push_back(0.);
+    open_pl_.push_back(0.);
+    daily_pl_.push_back(0.);
+    percent_change_.push_back(0.);
+    this->recompute_rows(row, row + 1);
+    return id;
+}
+
+void Position_book::remove(Position_id id)
+{
+    auto const row  = this->row(id);
+    auto const last = ids_.size() - 1;
+    for (auto* column : {&quantity_, &cost_basis_, &last_price_, &last_close_,
+                         &value_, &open_pl_, &daily_pl_, &percent_change_}) {
+        (*column)[row] = (*column)[last];
+        column->pop_back();
+    }
+    ids_[row]        = ids_[last];
+    rows_[ids_[row]] = static_cast<std::uint32_t>(row);
+    ids_.pop_back();
+    free_ids_.push_back(id);
+}
+
+void Position_book::recompute(Position_id id)
+{
+    auto const row = this->row(id);
+    this->recompute_rows(row, row + 1);
+}
+
+void Position_book::recompute() { this->recompute_rows(0, ids_.size()); }
+
+void Position_book::recompute(std::vector<Position_id> const& ids)
+{
+    // One row on its own costs about four rows of a full pass.
+    if (ids.size() * 4 >= ids_.size()) {
+        this->recompute();
+        return;
+    }
+    for (auto const id : ids)
+        this->recompute(id);
+}
+
+void Position_book::recompute_rows(std::size_t first, std::size_t last)
+{
+    pl_kernel(last - first, quantity_.data() + first,
+              cost_basis_.data() + first, last_price_.data() + first,
+              last_close_.data() + first, value_.data() + first,
+              open_pl_.data() + first, daily_pl_.data() + first,
+              percent_change_.data() + first);
+}
+
+}  // namespace crab
@@ -1,5 +1,6 @@
 #ifndef CRAB_PRICE_HPP
 #define CRAB_PRICE_HPP
+#include <cstdint>
 #include <string>
 
 #include "asset.hpp"
@@ -9,6 +10,14 @@ namespace crab {
 struct Price {
     std::string value;
     Asset asset;
+    double volume         = 0.;  // Size of the trade, 0 if not reported.
+    std::int64_t time     = 0;   // Of the trade, ms since epoch, 0 if unknown.
+    std::int64_t received = 0;   // Locally, ms since epoch, 0 if unknown.
+
+    // Lowest and highest trade merged into this Price, which is the newest
+    // of them. Both 0 if unknown, as for Prices not from a feed.
+    double low  = 0.;
+    double high = 0.;
 };
 
 }  // namespace crab
@@ -0,0 +1,63 @@
+#include "price_bus_config.hpp"
+
+#include <cstddef>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+
+#include "filesystem.hpp"
+#include "log.hpp"
+#include "parse_number.hpp"
+
+namespace {
+
+// price_bus.txt Format:
+// name /crabwise-prices
+// slots 65536
+
+[[nodiscard]] auto is_power_of_two(std::size_t x) -> bool
+{
+    return x != 0 && (x & (x - 1)) == 0;
+}
+
+}  // namespace
+
+namespace crab {
+
+auto read_price_bus_config(fs::path const& filepath)
+    -> std::optional<Price_bus_config>
+{
+    if (!fs::exists(filepath))
+        return std::nullopt;
+    auto result = Price_bus_config{};
+    auto file   = std::ifstream{filepath.string()};
+    auto line   = std::string{};
+    while (std::getline(file, line, '\n')) {
+        auto ss  = std::istringstream{line};
+        auto key = std::string{};
+        if (!(ss >> key) || key.front() == '#')
+            continue;
+        if (key == "name") {
+            auto name = std::string{};
+            if ((ss >> name) && name.front() == '/' && name.size() > 1) {
+                result.name = name;
+                continue;
+            }
+        }
+        else if (key == "slots") {
+            auto text        = std::string{};
+            auto const slots = (ss >> text)
+                                   ? parse_integer<std::size_t>(text)
+                                   : std::nullopt;
+            if (slots.has_value() && is_power_of_two(*slots)) {
+                result.slot_count = *slots;
+                continue;
+            }
+        }
+        log_error("price_bus.txt skipped malformed line: " + line);
+    }
+    return result;
+}
+
+}  // namespace crab
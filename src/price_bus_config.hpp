@@ -0,0 +1,26 @@
+#ifndef CRAB_PRICE_BUS_CONFIG_HPP
+#define CRAB_PRICE_BUS_CONFIG_HPP
+#include <cstddef>
+#include <optional>
+#include <string>
+
+#include "filesystem.hpp"
+#include "markets/price_bus.hpp"
+
+namespace crab {
+
+/// Where to publish the shared memory price bus, see docs/price_bus.md.
+struct Price_bus_config {
+    std::string name       = Price_bus::default_name;
+    std::size_t slot_count = Price_bus::default_slot_count;
+};
+
+/// Read the price_bus.txt file at \p filepath.
+/** Returns std::nullopt if the file does not exist, the bus is then not
+ *  published. Missing settings keep their defaults, malformed lines are
+ *  logged and skipped. */
+[[nodiscard]] auto read_price_bus_config(fs::path const& filepath)
+    -> std::optional<Price_bus_config>;
+
+}  // namespace crab
+#endif  // CRAB_PRICE_BUS_CONFIG_HPP
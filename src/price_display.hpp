@@ -1,7 +1,11 @@
 #ifndef CRAB_PRICE_DISPLAY_HPP
 #define CRAB_PRICE_DISPLAY_HPP
+#include <cstddef>
+#include <string>
+
 #include "amount_display.hpp"
 #include "currency_display.hpp"
+#include "currency_registry.hpp"
 
 namespace crab {
 
@@ -10,12 +14,25 @@ struct Price_display : ox::HPair<Currency_display, Amount_display> {
     Amount_display& amount     = this->second;
 };
 
-/// Aligned price display and potential rounding to hundredths.
+/// Aligned price display, rounded by the rules of its currency.
 class Aligned_price_display
     : public ox::HPair<Currency_display, Aligned_amount_display> {
    public:
     Currency_display& currency     = this->first;
     Aligned_amount_display& amount = this->second;
+
+   public:
+    /// Show amounts in \p code, rounded and aligned by its registry entry.
+    void set_currency(std::string const& code)
+    {
+        auto const decimals = currency_info(code).value_decimals;
+        currency.set(code);
+        amount.set_decimals(decimals);
+        amount.set_offset(decimals < 0 ? 0 : rounded_offset);
+    }
+
+   private:
+    static auto constexpr rounded_offset = std::size_t{8};
 };
 
 }  // namespace crab
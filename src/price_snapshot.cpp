@@ -0,0 +1,82 @@
+#include "price_snapshot.hpp"
+
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "asset.hpp"
+#include "filesystem.hpp"
+#include "log.hpp"
+#include "parse_number.hpp"
+
+namespace {
+
+// Snapshot Format, one Asset per line, tab separated:
+// Exchange Base Quote Last_price Last_close Timestamp
+// Exchange is empty for stocks.
+auto constexpr header = "# ~ CrabWise Price Snapshot ~\n";
+
+/// Split \p line on tabs.
+[[nodiscard]] auto split(std::string const& line) -> std::vector<std::string>
+{
+    auto result = std::vector<std::string>{};
+    auto ss     = std::istringstream{line};
+    auto field  = std::string{};
+    while (std::getline(ss, field, '\t'))
+        result.push_back(field);
+    return result;
+}
+
+}  // namespace
+
+namespace crab {
+
+auto render_price_snapshot(std::vector<Snapshot_entry> const& entries)
+    -> std::string
+{
+    auto file = std::ostringstream{};
+    file << header
+         << std::setprecision(std::numeric_limits<double>::max_digits10);
+    for (auto const& e : entries) {
+        file << e.asset.exchange << '\t' << e.asset.currency.base << '\t'
+             << e.asset.currency.quote << '\t' << e.last_price << '\t'
+             << e.last_close << '\t' << e.timestamp << '\n';
+    }
+    return file.str();
+}
+
+auto read_price_snapshot(fs::path const& filepath)
+    -> std::vector<Snapshot_entry>
+{
+    if (!fs::exists(filepath))
+        return {};
+    auto result = std::vector<Snapshot_entry>{};
+    auto file   = std::ifstream{filepath.string()};
+    auto line   = std::string{};
+    while (std::getline(file, line, '\n')) {
+        if (line.empty() || line.front() == '#')
+            continue;
+        auto const fields = split(line);
+        if (fields.size() != 6) {
+            log_error("Price snapshot skipped malformed line: " + line);
+            continue;
+        }
+        auto const last_price = parse_double(fields[3]);  // Kept as text.
+        auto const last_close = parse_double(fields[4]);
+        auto const timestamp  = parse_integer<long long>(fields[5]);
+        if (!last_price || !last_close || !timestamp) {
+            log_error("Price snapshot skipped malformed line: " + line);
+            continue;
+        }
+        result.push_back({{fields[0], {fields[1], fields[2]}},
+                          fields[3],
+                          *last_close,
+                          static_cast<std::time_t>(*timestamp)});
+    }
+    return result;
+}
+
+}  // namespace crab
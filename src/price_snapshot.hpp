@@ -0,0 +1,31 @@
+#ifndef CRAB_PRICE_SNAPSHOT_HPP
+#define CRAB_PRICE_SNAPSHOT_HPP
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "asset.hpp"
+#include "filesystem.hpp"
+
+namespace crab {
+
+/// Last known price and close of an Asset, and when the price was received.
+struct Snapshot_entry {
+    Asset asset;
+    std::string last_price;  // Kept as text so no precision is lost.
+    double last_close;
+    std::time_t timestamp;
+};
+
+/// Format \p entries as the contents of a snapshot file.
+[[nodiscard]] auto render_price_snapshot(
+    std::vector<Snapshot_entry> const& entries) -> std::string;
+
+/// Read entries written out by render_price_snapshot from \p filepath.
+/** Returns an empty vector if the file does not exist, malformed lines are
+ *  skipped. */
+[[nodiscard]] auto read_price_snapshot(fs::path const& filepath)
+    -> std::vector<Snapshot_entry>;
+
+}  // namespace crab
+#endif  // CRAB_PRICE_SNAPSHOT_HPP
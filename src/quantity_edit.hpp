@@ -3,7 +3,6 @@
 #include <algorithm>
 #include <cctype>
 #include <cstddef>
-#include <exception>
 #include <iterator>
 #include <optional>
 #include <string>
@@ -13,6 +12,7 @@
 
 #include "format_money.hpp"
 #include "palette.hpp"
+#include "parse_number.hpp"
 
 namespace crab {
 
@@ -28,6 +28,7 @@ class Quantity_edit : public ox::Textbox {
         this->initialize(0.);
     }
 
+    /// Display \p value, quantity_updated is only emitted for user edits.
     void initialize(double value)
     {
         auto display = std::to_string(value);
@@ -38,13 +39,8 @@ class Quantity_edit : public ox::Textbox {
             insert_thousands_separators(display);
         }
         this->set_contents(display);
-        quantity_updated.emit(value);
-        value_ = value;
     }
 
-    // TODO Change to as_double?
-    auto quantity() const -> double { return value_; }
-
    protected:
     auto key_press_event(ox::Key k) -> bool override
     {
@@ -54,10 +50,8 @@ class Quantity_edit : public ox::Textbox {
             case ox::Key::Backspace_2:
             case ox::Key::Delete: {
                 auto const result = Textbox::key_press_event(k);
-                if (auto const dbl = get_double(this->contents().str()); dbl) {
-                    value_ = *dbl;
-                    quantity_updated.emit(value_);
-                }
+                if (auto const dbl = get_double(this->contents().str()); dbl)
+                    quantity_updated.emit(*dbl);
                 return result;
             }
             case ox::Key::Arrow_right:
@@ -72,8 +66,7 @@ class Quantity_edit : public ox::Textbox {
         auto const ch = key_to_char(k);
         if (validate_char(ch)) {
             if (auto const dbl = get_double(this->generate_string(ch)); dbl) {
-                value_ = *dbl;
-                quantity_updated.emit(value_);
+                quantity_updated.emit(*dbl);
                 return Textbox::key_press_event(k);
             }
         }
@@ -104,21 +97,8 @@ class Quantity_edit : public ox::Textbox {
                     std::end(input));
         if (input.empty() || input == ".")
             return 0.;
-        auto count = std::size_t{0};
-        try {
-            auto const result = std::stod(input, &count);
-            if (count == input.size())
-                return result;
-            else
-                return std::nullopt;
-        }
-        catch (std::exception const&) {
-            return std::nullopt;
-        }
+        return parse_double(input);
     }
-
-   private:
-    double value_ = 0;
 };
 
 }  // namespace crab
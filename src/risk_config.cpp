@@ -0,0 +1,110 @@
+#include "risk_config.hpp"
+
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include "asset.hpp"
+#include "filesystem.hpp"
+#include "log.hpp"
+#include "parse_number.hpp"
+
+namespace {
+
+// risk.txt Format:
+// benchmark Coinbase: BTC USD
+// interval 10s
+// window 90
+//
+// A stock benchmark is written as: benchmark Stock: SPY
+
+[[nodiscard]] auto upper(std::string x) -> std::string
+{
+    for (char& c : x)
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    return x;
+}
+
+/// Parse a length like "30s", "1m" or "1h", std::nullopt if malformed.
+[[nodiscard]] auto parse_interval(std::string const& x)
+    -> std::optional<std::chrono::seconds>
+{
+    if (x.empty())
+        return std::nullopt;
+    auto const digits = std::string_view{x}.substr(0, x.size() - 1);
+    auto const n      = crab::parse_integer<long>(digits);
+    if (!n.has_value() || *n <= 0)
+        return std::nullopt;
+    switch (x.back()) {
+        case 's': return std::chrono::seconds{*n};
+        case 'm': return std::chrono::minutes{*n};
+        case 'h': return std::chrono::hours{*n};
+    }
+    return std::nullopt;
+}
+
+/// Parse the rest of a benchmark line, "Coinbase: BTC USD" or "Stock: SPY".
+[[nodiscard]] auto parse_benchmark(std::istringstream& ss)
+    -> std::optional<crab::Asset>
+{
+    auto exchange = std::string{};
+    auto base     = std::string{};
+    if (!(ss >> exchange >> base) || exchange.back() != ':')
+        return std::nullopt;
+    exchange.pop_back();
+    exchange = upper(exchange);
+    if (exchange == "STOCK")
+        return crab::Asset{"", {upper(base), "USD"}};
+    auto quote = std::string{};
+    if (!(ss >> quote))
+        return std::nullopt;
+    return crab::Asset{exchange, {upper(base), upper(quote)}};
+}
+
+}  // namespace
+
+namespace crab {
+
+auto read_risk_config(fs::path const& filepath) -> std::optional<Risk_config>
+{
+    if (!fs::exists(filepath))
+        return std::nullopt;
+    auto result = Risk_config{};
+    auto file   = std::ifstream{filepath.string()};
+    auto line   = std::string{};
+    while (std::getline(file, line, '\n')) {
+        auto ss    = std::istringstream{line};
+        auto key   = std::string{};
+        auto value = std::string{};
+        if (!(ss >> key) || key.front() == '#')
+            continue;
+        if (key == "benchmark") {
+            if (auto const asset = parse_benchmark(ss); asset.has_value()) {
+                result.benchmark = asset;
+                continue;
+            }
+        }
+        else if (key == "interval" && (ss >> value)) {
+            if (auto const interval = parse_interval(value); interval) {
+                result.interval = *interval;
+                continue;
+            }
+        }
+        else if (key == "window" && (ss >> value)) {
+            auto const window = parse_integer<std::size_t>(value);
+            if (window.has_value() && *window >= 2) {
+                result.window = *window;
+                continue;
+            }
+        }
+        log_error("risk.txt skipped malformed line: " + line);
+    }
+    return result;
+}
+
+}  // namespace crab
@@ -0,0 +1,27 @@
+#ifndef CRAB_RISK_CONFIG_HPP
+#define CRAB_RISK_CONFIG_HPP
+#include <chrono>
+#include <cstddef>
+#include <optional>
+
+#include "asset.hpp"
+#include "filesystem.hpp"
+
+namespace crab {
+
+/// How the risk panel resamples prices and what it measures beta against.
+struct Risk_config {
+    std::optional<Asset> benchmark;  // No beta column without one.
+    std::chrono::seconds interval = std::chrono::seconds{10};
+    std::size_t window            = 90;  // Returns per rolling window.
+};
+
+/// Read the risk.txt file at \p filepath.
+/** Returns std::nullopt if the file does not exist, the risk panel is then
+ *  left hidden. Missing settings keep their defaults, malformed lines are
+ *  logged and skipped. */
+[[nodiscard]] auto read_risk_config(fs::path const& filepath)
+    -> std::optional<Risk_config>;
+
+}  // namespace crab
+#endif  // CRAB_RISK_CONFIG_HPP
@@ -0,0 +1,212 @@
+#include "risk_engine.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "asset.hpp"
+
+namespace {
+
+auto constexpr year = std::chrono::seconds{365 * 24 * 60 * 60};
+
+/// Add the products of row \p in and subtract those of row \p out.
+/** \p cross is n x n, only the i <= j triangle is written. Each inner loop is
+ *  a contiguous multiply-add over the rest of a row, which the compiler
+ *  vectorizes. */
+void cross_kernel(std::size_t n,
+                  double const* in,
+                  double const* out,
+                  double* sum,
+                  double* cross)
+{
+    for (auto i = std::size_t{0}; i < n; ++i)
+        sum[i] += in[i] - out[i];
+    for (auto i = std::size_t{0}; i < n; ++i) {
+        auto const a = in[i];
+        auto const b = out[i];
+        auto* row    = cross + i * n;
+        for (auto j = i; j < n; ++j)
+            row[j] += a * in[j] - b * out[j];
+    }
+}
+
+}  // namespace
+
+namespace crab {
+
+Risk_engine::Risk_engine(std::size_t window, Interval_t interval)
+    : window_{std::max(window, std::size_t{2})},
+      interval_{std::max(interval, Interval_t{1})},
+      periods_per_year_{static_cast<double>(year.count()) /
+                        static_cast<double>(interval_.count())}
+{}
+
+void Risk_engine::track(std::vector<Asset> const& assets)
+{
+    auto next      = std::vector<Asset>{};
+    auto columns   = std::map<Asset, std::size_t>{};
+    auto const add = [&](Asset const& asset) {
+        if (columns.emplace(asset, next.size()).second)
+            next.push_back(asset);
+    };
+    for (auto const& asset : assets)
+        add(asset);  // Duplicates keep their first column.
+    if (benchmark_.has_value())
+        add(*benchmark_);
+    if (next == assets_)
+        return;
+
+    auto const n_old = assets_.size();
+    auto const n     = next.size();
+    auto last        = std::vector<double>(n, 0.);
+    auto sampled     = std::vector<double>(n, 0.);
+    auto samples     = std::vector<std::size_t>(n, 0);
+    auto returns     = std::vector<double>(window_ * n, 0.);
+    for (auto j = std::size_t{0}; j < n; ++j) {
+        auto const old = this->column(next[j]);
+        if (!old.has_value())
+            continue;
+        last[j]    = last_[*old];
+        sampled[j] = sampled_[*old];
+        samples[j] = samples_[*old];
+        for (auto r = std::size_t{0}; r < window_; ++r)
+            returns[r * n + j] = returns_[r * n_old + *old];
+    }
+    assets_  = std::move(next);
+    columns_ = std::move(columns);
+    last_    = std::move(last);
+    sampled_ = std::move(sampled);
+    samples_ = std::move(samples);
+    returns_ = std::move(returns);
+    this->rebuild_sums();
+}
+
+void Risk_engine::set_benchmark(Asset const& asset)
+{
+    benchmark_ = asset;
+    if (!this->column(asset).has_value()) {
+        auto assets = assets_;
+        assets.push_back(asset);
+        this->track(assets);
+    }
+}
+
+void Risk_engine::set_price(Asset const& asset, double price)
+{
+    auto const at = columns_.find(asset);
+    if (at != std::end(columns_) && price > 0.)
+        last_[at->second] = price;
+}
+
+void Risk_engine::sample()
+{
+    auto const n = assets_.size();
+    auto in      = std::vector<double>(n, 0.);
+    for (auto j = std::size_t{0}; j < n; ++j) {
+        if (last_[j] > 0. && sampled_[j] > 0.) {
+            in[j]       = std::log(last_[j] / sampled_[j]);
+            samples_[j] = std::min(samples_[j] + 1, window_);
+        }
+        sampled_[j] = last_[j];
+    }
+    auto* const out = returns_.data() + head_ * n;
+    cross_kernel(n, in.data(), out, sum_.data(), cross_.data());
+    std::copy(std::begin(in), std::end(in), out);
+    head_ = (head_ + 1) % window_;
+    if (++since_rebuild_ >= window_)
+        this->rebuild_sums();
+}
+
+auto Risk_engine::report() const -> std::vector<Asset_risk>
+{
+    auto const bench     = benchmark_.has_value() ? this->column(*benchmark_)
+                                                  : std::nullopt;
+    auto const bench_var = bench.has_value() && this->is_full(*bench)
+                               ? this->covariance(*bench, *bench)
+                               : 0.;
+    auto result = std::vector<Asset_risk>{};
+    result.reserve(assets_.size());
+    for (auto i = std::size_t{0}; i < assets_.size(); ++i) {
+        auto risk    = Asset_risk{};
+        risk.asset   = assets_[i];
+        risk.samples = samples_[i];
+        if (this->is_full(i)) {
+            auto const var  = this->covariance(i, i);
+            risk.volatility = std::sqrt(var * periods_per_year_);
+            if (bench_var > 0.)
+                risk.beta = this->covariance(i, *bench) / bench_var;
+        }
+        result.push_back(risk);
+    }
+    return result;
+}
+
+auto Risk_engine::correlation(Asset const& a, Asset const& b) const
+    -> std::optional<double>
+{
+    auto const i = this->column(a);
+    auto const j = this->column(b);
+    if (!i || !j || !this->is_full(*i) || !this->is_full(*j))
+        return std::nullopt;
+    auto const denominator =
+        std::sqrt(this->covariance(*i, *i) * this->covariance(*j, *j));
+    if (denominator <= 0.)
+        return std::nullopt;
+    return std::clamp(this->covariance(*i, *j) / denominator, -1., 1.);
+}
+
+auto Risk_engine::correlations(Asset const& asset) const
+    -> std::vector<std::pair<Asset, double>>
+{
+    auto result = std::vector<std::pair<Asset, double>>{};
+    for (auto const& other : assets_) {
+        if (other == asset)
+            continue;
+        if (auto const c = this->correlation(asset, other); c.has_value())
+            result.push_back({other, *c});
+    }
+    std::stable_sort(
+        std::begin(result), std::end(result),
+        [](auto const& a, auto const& b) { return a.second > b.second; });
+    return result;
+}
+
+auto Risk_engine::column(Asset const& asset) const
+    -> std::optional<std::size_t>
+{
+    auto const at = columns_.find(asset);
+    if (at == std::end(columns_))
+        return std::nullopt;
+    return at->second;
+}
+
+auto Risk_engine::covariance(std::size_t i, std::size_t j) const -> double
+{
+    if (i > j)
+        std::swap(i, j);
+    auto const n     = static_cast<double>(window_);
+    auto const cross = cross_[i * assets_.size() + j];
+    return (cross - sum_[i] * sum_[j] / n) / (n - 1.);
+}
+
+void Risk_engine::rebuild_sums()
+{
+    auto const n = assets_.size();
+    sum_.assign(n, 0.);
+    cross_.assign(n * n, 0.);
+    auto const none = std::vector<double>(n, 0.);
+    for (auto r = std::size_t{0}; r < window_; ++r) {
+        cross_kernel(n, returns_.data() + r * n, none.data(), sum_.data(),
+                     cross_.data());
+    }
+    since_rebuild_ = 0;
+}
+
+}  // namespace crab
@@ -0,0 +1,128 @@
+#ifndef CRAB_RISK_ENGINE_HPP
+#define CRAB_RISK_ENGINE_HPP
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "asset.hpp"
+
+namespace crab {
+
+/// Rolling risk of one Asset, as of the last sample.
+struct Asset_risk {
+    Asset asset;
+    std::size_t samples = 0;           // Real returns in the window.
+    std::optional<double> volatility;  // Annualized, 0.2 is 20%.
+    std::optional<double> beta;        // To the benchmark.
+};
+
+/// Rolling volatility, beta and pairwise correlation of a set of Assets.
+/** Prices are resampled onto a regular grid by sample(), called once per
+ *  interval, which turns the last price of each Asset into a log return.
+ *  Every Asset is sampled at the same instants, so any two return series line
+ *  up. The window keeps the last \p window returns of each Asset, one row per
+ *  sample, and the sum of each column and of each pair of columns is kept up
+ *  to date: a sample adds the products of the new row and subtracts those of
+ *  the row it pushes out. That is one contiguous, vectorized pass over an
+ *  n x n triangle, whatever the window, so a few hundred Assets take well
+ *  under a millisecond a sample. The sums are rebuilt from the stored returns
+ *  once per window so rounding can't accumulate. Statistics of an Asset are
+ *  only given once its window is full of real returns. Not thread safe. */
+class Risk_engine {
+   public:
+    using Interval_t = std::chrono::seconds;
+
+   public:
+    /// Keep \p window returns, sample() is called every \p interval.
+    /** Volatility is annualized over a 365 day year of intervals, markets
+     *  that close are sampled while closed too. */
+    Risk_engine(std::size_t window, Interval_t interval);
+
+   public:
+    /// Track exactly \p assets and the benchmark, dropping any others.
+    /** Assets already tracked keep their returns, new ones start empty. */
+    void track(std::vector<Asset> const& assets);
+
+    /// Measure beta against \p asset, which is tracked from now on.
+    void set_benchmark(Asset const& asset);
+
+    [[nodiscard]] auto benchmark() const -> std::optional<Asset> const&
+    {
+        return benchmark_;
+    }
+
+    /// Set the last price of \p asset, no-op if not tracked.
+    void set_price(Asset const& asset, double price);
+
+    /// Close one interval, appending a return to every tracked Asset.
+    /** An Asset without a price since its previous sample returns zero, its
+     *  price is carried forward. */
+    void sample();
+
+   public:
+    /// Return the risk of every tracked Asset, in the order passed to track().
+    /** The benchmark is last if it was not passed to track(). */
+    [[nodiscard]] auto report() const -> std::vector<Asset_risk>;
+
+    /// Return the correlation of \p a and \p b, if both windows are full.
+    [[nodiscard]] auto correlation(Asset const& a, Asset const& b) const
+        -> std::optional<double>;
+
+    /// Return the correlation of \p asset to each other tracked Asset.
+    /** Only those with full windows, highest correlation first. */
+    [[nodiscard]] auto correlations(Asset const& asset) const
+        -> std::vector<std::pair<Asset, double>>;
+
+    [[nodiscard]] auto window() const -> std::size_t { return window_; }
+
+    [[nodiscard]] auto interval() const -> Interval_t { return interval_; }
+
+    /// Return the number of tracked Assets.
+    [[nodiscard]] auto size() const -> std::size_t { return assets_.size(); }
+
+   private:
+    std::size_t const window_;
+    Interval_t const interval_;
+    double const periods_per_year_;
+    std::optional<Asset> benchmark_;
+
+    // One column per tracked Asset.
+    std::vector<Asset> assets_;
+    std::map<Asset, std::size_t> columns_;  // Asset to column.
+    std::vector<double> last_;              // Last price, 0 if none yet.
+    std::vector<double> sampled_;           // Price at the previous sample.
+    std::vector<std::size_t> samples_;      // Real returns in the window.
+
+    // window_ rows of n returns, row head_ is the oldest and is next written.
+    std::vector<double> returns_;
+    std::size_t head_ = 0;
+
+    // Sums over the window, cross_ is n x n and only i <= j is kept.
+    std::vector<double> sum_;
+    std::vector<double> cross_;
+    std::size_t since_rebuild_ = 0;  // Samples since the sums were rebuilt.
+
+   private:
+    /// Return the column of \p asset, if tracked.
+    [[nodiscard]] auto column(Asset const& asset) const
+        -> std::optional<std::size_t>;
+
+    /// Return the sample covariance of columns \p i and \p j.
+    [[nodiscard]] auto covariance(std::size_t i, std::size_t j) const
+        -> double;
+
+    /// Return true if column \p i has a full window of real returns.
+    [[nodiscard]] auto is_full(std::size_t i) const -> bool
+    {
+        return samples_[i] >= window_;
+    }
+
+    /// Recompute sum_ and cross_ from the stored returns.
+    void rebuild_sums();
+};
+
+}  // namespace crab
+#endif  // CRAB_RISK_ENGINE_HPP
@@ -0,0 +1,178 @@
+#ifndef CRAB_RISK_PANEL_HPP
+#define CRAB_RISK_PANEL_HPP
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <termox/termox.hpp>
+
+#include "asset.hpp"
+#include "format_money.hpp"
+#include "palette.hpp"
+#include "risk_config.hpp"
+#include "risk_engine.hpp"
+
+namespace crab {
+
+/// Rolling volatility and beta of every listed Asset, beside the Tickers.
+/** The Asset of the last selected Ticker is shown first, with the Assets it
+ *  is most and least correlated with. Hidden by zero width until show(), the
+ *  table is cut off at the bottom of the screen. */
+class Risk_panel : public ox::layout::Vertical<ox::HLabel> {
+   public:
+    /// Width of the panel once shown.
+    static auto constexpr width = 32;
+
+    /// Most and least correlated Assets listed with the selected one.
+    static auto constexpr correlation_rows = std::size_t{4};
+
+   public:
+    Risk_panel()
+    {
+        using namespace ox::pipe;
+        *this | fixed_width(0) | bg(crab::Almost_bg);
+    }
+
+   public:
+    /// Show the panel, with the settings read from risk.txt.
+    void show(Risk_config const& config)
+    {
+        using namespace ox::pipe;
+        *this | fixed_width(width);
+        settings_ = std::to_string(config.interval.count()) + "s x " +
+                    std::to_string(config.window);
+        benchmark_ = config.benchmark;
+        this->set_lines(
+            {title(settings_),
+             ox::Glyph_string{U"  waiting for prices"} | ox::Trait::Dim});
+    }
+
+    /// List the correlations of \p asset from the next update() on.
+    void select(Asset const& asset) { selected_ = asset; }
+
+    /// Display the statistics of \p engine as of its last sample.
+    void update(Risk_engine const& engine)
+    {
+        auto lines = std::vector<ox::Glyph_string>{title(settings_)};
+        if (benchmark_.has_value()) {
+            lines.push_back(
+                ox::Glyph_string{" Beta to " + label(*benchmark_)} |
+                ox::Trait::Dim);
+        }
+        if (selected_.has_value())
+            append_correlations(lines, *selected_, engine);
+        lines.push_back(U"");
+        lines.push_back(ox::Glyph_string{pad_right(" Asset", name_width) +
+                                         pad_left("Vol%", 8) +
+                                         pad_left("Beta", 8)} |
+                        ox::Trait::Bold);
+        for (auto const& risk : engine.report()) {
+            auto line = pad_right(' ' + label(risk.asset), name_width);
+            if (!risk.volatility.has_value()) {
+                line += " warming " + std::to_string(risk.samples) + '/' +
+                        std::to_string(engine.window());
+                lines.push_back(ox::Glyph_string{line} | ox::Trait::Dim);
+                continue;
+            }
+            line += pad_left(round_and_to_string(100. * *risk.volatility, 1),
+                             8);
+            line += pad_left(risk.beta.has_value()
+                                 ? round_and_to_string(*risk.beta, 2)
+                                 : "-",
+                             8);
+            lines.push_back(line);
+        }
+        this->set_lines(lines);
+    }
+
+   private:
+    /// Asset names are cut to fit this many columns.
+    static auto constexpr name_width = std::size_t{16};
+
+    std::vector<ox::HLabel*> lines_;
+    std::string settings_;
+    std::optional<Asset> benchmark_;
+    std::optional<Asset> selected_;
+
+   private:
+    /// Display \p lines, blanking any left from a longer update.
+    void set_lines(std::vector<ox::Glyph_string> const& lines)
+    {
+        using namespace ox::pipe;
+        while (lines_.size() < lines.size()) {
+            auto& line = this->make_child();
+            line | bg(crab::Almost_bg);
+            lines_.push_back(&line);
+        }
+        for (auto i = std::size_t{0}; i < lines_.size(); ++i) {
+            lines_[i]->set_text(i < lines.size() ? lines[i]
+                                                 : ox::Glyph_string{});
+        }
+    }
+
+    /// Append the Assets most and least correlated with \p asset.
+    static void append_correlations(std::vector<ox::Glyph_string>& lines,
+                                    Asset const& asset,
+                                    Risk_engine const& engine)
+    {
+        lines.push_back(U"");
+        lines.push_back(
+            ox::Glyph_string{" Correlation to " + label(asset)} |
+            ox::Trait::Bold);
+        auto const all = engine.correlations(asset);
+        if (all.empty()) {
+            lines.push_back(ox::Glyph_string{U"  waiting for full windows"} |
+                            ox::Trait::Dim);
+            return;
+        }
+        // Highest first, then the lowest that aren't already listed.
+        auto const top    = std::min(all.size(), correlation_rows);
+        auto const bottom = std::max(top, all.size() - top);
+        auto const add    = [&lines](std::pair<Asset, double> const& c) {
+            lines.push_back(pad_right(' ' + label(c.first), name_width) +
+                            pad_left(round_and_to_string(c.second, 2), 8));
+        };
+        for (auto i = std::size_t{0}; i < top; ++i)
+            add(all[i]);
+        if (bottom > top)
+            lines.push_back(ox::Glyph_string{U"  ..."} | ox::Trait::Dim);
+        for (auto i = bottom; i < all.size(); ++i)
+            add(all[i]);
+    }
+
+    [[nodiscard]] static auto title(std::string const& settings)
+        -> ox::Glyph_string
+    {
+        return (U" Risk " | ox::Trait::Bold)
+            .append(ox::Glyph_string{settings} | ox::Trait::Dim);
+    }
+
+    [[nodiscard]] static auto label(Asset const& asset) -> std::string
+    {
+        return asset.currency.base + '/' + asset.currency.quote;
+    }
+
+    /// Pad with spaces to \p n columns, or cut to \p n less one.
+    [[nodiscard]] static auto pad_right(std::string x, std::size_t n)
+        -> std::string
+    {
+        if (x.size() >= n)
+            x.resize(n - 1);
+        x.append(n - x.size(), ' ');
+        return x;
+    }
+
+    [[nodiscard]] static auto pad_left(std::string x, std::size_t n)
+        -> std::string
+    {
+        if (x.size() < n)
+            x.insert(0, n - x.size(), ' ');
+        return x;
+    }
+};
+
+}  // namespace crab
+#endif  // CRAB_RISK_PANEL_HPP
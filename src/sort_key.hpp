@@ -0,0 +1,69 @@
+#ifndef CRAB_SORT_KEY_HPP
+#define CRAB_SORT_KEY_HPP
+#include <cctype>
+#include <cmath>
+#include <string>
+#include <string_view>
+#include <variant>
+
+namespace crab {
+
+/// Ticker table columns that rows can be sorted by.
+enum class Sort_column {
+    Base,
+    Market,
+    Quote,
+    Percent_change,
+    Value,
+    Open_pl,
+    Daily_pl
+};
+
+/// Return true if \p column holds text rather than numbers.
+[[nodiscard]] inline auto is_text(Sort_column column) -> bool
+{
+    return column == Sort_column::Base || column == Sort_column::Market ||
+           column == Sort_column::Quote;
+}
+
+/// Value a row is compared by, text keys are lowercased once up front.
+/** Text keys view strings owned by the row they were taken from. */
+using Sort_key = std::variant<double, std::string_view>;
+
+/// Column and direction that a table is sorted by.
+struct Sort_order {
+    Sort_column column;
+    bool reversed = false;
+
+    /// Return true if a row keyed \p a belongs above a row keyed \p b.
+    /** Text reads A to Z and numbers largest first, unless reversed. NaN
+     *  keys always go last, so every key has a place in the order. */
+    [[nodiscard]] auto before(Sort_key const& a, Sort_key const& b) const
+        -> bool
+    {
+        auto const a_nan = is_nan(a);
+        auto const b_nan = is_nan(b);
+        if (a_nan || b_nan)
+            return !a_nan;
+        auto const descending = is_text(column) == reversed;
+        return descending ? b < a : a < b;
+    }
+
+   private:
+    [[nodiscard]] static auto is_nan(Sort_key const& key) -> bool
+    {
+        auto const* const number = std::get_if<double>(&key);
+        return number != nullptr && std::isnan(*number);
+    }
+};
+
+/// Return a lowercase copy of \p x, for case insensitive text keys.
+[[nodiscard]] inline auto to_lower(std::string x) -> std::string
+{
+    for (char& c : x)
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return x;
+}
+
+}  // namespace crab
+#endif  // CRAB_SORT_KEY_HPP
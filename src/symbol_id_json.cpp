@@ -2,6 +2,7 @@
 
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -12,6 +13,7 @@
 #include <simdjson.h>
 
 #include "asset.hpp"
+#include "autosaver.hpp"
 #include "currency_pair.hpp"
 #include "filenames.hpp"
 #include "filesystem.hpp"
@@ -144,9 +146,10 @@ void write_ids_json()
 {
     auto sock      = make_socket_connection();
     auto const key = read_key();
-    auto file      = std::ofstream{crab::symbol_ids_json_filepath().string()};
-    generate_finnhub_symbol_id_json(sock, key, file);
+    auto json      = std::ostringstream{};
+    generate_finnhub_symbol_id_json(sock, key, json);
     sock.disconnect();
+    write_file_atomically(crab::symbol_ids_json_filepath(), json.str());
 }
 
 auto read_ids_json(fs::path const& filepath)
@@ -10,6 +10,7 @@
 namespace crab {
 
 /// Query and write out symbol ids to json file in ~/Documents/crabwise
+/** The file is replaced atomically, so it can be refreshed while in use. */
 void write_ids_json();
 
 /// Read in symbol ids and cooresponding Assets from given \p filepath json.
@@ -0,0 +1,220 @@
+#include "thread_config.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "filenames.hpp"
+#include "filesystem.hpp"
+#include "log.hpp"
+#include "parse_number.hpp"
+
+namespace {
+
+// threads.txt Format, one line per role, every setting optional:
+// network: threads 2 cpus 2-3 isolate
+// rest: cpus 1
+// persistence: cpus 1
+// ui: cpus 0
+auto constexpr role_names = std::array{
+    std::pair{crab::Thread_role::Ui, "ui"},
+    std::pair{crab::Thread_role::Network, "network"},
+    std::pair{crab::Thread_role::Rest, "rest"},
+    std::pair{crab::Thread_role::Persistence, "persistence"},
+};
+
+[[nodiscard]] auto parse_role(std::string const& x)
+    -> std::optional<crab::Thread_role>
+{
+    for (auto const& [role, name] : role_names) {
+        if (x == name)
+            return role;
+    }
+    return std::nullopt;
+}
+
+/// Parse a cpu list like "0,2-3" into {0, 2, 3}.
+/** Throws std::invalid_argument if malformed. */
+[[nodiscard]] auto parse_cpus(std::string const& x) -> std::vector<int>
+{
+    auto result = std::vector<int>{};
+    auto ss     = std::istringstream{x};
+    auto part   = std::string{};
+    while (std::getline(ss, part, ',')) {
+        auto const text  = std::string_view{part};
+        auto const dash  = text.find('-');
+        auto const first = crab::parse_integer<int>(text.substr(0, dash));
+        auto const last  =
+            dash == std::string_view::npos
+                ? first
+                : crab::parse_integer<int>(text.substr(dash + 1));
+        if (!first || !last || *first < 0 || *last < *first)
+            throw std::invalid_argument{"cpus"};
+        for (auto cpu = *first; cpu <= *last; ++cpu)
+            result.push_back(cpu);
+    }
+    if (result.empty())
+        throw std::invalid_argument{"cpus"};
+    std::sort(std::begin(result), std::end(result));
+    result.erase(std::unique(std::begin(result), std::end(result)),
+                 std::end(result));
+    return result;
+}
+
+/// Return every cpu the process may run on, empty if unknown.
+[[nodiscard]] auto allowed_cpus() -> std::vector<int>
+{
+    auto result = std::vector<int>{};
+#if defined(__linux__)
+    auto set = ::cpu_set_t{};
+    CPU_ZERO(&set);
+    if (::sched_getaffinity(0, sizeof(set), &set) != 0)
+        return result;
+    for (auto cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set))
+            result.push_back(cpu);
+    }
+#endif
+    return result;
+}
+
+}  // namespace
+
+namespace crab {
+
+Thread_config::Thread_config(std::array<Role_config, 4> roles,
+                             std::vector<int> allowed)
+    : roles_{std::move(roles)}
+{
+    auto isolated = std::vector<int>{};
+    auto pinned   = false;
+    for (auto const& role : roles_) {
+        pinned = pinned || !role.cpus.empty();
+        if (role.isolate) {
+            isolated.insert(std::end(isolated), std::begin(role.cpus),
+                            std::end(role.cpus));
+        }
+    }
+    std::sort(std::begin(isolated), std::end(isolated));
+    std::sort(std::begin(allowed), std::end(allowed));
+    auto shared = std::vector<int>{};
+    std::set_difference(std::begin(allowed), std::end(allowed),
+                        std::begin(isolated), std::end(isolated),
+                        std::back_inserter(shared));
+    if (shared.empty())
+        shared = allowed;
+    for (auto i = std::size_t{0}; i < roles_.size(); ++i) {
+        if (!roles_[i].cpus.empty())
+            resolved_[i] = roles_[i].cpus;
+        else if (pinned)
+            resolved_[i] = shared;
+    }
+}
+
+auto read_thread_config(fs::path const& filepath) -> Thread_config
+{
+    auto roles = std::array<Role_config, 4>{};
+    if (!fs::exists(filepath))
+        return {roles, allowed_cpus()};
+    auto file = std::ifstream{filepath.string()};
+    auto line = std::string{};
+    while (std::getline(file, line, '\n')) {
+        auto ss    = std::istringstream{line};
+        auto first = std::string{};
+        if (!(ss >> first) || first.front() == '#')
+            continue;
+        try {
+            if (first.back() != ':')
+                throw std::invalid_argument{"role"};
+            first.pop_back();
+            auto const role = parse_role(first);
+            if (!role.has_value())
+                throw std::invalid_argument{"role"};
+            auto config = Role_config{};
+            auto key    = std::string{};
+            while (ss >> key) {
+                auto value = std::string{};
+                if (key == "isolate")
+                    config.isolate = true;
+                else if (key == "threads" && ss >> value)
+                    config.threads =
+                        parse_integer<std::size_t>(value).value_or(0);
+                else if (key == "cpus" && ss >> value)
+                    config.cpus = parse_cpus(value);
+                else
+                    throw std::invalid_argument{key};
+            }
+            if (config.threads == 0)
+                throw std::invalid_argument{"threads"};
+            if (config.threads != 1 && *role != Thread_role::Network) {
+                log_error("threads.txt: Only network threads can be more "
+                          "than one, using one for: " + first);
+                config.threads = 1;
+            }
+            roles[static_cast<std::size_t>(*role)] = std::move(config);
+        }
+        catch (std::exception const&) {
+            log_error("threads.txt skipped malformed line: " + line);
+        }
+    }
+    return {roles, allowed_cpus()};
+}
+
+auto thread_config() -> Thread_config const&
+{
+    static auto const config = [] {
+        try {
+            return read_thread_config(threads_filepath());
+        }
+        catch (std::exception const& e) {
+            log_error("Failed to read threads.txt: " + std::string{e.what()});
+            return Thread_config{{}, {}};
+        }
+    }();
+    return config;
+}
+
+void enter_thread_role(Thread_role role, std::string const& name)
+{
+    auto const short_name = name.substr(0, 15);
+    auto const& cpus      = thread_config().cpus(role);
+#if defined(__linux__)
+    ::pthread_setname_np(::pthread_self(), short_name.c_str());
+    if (cpus.empty())
+        return;
+    auto set = ::cpu_set_t{};
+    CPU_ZERO(&set);
+    for (auto const cpu : cpus) {
+        if (cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+    }
+    auto const error =
+        ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+    if (error != 0) {
+        log_error("Can't pin thread " + short_name + ": " +
+                  std::strerror(error));
+    }
+#elif defined(__APPLE__)
+    ::pthread_setname_np(short_name.c_str());
+    if (!cpus.empty())
+        log_error("Thread pinning is not supported, running unpinned: " +
+                  short_name);
+#else
+    (void)cpus;
+#endif
+}
+
+}  // namespace crab
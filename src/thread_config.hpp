@@ -0,0 +1,67 @@
+#ifndef CRAB_THREAD_CONFIG_HPP
+#define CRAB_THREAD_CONFIG_HPP
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "filesystem.hpp"
+
+namespace crab {
+
+/// Kinds of thread CrabWise runs, each configured on its own.
+enum class Thread_role {
+    Ui,           // TermOx input and rendering, the main thread.
+    Network,      // Streaming feeds, one Reactor per thread.
+    Rest,         // Stats and search requests.
+    Persistence,  // Autosaves and scheduled background jobs.
+};
+
+/// Settings of one Thread_role, from threads.txt.
+struct Role_config {
+    std::size_t threads = 1;  // Only Network runs more than one.
+    std::vector<int> cpus;    // Pinned to these if not empty.
+    bool isolate = false;     // Keep every other role off of cpus.
+};
+
+/// Contents of the threads.txt file, with pinning resolved.
+class Thread_config {
+   public:
+    /// \p allowed is every cpu the process may run on.
+    Thread_config(std::array<Role_config, 4> roles, std::vector<int> allowed);
+
+   public:
+    [[nodiscard]] auto role(Thread_role r) const -> Role_config const&
+    {
+        return roles_[static_cast<std::size_t>(r)];
+    }
+
+    /// Return the cpus threads of \p r are pinned to, empty to leave as is.
+    /** A role without cpus of its own gets every allowed cpu not isolated by
+     *  another role, so it doesn't inherit a pinning from its parent thread. */
+    [[nodiscard]] auto cpus(Thread_role r) const -> std::vector<int> const&
+    {
+        return resolved_[static_cast<std::size_t>(r)];
+    }
+
+   private:
+    std::array<Role_config, 4> roles_;
+    std::array<std::vector<int>, 4> resolved_;
+};
+
+/// Read the threads.txt file at \p filepath.
+/** Returns the defaults, one unpinned thread per role, if the file does not
+ *  exist. Malformed lines are logged and skipped. */
+[[nodiscard]] auto read_thread_config(fs::path const& filepath)
+    -> Thread_config;
+
+/// Return the Thread_config read from threads.txt on first use.
+[[nodiscard]] auto thread_config() -> Thread_config const&;
+
+/// Name the calling thread \p name and pin it as configured for \p role.
+/** Names are cut to 15 characters. Failures are logged, the thread runs on
+ *  unpinned. */
+void enter_thread_role(Thread_role role, std::string const& name);
+
+}  // namespace crab
+#endif  // CRAB_THREAD_CONFIG_HPP
@@ -0,0 +1,48 @@
+#ifndef CRAB_TICKER_FILTER_HPP
+#define CRAB_TICKER_FILTER_HPP
+#include <optional>
+#include <sstream>
+#include <string>
+
+#include "sort_key.hpp"
+
+namespace crab {
+
+/// Which Tickers to show, every set part must match. All text is lowercase.
+struct Ticker_filter {
+    std::optional<std::string> market;  // Exchange name, or "stock".
+    std::optional<std::string> quote;   // Quote currency.
+    std::string text;                   // Substring of base or market.
+
+    /// Return true if the filter shows every Ticker.
+    [[nodiscard]] auto empty() const -> bool
+    {
+        return !market.has_value() && !quote.has_value() && text.empty();
+    }
+};
+
+/// Parse filter text typed by the user, case insensitive.
+/** Words are "market:<exchange>", "quote:<currency>", "stocks", or any other
+ *  text to be found within the base or market name, for instance
+ *  "market:kraken quote:btc". */
+[[nodiscard]] inline auto parse_ticker_filter(std::string const& x)
+    -> Ticker_filter
+{
+    auto result = Ticker_filter{};
+    auto ss     = std::istringstream{to_lower(x)};
+    auto word   = std::string{};
+    while (ss >> word) {
+        if (word.rfind("market:", 0) == 0)
+            result.market = word.substr(7);
+        else if (word.rfind("quote:", 0) == 0)
+            result.quote = word.substr(6);
+        else if (word == "stocks")
+            result.market = "stock";
+        else
+            result.text = word;
+    }
+    return result;
+}
+
+}  // namespace crab
+#endif  // CRAB_TICKER_FILTER_HPP
@@ -1,28 +1,41 @@
 #ifndef CRAB_TICKER_LIST_HPP
 #define CRAB_TICKER_LIST_HPP
-#include <cassert>
+#include <algorithm>
 #include <cctype>
+#include <chrono>
 #include <cstddef>
+#include <ctime>
+#include <iterator>
+#include <map>
 #include <optional>
+#include <set>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
-#include <termox/common/filter_view.hpp>
 #include <termox/termox.hpp>
 
 #include "amount_display.hpp"
+#include "animation_clock.hpp"
 #include "asset.hpp"
 #include "format_money.hpp"
 #include "line.hpp"
+#include "markets/latency_monitor.hpp"
 #include "markets/markets.hpp"
 #include "palette.hpp"
+#include "parse_number.hpp"
 #include "percent_display.hpp"
 #include "price.hpp"
 #include "price_display.hpp"
 #include "price_edit.hpp"
+#include "portfolio_file.hpp"
+#include "position_book.hpp"
+#include "price_snapshot.hpp"
 #include "quantity_edit.hpp"
+#include "sort_key.hpp"
 #include "stats.hpp"
+#include "ticker_filter.hpp"
 
 namespace crab {
 
@@ -57,7 +70,36 @@ class Asset_name : public ox::HArray<ox::HLabel, 4> {
         this->set_quote(asset.currency.quote);
     }
 
+    /// Mark the row as showing saved rather than live prices.
+    void set_stale(bool stale)
+    {
+        stale_ = stale;
+        this->show_marker();
+    }
+
+    /// Mark the row as not updated for longer than the lag threshold.
+    void set_lagging(bool lagging)
+    {
+        lagging_ = lagging;
+        this->show_marker();
+    }
+
    private:
+    bool stale_   = false;
+    bool lagging_ = false;
+
+   private:
+    /// Saved prices take precedence, they are older still.
+    void show_marker()
+    {
+        if (stale_)
+            buffer.set_text(U"~" | ox::Trait::Dim);
+        else if (lagging_)
+            buffer.set_text(U"!" | ox::Trait::Bold);
+        else
+            buffer.set_text(U"");
+    }
+
     void set_exchange(std::string const& x)
     {
         if (x.empty())
@@ -71,23 +113,36 @@ class Asset_name : public ox::HArray<ox::HLabel, 4> {
     void set_quote(std::string const& x) { quote.set_text(x); }
 };
 
-class Indicator : public ox::Notify_light {
+/// Flashes green or red as the price moves up or down.
+/** Flashes are ended by the Animation_clock of the Ticker_list, rather than
+ *  each Indicator running a timer of its own. */
+class Indicator : public ox::Widget, public Animated {
    public:
-    Indicator() { this->set_duration(ox::Notify_light::Duration_t{220}); }
+    static auto constexpr flash_length = Animation_clock::Duration_t{220};
 
    public:
-    void emit_positive()
+    void emit_positive(Animation_clock& clock)
     {
-        this->Notify_light::set_display(
-            {ox::Color::Green, ox::Color::Background});
-        this->Notify_light::emit();
+        this->flash(clock, ox::Color::Green);
     }
 
-    void emit_negative()
+    void emit_negative(Animation_clock& clock)
     {
-        this->Notify_light::set_display(
-            {ox::Color::Red, ox::Color::Background});
-        this->Notify_light::emit();
+        this->flash(clock, ox::Color::Red);
+    }
+
+    void animate(double progress) override
+    {
+        if (progress >= 1.)
+            *this | bg(ox::Color::Background);
+    }
+
+   private:
+    /// Show \p color until flash_length after the latest flash.
+    void flash(Animation_clock& clock, ox::Color color)
+    {
+        *this | bg(color);
+        clock.start(*this, flash_length);
     }
 };
 
@@ -122,6 +177,12 @@ class Listings : public ox::HTuple<Hamburger,
                                    ox::Widget,
                                    Aligned_price_display,
                                    ox::Widget,
+                                   ox::HLabel,
+                                   ox::Widget,
+                                   Price_display,
+                                   ox::Widget,
+                                   ox::HLabel,
+                                   ox::Widget,
                                    VLine,
                                    Remove_btn> {
    public:
@@ -144,9 +205,15 @@ class Listings : public ox::HTuple<Hamburger,
     Aligned_price_display& open_pl  = this->get<16>();
     ox::Widget& buffer_7            = this->get<17>();
     Aligned_price_display& daily_pl = this->get<18>();
-    ox::Widget& buffer_8            = this->get<19>();
-    VLine& div2                     = this->get<20>();
-    Remove_btn& remove_btn          = this->get<21>();
+    ox::Widget& buffer_9            = this->get<19>();
+    ox::HLabel& volume              = this->get<20>();
+    ox::Widget& buffer_10           = this->get<21>();
+    Price_display& vwap             = this->get<22>();
+    ox::Widget& buffer_11           = this->get<23>();
+    ox::HLabel& trades              = this->get<24>();
+    ox::Widget& buffer_8            = this->get<25>();
+    VLine& div2                     = this->get<26>();
+    Remove_btn& remove_btn          = this->get<27>();
 
    public:
     Listings()
@@ -168,12 +235,28 @@ class Listings : public ox::HTuple<Hamburger,
         open_pl | fixed_width(14);
         buffer_7 | fixed_width(1);
         daily_pl | fixed_width(14);
+        volume | align_right();
+        trades | align_right();
+        this->set_trade_widths(false);
     }
 
    public:
-    [[nodiscard]] auto current_stats() const -> Stats
+    /// Show the session volume, VWAP and trade count columns.
+    /** Hidden by default, shown when trades.txt is present. */
+    void show_trade_columns() { this->set_trade_widths(true); }
+
+   private:
+    /// Hide by zero width, enable() on the row would re-enable its children.
+    void set_trade_widths(bool shown)
     {
-        return {last_price.amount.as_double(), last_close.amount.as_double()};
+        using namespace ox::pipe;
+        auto const w = [shown](int width) { return shown ? width : 0; };
+        buffer_9 | fixed_width(w(1));
+        volume | fixed_width(w(14));
+        buffer_10 | fixed_width(w(2));
+        vwap | fixed_width(w(13));
+        buffer_11 | fixed_width(w(1));
+        trades | fixed_width(w(8));
     }
 };
 
@@ -203,167 +286,329 @@ class Ticker : public ox::Passive<ox::VPair<Listings, Bottom_line>> {
 
     sl::Signal<void()>& remove_me = listings.remove_btn.remove_me;
 
+    /// Key this row was last placed by in a sticky sort, see Ticker_list.
+    Sort_key ranked_key;
+
    public:
-    Ticker(Asset asset, Stats stats, double quantity, double cost_basis)
-        : asset_{asset}, last_price_{stats.last_price}
+    /// Adds a row to \p book, the Ticker only displays what the row holds.
+    /** The row is not removed with the Ticker, see Ticker_list. */
+    Ticker(Position_book& book,
+           Animation_clock& flashes,
+           Asset asset,
+           Stats stats,
+           double quantity,
+           double cost_basis)
+        : book_{book},
+          flashes_{flashes},
+          position_{book.add(
+              {quantity, cost_basis, stats.last_price, stats.last_close})},
+          asset_{asset},
+          base_key_{to_lower(asset.currency.base)},
+          market_key_{to_lower(asset.exchange.empty() ? "Stock"
+                                                      : asset.exchange)},
+          quote_key_{to_lower(asset.currency.quote)}
     {
-        listings.value.amount.amount_updated.connect([this](double) {
-            this->reset_open_pl();
-            this->reset_daily_pl();
-        });
-        listings.cost_basis.amount.quantity_updated.connect(
-            [this](double) { this->reset_open_pl(); });
-        listings.quantity.quantity_updated.connect([this](double quant) {
-            this->update_value(quant, listings.last_price.amount.as_double());
+        listings.quantity.quantity_updated.connect([this](double x) {
+            book_.set_quantity(position_, x);
+            book_.recompute(position_);
+            this->refresh_position();
         });
-        listings.last_close.amount.amount_updated.connect([this](double) {
-            this->recalculate_percent_change();
-            this->reset_daily_pl();
+        listings.cost_basis.amount.quantity_updated.connect([this](double x) {
+            book_.set_cost_basis(position_, x);
+            book_.recompute(position_);
+            this->refresh_position();
         });
 
         listings.last_price.currency.set(asset.currency.quote);
         listings.last_close.currency.set(asset.currency.quote);
-        listings.value.currency.set(asset.currency.quote);
-        if (is_USD_like(asset_.currency.quote)) {
-            listings.value.amount.round_to_hundredths(true);
-            listings.value.amount.set_offset(8);
-            listings.open_pl.amount.round_to_hundredths(true);
-            listings.open_pl.amount.set_offset(8);
-            listings.daily_pl.amount.round_to_hundredths(true);
-            listings.daily_pl.amount.set_offset(8);
-        }
+        listings.value.set_currency(asset.currency.quote);
+        listings.open_pl.set_currency(asset.currency.quote);
+        listings.daily_pl.set_currency(asset.currency.quote);
+        listings.vwap.currency.set(asset.currency.quote);
         listings.name.set(asset);
 
         listings.last_price.amount.set(stats.last_price);
-        this->recalculate_percent_change();
-
+        listings.last_close.amount.set(stats.last_close);
         listings.quantity.initialize(quantity);
         listings.cost_basis.amount.initialize(cost_basis);
-
-        this->update_last_close(stats.last_close);
+        this->refresh_position();
 
         listings.cost_basis.currency.set(asset.currency.quote);
-        listings.open_pl.currency.set(asset.currency.quote);
-        listings.daily_pl.currency.set(asset.currency.quote);
     }
 
    public:
-    void update_last_price(std::string const& value)
-    {
-        listings.last_price.amount.set(value);
-        auto count       = std::size_t{0};
-        auto const newer = std::stod(value, &count);
-        assert(count == value.size());
-        auto const older = last_price_;
-        last_price_      = newer;
+    /// Set the last price and display everything derived from it.
+    /** \p value is the price as received, already parsed into \p newer. */
+    void update_last_price(std::string const& value, double newer)
+    {
+        this->set_last_price(value, newer);
+        book_.recompute(position_);
+        this->refresh_position();
+    }
+
+    /// Display the last price, without recomputing the book.
+    /** Only sets the input of the row, the caller recomputes the book and
+     *  calls refresh_position() once for a whole batch. */
+    void set_last_price(std::string const& value, double newer)
+    {
+        updated_at_      = std::time(nullptr);
+        last_price_text_ = value;
+        if (stale_) {
+            stale_ = false;
+            listings.name.set_stale(false);
+        }
+        if (lagging_) {
+            lagging_ = false;
+            listings.name.set_lagging(false);
+        }
+        listings.last_price.amount.set(value, newer);
+        auto const older = book_.last_price(position_);
         if (newer > older)
-            listings.indicator.emit_positive();
+            listings.indicator.emit_positive(flashes_);
         else if (newer < older)
-            listings.indicator.emit_negative();
-        this->recalculate_percent_change();
-        this->update_value(listings.quantity.quantity(),
-                           listings.last_price.amount.as_double());
+            listings.indicator.emit_negative(flashes_);
+        book_.set_last_price(position_, newer);
     }
 
     void update_last_close(double value)
     {
-        last_close_ = value;
         listings.last_close.amount.set(value);
-        this->recalculate_percent_change();
+        book_.set_last_close(position_, value);
+        book_.recompute(position_);
+        this->refresh_position();
     }
 
-    [[nodiscard]] auto asset() const -> Asset const& { return asset_; }
+    /// Display the rolling trade statistics of this row's Asset.
+    void update_trades(Trade_summary const& summary)
+    {
+        listings.volume.set_text(volume_text(summary.session_volume));
+        listings.vwap.amount.set(summary.vwap);
+        listings.trades.set_text(std::to_string(summary.window_trades));
+    }
 
-    [[nodiscard]] auto quantity() const -> double
+    /// Flag the row if its price is more than \p threshold seconds old.
+    void check_lag(std::time_t now, std::time_t threshold)
     {
-        return listings.quantity.quantity();
+        auto const lagging = updated_at_ != 0 && now - updated_at_ > threshold;
+        if (lagging == lagging_)
+            return;
+        lagging_ = lagging;
+        listings.name.set_lagging(lagging);
     }
 
-    [[nodiscard]] auto cost_basis() const -> double
+    /// Show prices saved from a previous run until live data arrives.
+    /** Only sets the inputs of the row, the caller recomputes the book and
+     *  calls refresh_position() once for a whole batch. Does not flash the
+     *  up/down indicator. */
+    void warm_start(Snapshot_entry const& entry, double last_price)
     {
-        return listings.cost_basis.amount.quantity();
+        last_price_text_ = entry.last_price;
+        updated_at_      = entry.timestamp;
+        stale_           = true;
+        listings.name.set_stale(true);
+        listings.last_price.amount.set(entry.last_price, last_price);
+        listings.last_close.amount.set(entry.last_close);
+        book_.set_last_price(position_, last_price);
+        book_.set_last_close(position_, entry.last_close);
     }
 
-   private:
-    [[nodiscard]] static auto calc_value(double quantity, double last_price)
-        -> double
+    /// Display the derived columns of this row, as last recomputed.
+    void refresh_position()
     {
-        return quantity * last_price;
+        listings.percent_change.set_percent(book_.percent_change(position_));
+        listings.value.amount.set(book_.value(position_));
+        listings.open_pl.amount.set(book_.open_pl(position_));
+        listings.daily_pl.amount.set(book_.daily_pl(position_));
     }
 
-   private:
-    void recalculate_percent_change()
+    /// Return the current prices for the next warm start.
+    [[nodiscard]] auto snapshot_entry() const -> Snapshot_entry
     {
-        if (last_close_ == 0.)
-            return;
-        listings.percent_change.set_percent(
-            100. * ((last_price_ - last_close_) / last_close_));
+        auto const last_close = book_.last_close(position_);
+        if (!deferred_price_.empty())
+            return {asset_, deferred_price_, last_close, std::time(nullptr)};
+        return {asset_, last_price_text_, last_close, updated_at_};
     }
 
-    void update_value(double quantity, double last_price)
+    /// Return true if a price has been received or loaded from a snapshot.
+    [[nodiscard]] auto has_price() const -> bool
     {
-        listings.value.amount.set(calc_value(quantity, last_price));
+        return !deferred_price_.empty() || (!last_price_text_.empty() &&
+                                            book_.last_price(position_) >= 0.);
     }
 
-    void reset_open_pl()
+    [[nodiscard]] auto current_stats() const -> Stats
     {
-        auto const initial_value = listings.quantity.quantity() *
-                                   listings.cost_basis.amount.quantity();
-        auto const current_value = listings.value.amount.as_double();
-        listings.open_pl.amount.set(current_value - initial_value);
+        return {book_.last_price(position_), book_.last_close(position_)};
     }
 
-    void reset_daily_pl()
+    /// Hide the row, price updates are held back until it is shown again.
+    void hide()
     {
-        auto const diff = listings.last_price.amount.as_double() -
-                          listings.last_close.amount.as_double();
-        auto const quantity = listings.quantity.quantity();
-        listings.daily_pl.amount.set(quantity * diff);
+        hidden_ = true;
+        this->disable();
+    }
+
+    /// Show the row, applying the newest price received while hidden.
+    void show()
+    {
+        hidden_ = false;
+        this->enable();
+        if (!deferred_price_.empty())
+            this->update_last_price(std::exchange(deferred_price_, {}),
+                                    deferred_value_);
+    }
+
+    [[nodiscard]] auto is_hidden() const -> bool { return hidden_; }
+
+    /// Hold \p value until the row is shown, only the newest is kept.
+    void defer_last_price(std::string const& value, double price)
+    {
+        deferred_price_ = value;
+        deferred_value_ = price;
+    }
+
+    /// Return true if every part of \p filter matches this row.
+    [[nodiscard]] auto matches(Ticker_filter const& filter) const -> bool
+    {
+        return (!filter.market.has_value() || *filter.market == market_key_) &&
+               (!filter.quote.has_value() || *filter.quote == quote_key_) &&
+               (filter.text.empty() ||
+                base_key_.find(filter.text) != std::string::npos ||
+                market_key_.find(filter.text) != std::string::npos);
+    }
+
+    [[nodiscard]] auto asset() const -> Asset const& { return asset_; }
+
+    [[nodiscard]] auto position() const -> Position_id { return position_; }
+
+    [[nodiscard]] auto quantity() const -> double
+    {
+        return book_.quantity(position_);
+    }
+
+    [[nodiscard]] auto cost_basis() const -> double
+    {
+        return book_.cost_basis(position_);
+    }
+
+    /// Return the current value of \p column, without formatting or copies.
+    [[nodiscard]] auto sort_key(Sort_column column) const -> Sort_key
+    {
+        switch (column) {
+            case Sort_column::Base: return base_key_;
+            case Sort_column::Market: return market_key_;
+            case Sort_column::Quote: return quote_key_;
+            case Sort_column::Percent_change:
+                return book_.percent_change(position_);
+            case Sort_column::Value: return book_.value(position_);
+            case Sort_column::Open_pl: return book_.open_pl(position_);
+            case Sort_column::Daily_pl: return book_.daily_pl(position_);
+        }
+        return 0.;
     }
 
    private:
+    Position_book& book_;
+    Animation_clock& flashes_;
+    Position_id const position_;
     Asset asset_;
 
-    // These are only used for percentage calculation, so double is fine.
-    double last_price_ = 0.;
-    double last_close_ = 0.;
+    std::string last_price_text_;  // Unformatted, as received.
+    std::time_t updated_at_ = 0;   // Time last price was received.
+    bool stale_             = false;
+    bool lagging_           = false;  // Price older than the lag threshold.
+
+    bool hidden_ = false;
+    std::string deferred_price_;  // Newest price received while hidden.
+    double deferred_value_ = 0.;  // deferred_price_, parsed.
+
+    // Lowercased once, Sort_keys and filters use these.
+    std::string const base_key_;
+    std::string const market_key_;
+    std::string const quote_key_;
+
+   private:
+    /// Four decimals, trailing zeros trimmed, thousands separated.
+    [[nodiscard]] static auto volume_text(double x) -> std::string
+    {
+        auto result = round_and_to_string(x, 4);
+        format_decimal_zeros(result);
+        insert_thousands_separators(result);
+        return result;
+    }
 };
 
 class Ticker_list : public ox::Passive<ox::layout::Vertical<Ticker>> {
    private:
     using Base_t = ox::Passive<ox::layout::Vertical<Ticker>>;
 
+   public:
+    /// Rows without a new price for longer than this are flagged.
+    static auto constexpr lag_threshold = std::chrono::seconds{60};
+
+    /// Interval of the timer stepping price flashes, while any are shown.
+    static auto constexpr frame_period = std::chrono::milliseconds{40};
+
    public:
     // Sends quote currency and sum
     sl::Signal<void(std::string const&, double)> value_total_updated;
     sl::Signal<void(std::string const&, double)> open_pl_total_updated;
     sl::Signal<void(std::string const&, double)> daily_pl_total_updated;
 
+    /// Emitted when a Ticker is added, removed, moved or its holdings edited.
+    sl::Signal<void()> portfolio_changed;
+
+    /// Emitted with each last price received, including for hidden rows.
+    sl::Signal<void(Asset const&, double)> last_price_received;
+
+    /// Emitted with the lowest and highest trade merged into a streamed price.
+    /** Before last_price_received, only when the feed reports the range. */
+    sl::Signal<void(Asset const&, double, double)> trade_range_received;
+
+    /// Emitted with each last close received or loaded from a snapshot.
+    sl::Signal<void(Asset const&, double)> last_close_received;
+
+    /// Emitted with the Asset of a Ticker when its hamburger is pressed.
+    sl::Signal<void(Asset const&)> ticker_selected;
+
+    /// Sends the summed quantity and quantity * cost basis of an Asset.
+    /** Emitted when a Ticker is added, removed or its holdings edited. */
+    sl::Signal<void(Asset const&, double, double)> position_changed;
+
    private:
     /// Return pointer to first Ticker if asset matches, nullptr if can't find.
     [[nodiscard]] auto find_ticker(Asset const& asset) -> Ticker*
     {
-        return this->find_child_if(
-            [&](Ticker& child) { return child.asset() == asset; });
+        auto const& tickers = this->asset_tickers(asset);
+        return tickers.empty() ? nullptr : tickers.front();
     }
 
-    /// Returns a filtered view of all Tickers holding the given \p asset.
-    [[nodiscard]] auto asset_ticker_view(Asset const& asset)
+    /// Return all Tickers holding the given \p asset, from the index.
+    [[nodiscard]] auto asset_tickers(Asset const& asset) const
+        -> std::vector<Ticker*> const&
     {
-        return ox::Owning_filter_view{
-            this->get_children(),
-            [asset](auto const& child) { return child.asset() == asset; }};
+        static auto const none = std::vector<Ticker*>{};
+        auto const at          = by_asset_.find(asset);
+        return at == std::end(by_asset_) ? none : at->second;
     }
 
    public:
     Ticker_list()
     {
         markets_.price_update.connect(
-            [this](Price const& p) { this->update_ticker(p); });
+            [this](std::vector<Price> const& prices) {
+                this->update_tickers(prices);
+            });
         markets_.stats_received.connect(
             [this](Asset const& asset, Stats const& stats) {
                 this->init_ticker(asset, stats);
             });
+        markets_.trades_update.connect(
+            [this](Asset const& asset, Trade_summary const& summary) {
+                for (Ticker* child : this->asset_tickers(asset))
+                    child->update_trades(summary);
+            });
     }
 
     ~Ticker_list() { markets_.shutdown(); }
@@ -374,73 +619,377 @@ class Ticker_list : public ox::Passive<ox::layout::Vertical<Ticker>> {
         Ticker* const existing = this->find_ticker(asset);
         auto stats             = Stats{-1., 0.};
         if (existing == nullptr) {
-            markets_.subscribe(asset);
+            if (watched_.count(asset) == 0)
+                markets_.subscribe(asset);
             markets_.request_stats(asset);
         }
         else
-            stats = existing->listings.current_stats();
+            stats = existing->current_stats();
+
+        this->make_ticker(asset, stats, quantity, cost_basis);
+        this->rebuild_totals(asset.currency.quote);
+        portfolio_changed.emit();
+    }
 
-        auto& child = this->make_child(asset, stats, quantity, cost_basis);
+    /// Add a Ticker for each of \p holdings, in order.
+    /** Assets are subscribed to and their stats requested as one batch. */
+    void add_tickers(std::vector<Holding> const& holdings)
+    {
+        auto known = std::map<Asset, Stats>{};
+        for (Ticker const& child : this->get_children())
+            known.emplace(child.asset(), child.current_stats());
+        auto batch = std::vector<Asset>{};
+        for (auto const& h : holdings) {
+            auto const [at, is_new] = known.emplace(h.asset, Stats{-1., 0.});
+            if (is_new)
+                batch.push_back(h.asset);
+            this->make_ticker(h.asset, at->second, h.quantity, h.cost_basis);
+        }
+        if (!batch.empty()) {
+            auto unwatched = std::vector<Asset>{};
+            std::copy_if(std::begin(batch), std::end(batch),
+                         std::back_inserter(unwatched),
+                         [this](Asset const& a) {
+                             return watched_.count(a) == 0;
+                         });
+            markets_.subscribe(unwatched);
+            // Rows hidden by the filter wait behind the ones on screen.
+            auto const hidden = std::stable_partition(
+                std::begin(batch), std::end(batch), [this](Asset const& a) {
+                    auto const& tickers = this->asset_tickers(a);
+                    return std::any_of(
+                        std::begin(tickers), std::end(tickers),
+                        [](Ticker const* t) { return !t->is_hidden(); });
+                });
+            markets_.request_stats(
+                std::vector<Asset>(std::begin(batch), hidden),
+                Rest_lane::Visible);
+            markets_.request_stats(std::vector<Asset>(hidden, std::end(batch)),
+                                   Rest_lane::Background);
+        }
+        for (auto const& [quote, tickers] : by_quote_)
+            this->rebuild_totals(quote);
+        portfolio_changed.emit();
+    }
+
+   private:
+    /// Create a Ticker at the end of the list and connect its signals.
+    void make_ticker(Asset const& asset,
+                     Stats stats,
+                     double quantity,
+                     double cost_basis)
+    {
+        auto& child =
+            this->make_child(book_, flashes_, asset, stats, quantity,
+                             cost_basis);
+        if (show_trades_)
+            child.listings.show_trade_columns();
         child.remove_me.connect([this, &child_ref = child] {
-            auto const quote = child_ref.asset().currency.quote;
+            auto const asset = child_ref.asset();
             this->remove_ticker(child_ref);
-            value_total_updated.emit(quote, this->value_sum(quote));
-            open_pl_total_updated.emit(quote, this->open_pl_sum(quote));
-            daily_pl_total_updated.emit(quote, this->daily_pl_sum(quote));
+            this->rebuild_totals(asset.currency.quote);
+            this->emit_position(asset);
+            portfolio_changed.emit();
         });
+        // Connected after the Ticker's own slots, so the book is up to date.
+        child.listings.quantity.quantity_updated.connect(
+            [this, &child](double) { this->holding_edited(child); });
+        child.listings.cost_basis.amount.quantity_updated.connect(
+            [this, &child](double) { this->holding_edited(child); });
         child.listings.hamburger.pressed.connect(
-            [this, &child] { last_selected_ = &child; });
-        child.listings.hamburger.install_event_filter(*this);
-        child.listings.value.amount.amount_updated.connect(
-            [quote = child.asset().currency.quote, this](double) {
-                value_total_updated.emit(quote, this->value_sum(quote));
-            });
-        child.listings.open_pl.amount.amount_updated.connect(
-            [quote = child.asset().currency.quote, this](double) {
-                open_pl_total_updated.emit(quote, this->open_pl_sum(quote));
-            });
-        child.listings.daily_pl.amount.amount_updated.connect(
-            [quote = child.asset().currency.quote, this](double) {
-                daily_pl_total_updated.emit(quote, this->daily_pl_sum(quote));
+            [this, &child] {
+                last_selected_ = &child;
+                ticker_selected.emit(child.asset());
             });
+        child.listings.hamburger.install_event_filter(*this);
+        by_asset_[asset].push_back(&child);
+        by_exchange_[asset.exchange].push_back(&child);
+        by_quote_[asset.currency.quote].push_back(&child);
+        if (child.matches(filter_))
+            visible_.push_back(&child);
+        else
+            child.hide();
+        this->emit_position(asset);
+        if (sort_.has_value()) {
+            ranked_.push_back(&child);
+            this->move_to_rank(ranked_.size() - 1,
+                               child.sort_key(sort_->column));
+        }
     }
 
+   public:
     void remove_ticker(Ticker& ticker_ref)
     {
         auto const asset = ticker_ref.asset();
         if (last_selected_ == &ticker_ref)
             last_selected_ = nullptr;
+        if (sort_.has_value())
+            ranked_.erase(std::next(std::begin(ranked_),
+                                    this->rank_of(ticker_ref)));
+        if (!ticker_ref.is_hidden())
+            erase_from(visible_, &ticker_ref);
+        erase_from(by_asset_, asset, &ticker_ref);
+        erase_from(by_exchange_, asset.exchange, &ticker_ref);
+        erase_from(by_quote_, asset.currency.quote, &ticker_ref);
+        book_.remove(ticker_ref.position());
         this->remove_and_delete_child(&ticker_ref);
-        if (this->find_ticker(asset) == nullptr)  // Last ticker of this asset.
+        // Unsubscribed with the last Ticker of the asset, unless watched.
+        if (this->find_ticker(asset) == nullptr && watched_.count(asset) == 0)
             markets_.unsubscribe(asset);
     }
 
-    /// Update the last price of each Ticker with the Asset within \p price.
-    void update_ticker(Price price)
+    /// Update the Tickers of every Asset in \p prices, a batch from a drain.
+    /** Every price is written to the book first, the rows touched are
+     *  recomputed at once, then each displays its results. The totals of
+     *  each quote are adjusted by the change in its touched rows and emitted
+     *  once per batch, so a batch costs the rows it touches, not the whole
+     *  list for each price. */
+    void update_tickers(std::vector<Price> const& prices)
     {
-        for (Ticker& child : asset_ticker_view(price.asset))
-            child.update_last_price(price.value);
+        touched_.clear();
+        for (Price const& price : prices) {
+            auto const value = parse_double(price.value);
+            if (!value.has_value())
+                continue;
+            if (price.low > 0. && price.high > 0.)
+                trade_range_received.emit(price.asset, price.low, price.high);
+            last_price_received.emit(price.asset, *value);
+            for (Ticker* child : this->asset_tickers(price.asset)) {
+                if (child->is_hidden())
+                    child->defer_last_price(price.value, *value);
+                else {
+                    child->set_last_price(price.value, *value);
+                    touched_.push_back(child);
+                }
+            }
+        }
+        if (touched_.empty())
+            return;
+        // An Asset can be in a batch twice, from the daemon.
+        std::sort(std::begin(touched_), std::end(touched_));
+        touched_.erase(std::unique(std::begin(touched_), std::end(touched_)),
+                       std::end(touched_));
+
+        // The book holds each row's previous results until recomputed.
+        touched_ids_.clear();
+        for (Ticker const* child : touched_) {
+            book_.subtract_from(totals_[child->asset().currency.quote],
+                                child->position());
+            touched_ids_.push_back(child->position());
+        }
+        book_.recompute(touched_ids_);
+        touched_quotes_.clear();
+        for (Ticker* child : touched_) {
+            auto const& quote = child->asset().currency.quote;
+            book_.add_to(totals_[quote], child->position());
+            child->refresh_position();
+            this->rerank(*child);
+            touched_quotes_.insert(quote);
+        }
+        for (auto const& quote : touched_quotes_)
+            this->emit_totals(quote);
     }
 
     /// Set initial price and opening price of the given asset.
     /** No-op if asset is not in the ticker list. */
     void init_ticker(Asset const& asset, Stats const& stats)
     {
+        if (stats.last_price < 0.)
+            return;  // Failed request, keep any warm start prices.
+        last_price_received.emit(asset, stats.last_price);
+        last_close_received.emit(asset, stats.last_close);
         auto const current_str = std::to_string(stats.last_price);
-        for (Ticker& child : asset_ticker_view(asset)) {
-            child.update_last_close(stats.last_close);
-            child.update_last_price(current_str);
+        auto& totals           = totals_[asset.currency.quote];
+        for (Ticker* child : this->asset_tickers(asset)) {
+            auto const shown = !child->is_hidden();
+            if (shown)
+                book_.subtract_from(totals, child->position());
+            child->update_last_close(stats.last_close);
+            child->update_last_price(current_str, stats.last_price);
+            if (shown)
+                book_.add_to(totals, child->position());
+            this->rerank(*child);
+        }
+        this->emit_totals(asset.currency.quote);
+    }
+
+    /// Show saved prices for each Ticker with an Asset in \p entries.
+    /** Every price is written to the book first, then it is recomputed once
+     *  and each row displays its results. */
+    void warm_start(std::vector<Snapshot_entry> const& entries)
+    {
+        auto touched = std::vector<Ticker*>{};
+        for (auto const& entry : entries) {
+            auto const last_price = parse_double(entry.last_price);
+            if (!last_price.has_value())
+                continue;
+            last_price_received.emit(entry.asset, *last_price);
+            last_close_received.emit(entry.asset, entry.last_close);
+            for (Ticker* child : this->asset_tickers(entry.asset)) {
+                child->warm_start(entry, *last_price);
+                touched.push_back(child);
+            }
+        }
+        book_.recompute();
+        for (Ticker* child : touched) {
+            child->refresh_position();
+            this->rerank(*child);
+        }
+        for (auto const& [quote, tickers] : by_quote_)
+            this->rebuild_totals(quote);
+    }
+
+    /// Return the current prices of each distinct Asset that has a price.
+    [[nodiscard]] auto price_snapshot() const -> std::vector<Snapshot_entry>
+    {
+        auto entries = std::map<Asset, Snapshot_entry>{};
+        for (Ticker const& child : this->get_children()) {
+            if (child.has_price())
+                entries.emplace(child.asset(), child.snapshot_entry());
+        }
+        auto result = std::vector<Snapshot_entry>{};
+        result.reserve(entries.size());
+        for (auto const& [asset, entry] : entries)
+            result.push_back(entry);
+        return result;
+    }
+
+    /// Sort by \p column, or reverse the order if already sorted by it.
+    /** The sort is sticky, rows are moved as their keys change so the list
+     *  stays ordered until a row is moved by hand. */
+    void sort_by(Sort_column column)
+    {
+        if (sort_.has_value() && sort_->column == column)
+            sort_->reversed = !sort_->reversed;
+        else
+            sort_ = Sort_order{column};
+        auto const order = *sort_;
+        this->sort([order](auto const& a, auto const& b) {
+            return order.before(a.sort_key(order.column),
+                                b.sort_key(order.column));
+        });
+        ranked_.clear();
+        for (Ticker& child : this->get_children()) {
+            child.ranked_key = child.sort_key(order.column);
+            ranked_.push_back(&child);
         }
+        portfolio_changed.emit();
+    }
+
+    /// Show only the Tickers matching \p filter, totals are of those shown.
+    /** Candidates are looked up in the market or quote index, so only they
+     *  and the rows shown before are touched. Hidden rows skip price updates
+     *  until they are shown again. */
+    void set_filter(Ticker_filter filter)
+    {
+        filter_ = std::move(filter);
+        for (Ticker* child : visible_)
+            child->hide();
+        visible_.clear();
+        auto const show_matching = [this](std::vector<Ticker*> const& xs) {
+            for (Ticker* child : xs) {
+                if (child->matches(filter_)) {
+                    child->show();
+                    this->rerank(*child);
+                    visible_.push_back(child);
+                }
+            }
+        };
+        if (filter_.market.has_value()) {
+            for (auto const& [exchange, tickers] : by_exchange_) {
+                if (to_lower(exchange.empty() ? "Stock" : exchange) ==
+                    *filter_.market) {
+                    show_matching(tickers);
+                }
+            }
+        }
+        else if (filter_.quote.has_value()) {
+            for (auto const& [quote, tickers] : by_quote_) {
+                if (to_lower(quote) == *filter_.quote)
+                    show_matching(tickers);
+            }
+        }
+        else {
+            for (auto const& [asset, tickers] : by_asset_)
+                show_matching(tickers);
+        }
+        for (auto const& [quote, tickers] : by_quote_)
+            this->rebuild_totals(quote);
     }
 
     /// Return list of all Assets that can be added as Tickers.
-    /** Makes async request via https for Search_results.
-     *  markets_.search_results_recieved emitted when finished. */
+    /** Makes async request via https for Search_results, abandoning any
+     *  earlier search. search_results_received is emitted with each chunk of
+     *  results, then search_finished. */
     [[nodiscard]] auto request_search(std::string const& query)
     {
         markets_.request_search(query);
     }
 
+    /// Request fresh Stats for every Ticker's Asset, in \p lane.
+    void refresh_stats(Rest_lane lane) { markets_.refresh_stats(lane); }
+
+    /// Show the trade columns of every Ticker, over windows of \p window.
+    /** Trade statistics so far are cleared. */
+    void show_trade_columns(Trade_tracker::Window_t window)
+    {
+        markets_.set_trade_window(window);
+        show_trades_ = true;
+        for (Ticker& child : this->get_children())
+            child.listings.show_trade_columns();
+    }
+
+    /// Be served by the crabwise --daemon listening at \p path, if any.
+    /** Returns false if none answers, markets are then connected directly.
+     *  Call before any Ticker is added. */
+    auto connect_daemon(std::string const& path) -> bool
+    {
+        return markets_.connect_daemon(path);
+    }
+
+    /// Flag every row whose price is older than lag_threshold.
+    /** A flagged row may be a quiet market or a lagging feed, the
+     *  latency_report() of its market tells them apart. */
+    void mark_lagging()
+    {
+        auto const now = std::time(nullptr);
+        for (Ticker& child : this->get_children())
+            child.check_lag(now, lag_threshold.count());
+    }
+
+    /// Return the feed latency and staleness of every market streamed.
+    [[nodiscard]] auto latency_report() const -> std::vector<Market_latency>
+    {
+        return markets_.latency_report();
+    }
+
+    /// Publish every streamed tick to the shared memory price bus \p name.
+    /** Throws Crab_error if the region can't be created. */
+    void open_price_bus(std::string const& name, std::size_t slot_count)
+    {
+        markets_.open_price_bus(name, slot_count);
+    }
+
+    /// Keep a live order book of \p asset, reported by depth_update.
+    /** Independent of the Tickers, \p asset doesn't need to be listed. */
+    void subscribe_depth(Asset const& asset)
+    {
+        markets_.subscribe_depth(asset);
+    }
+
+    /// Stream the prices of \p asset, reported by last_price_received.
+    /** Independent of the Tickers, \p asset doesn't need to be listed and
+     *  stays subscribed when its last Ticker is removed. Its last close is
+     *  requested as well, reported by last_close_received. */
+    void watch(Asset const& asset)
+    {
+        auto const is_new = watched_.insert(asset).second;
+        if (is_new && this->find_ticker(asset) == nullptr) {
+            markets_.subscribe(asset);
+            markets_.request_stats(asset);
+        }
+    }
+
    protected:
     auto enable_event() -> bool override
     {
@@ -449,6 +998,14 @@ class Ticker_list : public ox::Passive<ox::layout::Vertical<Ticker>> {
         return Base_t::enable_event();
     }
 
+    /// Step every flash, the timer is stopped once none are running.
+    auto timer_event() -> bool override
+    {
+        if (!flashes_.step())
+            this->disable_animation();
+        return Base_t::timer_event();
+    }
+
     auto mouse_move_event_filter(Widget& receiver, ox::Mouse const& m)
         -> bool override
     {
@@ -460,63 +1017,191 @@ class Ticker_list : public ox::Passive<ox::layout::Vertical<Ticker>> {
         if (index_a == std::size_t(-1) || index_b == std::size_t(-1))
             return false;
         this->swap_children(index_a, index_b);
+        sort_.reset();  // The user's order wins over the sticky sort.
+        ranked_.clear();
+        portfolio_changed.emit();
         return true;
     }
 
    private:
     Markets markets_;
+    Position_book book_;  // Numbers of every Ticker, a row each.
+
+    // Shared by every Ticker's Indicator, one timer for all of them. Running
+    // flashes are let go when it is destroyed, before the Tickers are.
+    Animation_clock flashes_{[this] { this->enable_animation(frame_period); }};
     Ticker* last_selected_ = nullptr;
+    bool show_trades_      = false;
+
+    // Sticky sort, ranked_ mirrors the child order while sort_ is set and is
+    // ordered by each Ticker's ranked_key.
+    std::optional<Sort_order> sort_;
+    std::vector<Ticker*> ranked_;
+
+    // Secondary indexes over the children, each bucket in no special order.
+    std::map<Asset, std::vector<Ticker*>> by_asset_;
+    std::map<std::string, std::vector<Ticker*>> by_exchange_;
+    std::map<std::string, std::vector<Ticker*>> by_quote_;
+
+    Ticker_filter filter_;
+    std::vector<Ticker*> visible_;  // Rows not hidden by filter_.
+
+    std::set<Asset> watched_;  // Streamed whether listed or not.
+
+    // Value and P&L sums of the shown Tickers of each quote currency.
+    std::map<std::string, Position_totals> totals_;
+
+    // update_tickers() scratch space, reused by every batch.
+    std::vector<Ticker*> touched_;
+    std::vector<Position_id> touched_ids_;
+    std::set<std::string> touched_quotes_;
 
    public:
     sl::Signal<void(std::vector<Search_result> const&)>&
         search_results_received = markets_.search_results_received;
+    sl::Signal<void()>& search_finished = markets_.search_finished;
+    sl::Signal<void(Asset const&, Depth const&)>& depth_update =
+        markets_.depth_update;
 
    private:
-    /// Returns a lambda that takes a Ticker and returns true if \p q matches.
-    [[nodiscard]] static auto matches_quote(std::string const& q)
+    /// Return the index of \p ticker in ranked_, found by its ranked_key.
+    [[nodiscard]] auto rank_of(Ticker const& ticker) const -> std::size_t
     {
-        return [q](Ticker const& t) { return t.asset().currency.quote == q; };
+        auto const order = *sort_;
+        auto at          = std::lower_bound(
+            std::begin(ranked_), std::end(ranked_), ticker.ranked_key,
+            [order](Ticker const* t, Sort_key const& key) {
+                return order.before(t->ranked_key, key);
+            });
+        while (at != std::end(ranked_) && *at != &ticker)
+            ++at;  // Step over rows with an equal key.
+        if (at == std::end(ranked_))  // Out of order, search every row.
+            at = std::find(std::begin(ranked_), std::end(ranked_), &ticker);
+        return static_cast<std::size_t>(std::distance(std::begin(ranked_), at));
     }
 
-    /// Return Container view of all Ticker children that have the given quote.
-    [[nodiscard]] auto quote_ticker_view(std::string const& quote) const
+    /// Move \p ticker to its place in the sticky sort if its key changed.
+    void rerank(Ticker& ticker)
     {
-        return ox::Owning_filter_view{this->get_children(),
-                                      matches_quote(quote)};
+        if (!sort_.has_value())
+            return;
+        auto key = ticker.sort_key(sort_->column);
+        if (key == ticker.ranked_key)
+            return;
+        this->move_to_rank(this->rank_of(ticker), std::move(key));
     }
 
-    /// Get the Value column sum of all Tickers with \p quote_currency.
-    [[nodiscard]] auto value_sum(std::string const& quote_currency) const
-        -> double
+    /// Move the row at \p from to where \p key belongs among the other rows.
+    /** Binary searches ranked_, then shifts only the rows passed over. */
+    void move_to_rank(std::size_t from, Sort_key key)
     {
-        auto sum = 0.;
-        for (Ticker const& child : quote_ticker_view(quote_currency))
-            sum += child.listings.value.amount.as_double();
-        return sum;
+        auto const order = *sort_;
+        auto const begin = std::begin(ranked_);
+        auto const above = [order](Sort_key const& k, Ticker const* t) {
+            return order.before(k, t->ranked_key);
+        };
+        auto const below = [order](Ticker const* t, Sort_key const& k) {
+            return order.before(t->ranked_key, k);
+        };
+        auto const index = [begin](auto at) {
+            return static_cast<std::size_t>(std::distance(begin, at));
+        };
+        auto to = from;
+        if (from != 0 && above(key, ranked_[from - 1])) {
+            auto const first = std::next(begin, from);
+            to = index(std::upper_bound(begin, first, key, above));
+        }
+        else if (from + 1 != ranked_.size() && below(ranked_[from + 1], key)) {
+            auto const next = std::next(begin, from + 1);
+            auto const end  = std::end(ranked_);
+            to = index(std::lower_bound(next, end, key, below)) - 1;
+        }
+        ranked_[from]->ranked_key = std::move(key);
+        for (; from > to; --from) {
+            std::swap(ranked_[from], ranked_[from - 1]);
+            this->swap_children(from, from - 1);
+        }
+        for (; from < to; ++from) {
+            std::swap(ranked_[from], ranked_[from + 1]);
+            this->swap_children(from, from + 1);
+        }
     }
 
-    /// Get the Open P&L column sum of all Tickers with \p quote_currency.
-    [[nodiscard]] auto open_pl_sum(std::string const& quote_currency) const
-        -> double
+    /// Remove \p ticker from \p tickers.
+    static void erase_from(std::vector<Ticker*>& tickers, Ticker const* ticker)
     {
-        auto sum = 0.;
-        for (Ticker const& child : quote_ticker_view(quote_currency))
-            sum += child.listings.open_pl.amount.as_double();
-        return sum;
+        tickers.erase(
+            std::find(std::begin(tickers), std::end(tickers), ticker));
     }
 
-    /// Get the Daily P&L column sum of all Tickers with \p quote_currency.
-    [[nodiscard]] auto daily_pl_sum(std::string const& quote_currency) const
-        -> double
+    /// Remove \p ticker from the \p key bucket of \p index.
+    /** Drops the bucket once it is empty. */
+    template <typename Key_t>
+    static void erase_from(std::map<Key_t, std::vector<Ticker*>>& index,
+                           Key_t const& key,
+                           Ticker const* ticker)
     {
-        auto sum = 0.;
-        for (Ticker const& child : quote_ticker_view(quote_currency))
-            sum += child.listings.daily_pl.amount.as_double();
-        return sum;
+        auto const at = index.find(key);
+        erase_from(at->second, ticker);
+        if (at->second.empty())
+            index.erase(at);
+    }
+
+    /// Update everything derived from the quantity or cost basis of \p child.
+    void holding_edited(Ticker& child)
+    {
+        this->rerank(child);
+        this->emit_position(child.asset());
+        this->rebuild_totals(child.asset().currency.quote);
+        portfolio_changed.emit();
+    }
+
+    /// Emit position_changed with the sums over all Tickers of \p asset.
+    void emit_position(Asset const& asset)
+    {
+        auto quantity = 0.;
+        auto cost     = 0.;
+        for (Ticker const* child : this->asset_tickers(asset)) {
+            quantity += child->quantity();
+            cost += child->quantity() * child->cost_basis();
+        }
+        position_changed.emit(asset, quantity, cost);
+    }
+
+    /// Emit the running totals of the shown Tickers with \p quote.
+    void emit_totals(std::string const& quote)
+    {
+        auto const& totals = totals_[quote];
+        value_total_updated.emit(quote, totals.value);
+        open_pl_total_updated.emit(quote, totals.open_pl);
+        daily_pl_total_updated.emit(quote, totals.daily_pl);
+    }
+
+    /// Sum the shown Tickers with \p quote afresh, then emit the totals.
+    /** For changes to which rows are listed or shown, and to holdings, which
+     *  are rare. Price updates adjust the totals instead. */
+    void rebuild_totals(std::string const& quote)
+    {
+        auto totals = Position_totals{};
+        for (Ticker const* child : quote_tickers(quote)) {
+            if (!child->is_hidden())
+                book_.add_to(totals, child->position());
+        }
+        totals_[quote] = totals;
+        this->emit_totals(quote);
+    }
+
+    /// Return all Tickers with \p quote, from the index.
+    [[nodiscard]] auto quote_tickers(std::string const& quote) const
+        -> std::vector<Ticker*> const&
+    {
+        static auto const none = std::vector<Ticker*>{};
+        auto const at          = by_quote_.find(quote);
+        return at == std::end(by_quote_) ? none : at->second;
     }
 };
 
-class Column_labels : public ox::HArray<ox::HLabel, 20> {
+class Column_labels : public ox::HArray<ox::HLabel, 26> {
    public:
     ox::HLabel& buffer_1       = this->get<0>();
     ox::HLabel& base           = this->get<1>();
@@ -537,7 +1222,13 @@ class Column_labels : public ox::HArray<ox::HLabel, 20> {
     ox::HLabel& open_pl        = this->get<16>();
     ox::HLabel& buffer_8       = this->get<17>();
     ox::HLabel& daily_pl       = this->get<18>();
-    ox::HLabel& buffer         = this->get<19>();
+    ox::HLabel& buffer_9       = this->get<19>();
+    ox::HLabel& volume         = this->get<20>();
+    ox::HLabel& buffer_10      = this->get<21>();
+    ox::HLabel& vwap           = this->get<22>();
+    ox::HLabel& buffer_11      = this->get<23>();
+    ox::HLabel& trades         = this->get<24>();
+    ox::HLabel& buffer         = this->get<25>();
 
    public:
     Column_labels()
@@ -578,6 +1269,29 @@ class Column_labels : public ox::HArray<ox::HLabel, 20> {
         buffer_8 | fixed_width(1);
         daily_pl.set_text(U"Daily P&L" | ox::Trait::Bold);
         daily_pl | align_right() | fixed_width(14);
+        volume.set_text(U"Volume" | ox::Trait::Bold);
+        volume | align_right();
+        vwap.set_text(U" VWAP" | ox::Trait::Bold);
+        trades.set_text(U"Trades" | ox::Trait::Bold);
+        trades | align_right();
+        this->set_trade_widths(false);
+    }
+
+   public:
+    /// Show the labels of Listings::show_trade_columns().
+    void show_trade_columns() { this->set_trade_widths(true); }
+
+   private:
+    void set_trade_widths(bool shown)
+    {
+        using namespace ox::pipe;
+        auto const w = [shown](int width) { return shown ? width : 0; };
+        buffer_9 | fixed_width(w(1));
+        volume | fixed_width(w(14));
+        buffer_10 | fixed_width(w(2));
+        vwap | fixed_width(w(13));
+        buffer_11 | fixed_width(w(1));
+        trades | fixed_width(w(8));
     }
 };
 
@@ -0,0 +1,140 @@
+#include "timer_wheel.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace crab {
+
+Timer_wheel::Timer_wheel(Tick_t now) : now_{now} { heads_.fill(nil); }
+
+auto Timer_wheel::add(Tick_t due, Key_t key) -> Timer_id
+{
+    auto i = nil;
+    if (unused_.empty()) {
+        i = static_cast<std::uint32_t>(nodes_.size());
+        nodes_.push_back({0, 0, 0, nil, nil, nil});
+    }
+    else {
+        i = unused_.back();
+        unused_.pop_back();
+    }
+    auto& node = nodes_[i];
+    node.due   = std::max(due, now_ + 1);
+    node.key   = key;
+    this->place(i);
+    ++size_;
+    return {i, node.generation};
+}
+
+auto Timer_wheel::cancel(Timer_id id) -> bool
+{
+    if (id.index >= nodes_.size())
+        return false;
+    auto const& node = nodes_[id.index];
+    if (node.generation != id.generation || node.slot == nil)
+        return false;
+    this->unlink(id.index);
+    this->release(id.index);
+    --size_;
+    return true;
+}
+
+void Timer_wheel::advance(Tick_t now, std::vector<Key_t>& fired)
+{
+    while (now_ < now) {
+        // Skip the ticks with nothing to cascade or fire.
+        auto const event = this->next_event();
+        if (!event.has_value() || *event > now) {
+            now_ = now;
+            return;
+        }
+        now_ = *event;
+
+        // Highest level first, so its timers can cascade again on this tick.
+        for (auto level = levels - 1; level != 0; --level) {
+            auto const shift = bits * level;
+            if ((now_ & ((Tick_t{1} << shift) - 1)) != 0)
+                continue;
+            auto const slot = level * slots + ((now_ >> shift) & (slots - 1));
+            for (auto i = this->take(slot); i != nil;) {
+                auto const next = nodes_[i].next;
+                this->place(i);
+                i = next;
+            }
+        }
+        for (auto i = this->take(now_ & (slots - 1)); i != nil;) {
+            auto const next = nodes_[i].next;
+            fired.push_back(nodes_[i].key);
+            this->release(i);
+            --size_;
+            i = next;
+        }
+    }
+}
+
+auto Timer_wheel::next_event() const -> std::optional<Tick_t>
+{
+    auto result = std::optional<Tick_t>{};
+    for (auto level = 0u; level < levels; ++level) {
+        auto const shift   = bits * level;
+        auto const current = now_ >> shift;
+        for (auto k = Tick_t{1}; k <= slots; ++k) {
+            auto const slot = level * slots + ((current + k) & (slots - 1));
+            if (heads_[slot] == nil)
+                continue;
+            auto const tick = (current + k) << shift;
+            result          = std::min(result.value_or(tick), tick);
+            break;
+        }
+    }
+    return result;
+}
+
+void Timer_wheel::place(std::uint32_t i)
+{
+    auto& node       = nodes_[i];
+    auto const delta = node.due - now_;
+    auto level       = 0u;
+    while (level + 1 < levels && delta >= (Tick_t{1} << (bits * (level + 1))))
+        ++level;
+    auto const range = Tick_t{1} << (bits * levels);
+    auto const at    = delta < range ? node.due : now_ + range - 1;
+    auto const slot  = level * slots + ((at >> (bits * level)) & (slots - 1));
+    node.slot        = static_cast<std::uint32_t>(slot);
+    node.prev        = nil;
+    node.next        = heads_[slot];
+    if (node.next != nil)
+        nodes_[node.next].prev = i;
+    heads_[slot] = i;
+}
+
+void Timer_wheel::unlink(std::uint32_t i)
+{
+    auto& node = nodes_[i];
+    if (node.prev == nil)
+        heads_[node.slot] = node.next;
+    else
+        nodes_[node.prev].next = node.next;
+    if (node.next != nil)
+        nodes_[node.next].prev = node.prev;
+}
+
+void Timer_wheel::release(std::uint32_t i)
+{
+    auto& node = nodes_[i];
+    node.slot  = nil;
+    ++node.generation;
+    unused_.push_back(i);
+}
+
+auto Timer_wheel::take(std::size_t slot) -> std::uint32_t
+{
+    auto const head = heads_[slot];
+    heads_[slot]    = nil;
+    return head;
+}
+
+}  // namespace crab
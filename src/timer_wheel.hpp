@@ -0,0 +1,89 @@
+#ifndef CRAB_TIMER_WHEEL_HPP
+#define CRAB_TIMER_WHEEL_HPP
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace crab {
+
+/// Hierarchical timer wheel over integer ticks, holding a key per timer.
+/** Four levels of 64 slots each, a level's slot spans a full turn of the
+ *  level below it. Timers are kept in intrusive lists, so add and cancel are
+ *  O(1). A timer moves down a level each time its slot comes up until it fires
+ *  from the bottom level. Timers due past the top level wait in its last slot
+ *  and are placed again when it comes up. Not thread safe. */
+class Timer_wheel {
+   public:
+    using Tick_t = std::uint64_t;
+    using Key_t  = std::uint64_t;
+
+    /// Handle to a timer, no longer valid once the timer fires or is cancelled.
+    struct Timer_id {
+        std::uint32_t index;
+        std::uint32_t generation;
+    };
+
+   public:
+    explicit Timer_wheel(Tick_t now = 0);
+
+   public:
+    /// Fire \p key at tick \p due, or on the next tick if \p due has passed.
+    auto add(Tick_t due, Key_t key) -> Timer_id;
+
+    /// Remove the timer \p id, returns false if it has fired or was cancelled.
+    auto cancel(Timer_id id) -> bool;
+
+    /// Move the wheel to tick \p now, appending the key of each timer fired.
+    /** Keys are appended tick by tick, in no special order within a tick. */
+    void advance(Tick_t now, std::vector<Key_t>& fired);
+
+    /// Return the first tick where advance has work to do, if any.
+    /** The work is either firing timers or moving timers down a level, so
+     *  waiting until this tick never misses a timer. */
+    [[nodiscard]] auto next_event() const -> std::optional<Tick_t>;
+
+    [[nodiscard]] auto now() const -> Tick_t { return now_; }
+
+    /// Return the number of timers waiting to fire.
+    [[nodiscard]] auto size() const -> std::size_t { return size_; }
+
+   private:
+    static auto constexpr bits   = 6u;
+    static auto constexpr slots  = std::size_t{1} << bits;
+    static auto constexpr levels = 4u;
+    static auto constexpr nil    = std::numeric_limits<std::uint32_t>::max();
+
+    struct Node {
+        Tick_t due;
+        Key_t key;
+        std::uint32_t generation;
+        std::uint32_t prev;
+        std::uint32_t next;
+        std::uint32_t slot;  // Index into heads_, nil while unused.
+    };
+
+    std::vector<Node> nodes_;
+    std::vector<std::uint32_t> unused_;  // Indices into nodes_.
+    std::array<std::uint32_t, slots * levels> heads_;
+    Tick_t now_;
+    std::size_t size_ = 0;
+
+   private:
+    /// Link node \p i into the slot its due tick falls in, from now_.
+    void place(std::uint32_t i);
+
+    /// Unlink node \p i from its slot.
+    void unlink(std::uint32_t i);
+
+    /// Invalidate handles to node \p i and keep it for reuse.
+    void release(std::uint32_t i);
+
+    /// Unlink and return the list of nodes in \p slot.
+    auto take(std::size_t slot) -> std::uint32_t;
+};
+
+}  // namespace crab
+#endif  // CRAB_TIMER_WHEEL_HPP
@@ -0,0 +1,70 @@
+#include "trades_config.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include "filesystem.hpp"
+#include "log.hpp"
+#include "markets/trade_tracker.hpp"
+#include "parse_number.hpp"
+
+namespace {
+
+// trades.txt Format:
+// window 5m
+
+using Window_t = crab::Trade_tracker::Window_t;
+
+/// Parse a length like "90s", "5m" or "1h", std::nullopt if malformed.
+[[nodiscard]] auto parse_window(std::string const& x)
+    -> std::optional<Window_t>
+{
+    if (x.empty())
+        return std::nullopt;
+    auto const digits = std::string_view{x}.substr(0, x.size() - 1);
+    auto const n      = crab::parse_integer<long>(digits);
+    if (!n.has_value() || *n <= 0)
+        return std::nullopt;
+    switch (x.back()) {
+        case 's': return std::chrono::seconds{*n};
+        case 'm': return std::chrono::minutes{*n};
+        case 'h': return std::chrono::hours{*n};
+    }
+    return std::nullopt;
+}
+
+}  // namespace
+
+namespace crab {
+
+auto read_trade_window(fs::path const& filepath) -> std::optional<Window_t>
+{
+    if (!fs::exists(filepath))
+        return std::nullopt;
+    auto result = Trade_tracker{}.window();
+    auto file   = std::ifstream{filepath.string()};
+    auto line   = std::string{};
+    while (std::getline(file, line, '\n')) {
+        auto ss    = std::istringstream{line};
+        auto key   = std::string{};
+        auto value = std::string{};
+        if (!(ss >> key) || key.front() == '#')
+            continue;
+        auto const window = key == "window" && (ss >> value)
+                                ? parse_window(value)
+                                : std::nullopt;
+        if (!window.has_value()) {
+            log_error("trades.txt skipped malformed line: " + line);
+            continue;
+        }
+        result = *window;
+    }
+    return result;
+}
+
+}  // namespace crab
@@ -0,0 +1,18 @@
+#ifndef CRAB_TRADES_CONFIG_HPP
+#define CRAB_TRADES_CONFIG_HPP
+#include <optional>
+
+#include "filesystem.hpp"
+#include "markets/trade_tracker.hpp"
+
+namespace crab {
+
+/// Read the trade statistics window from the trades.txt file at \p filepath.
+/** Returns std::nullopt if the file does not exist, the trade columns are
+ *  then left hidden. A file without a window line gives the default window,
+ *  malformed lines are logged and skipped. */
+[[nodiscard]] auto read_trade_window(fs::path const& filepath)
+    -> std::optional<Trade_tracker::Window_t>;
+
+}  // namespace crab
+#endif  // CRAB_TRADES_CONFIG_HPP